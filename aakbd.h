@@ -67,6 +67,11 @@ uint8_t current_10ms_tick_count(void);
 #elif defined(__arm__)
 #include "_wait.h"
 
+#define delay_milliseconds(ms) wait_ms(ms)
+#define reset_watchdog_timer() do {} while (0)
+#elif defined(SIMULATOR)
+#include "_wait.h"
+
 #define delay_milliseconds(ms) wait_ms(ms)
 #define reset_watchdog_timer() do {} while (0)
 #elif !defined(TESTING)
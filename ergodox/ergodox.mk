@@ -12,7 +12,7 @@ DFU_TARGET = teensy
 include arch/avr/avr-common.mk
 include qmk_core/qmk_port.mk
 
-DEVICE_OBJS = ergodox_ez.o matrix.o $(QMK_CORE_OBJS) i2c_master.o
+DEVICE_OBJS = ergodox_ez.o matrix.o $(QMK_CORE_OBJS) i2c_master.o i2c_queue.o
 DEVICE_FLAGS += -DBOOTLOADER_HALFKAY -DBOOTLOADER_SIZE=512 -DENABLE_I2C=1
 ifeq (1,$(VIAL_ENABLE))
 DEVICE_FLAGS += -DGENERIC_HID_REPORT_SIZE=32 -DGENERIC_HID_FEATURE_SIZE=32
@@ -29,5 +29,5 @@ CONFIG_FLAGS ?= \
 $(BUILDDIR)/ergodox.o: led.h ergodox_ez.h usbkbd.h usbkbd_config.h usb_hardware.h keys.h
 $(BUILDDIR)/ergodox_ez.o: ergodox_ez.h i2c_master.h $(COMMON_HEADERS)
 $(BUILDDIR)/keymap.o: config.h device_keymap.h keymap.h ergodox_ez.h usb_keys.h
-$(BUILDDIR)/matrix.o: matrix.h debounce.h ergodox_ez.h $(COMMON_HEADERS)
+$(BUILDDIR)/matrix.o: matrix.h debounce.h ergodox_ez.h i2c_queue.h $(COMMON_HEADERS)
 $(BUILDDIR)/keys.o: device_keymap.h keymap.h ergodox_ez.h
@@ -129,8 +129,31 @@ void ergodox_blink_all_leds(void) {
     ergodox_led_all_off();
 }
 
+#ifdef LEFT_LEDS
+#    define LEFT_LED_1_SHIFT 7  // in MCP23018 port B
+#    define LEFT_LED_2_SHIFT 6  // in MCP23018 port B
+#    define LEFT_LED_3_SHIFT 7  // in MCP23018 port A
+
+/// The left LED state last written to the mcp23018 (OLATA, OLATB). The left
+/// row scan also writes OLATA, but keeps the LED 3 bit as it was (see
+/// `ergodox_left_rows_unselected`), so only the row bits can differ.
+static uint8_t left_leds_written[2];
+static bool    is_left_leds_written = false;
+#endif
+
+uint8_t ergodox_left_rows_unselected(void) {
+#ifdef LEFT_LEDS
+    return 0b11111111 & ~(ergodox_left_led_3 << LEFT_LED_3_SHIFT);
+#else
+    return 0b11111111;
+#endif
+}
+
 uint8_t init_mcp23018(void) {
     mcp23018_status = 0x20;
+#ifdef LEFT_LEDS
+    is_left_leds_written = false;
+#endif
 
     // I2C subsystem
 
@@ -175,18 +198,23 @@ uint8_t ergodox_left_leds_update(void) {
     if (mcp23018_status) {  // if there was an error
         return mcp23018_status;
     }
-#    define LEFT_LED_1_SHIFT 7  // in MCP23018 port B
-#    define LEFT_LED_2_SHIFT 6  // in MCP23018 port B
-#    define LEFT_LED_3_SHIFT 7  // in MCP23018 port A
-
     // set logical value (doesn't matter on inputs)
     // - unused  : hi-Z : 1
     // - input   : hi-Z : 1
     // - driving : hi-Z : 1
     uint8_t data[2];
-    data[0] = 0b11111111 & ~(ergodox_left_led_3 << LEFT_LED_3_SHIFT);
+    data[0] = ergodox_left_rows_unselected();
     data[1] = 0b11111111 & ~(ergodox_left_led_2 << LEFT_LED_2_SHIFT) & ~(ergodox_left_led_1 << LEFT_LED_1_SHIFT);
+    if (is_left_leds_written && data[0] == left_leds_written[0] && data[1] == left_leds_written[1]) {
+        // Unchanged, skip the blocking write (this is called on every scan)
+        return mcp23018_status;
+    }
     mcp23018_status = i2c_write_register(I2C_ADDR, OLATA, data, 2, ERGODOX_EZ_I2C_TIMEOUT);
+    if (!mcp23018_status) {
+        left_leds_written[0] = data[0];
+        left_leds_written[1] = data[1];
+        is_left_leds_written = true;
+    }
 
     return mcp23018_status;
 }
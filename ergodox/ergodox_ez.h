@@ -47,6 +47,9 @@ void init_ergodox(void);
 void ergodox_blink_all_leds(void);
 uint8_t init_mcp23018(void);
 uint8_t ergodox_left_leds_update(void);
+/// The value of the mcp23018 row port (GPIOA) with no row selected. Its bit 7
+/// drives left LED 3, so row selection must keep it.
+uint8_t ergodox_left_rows_unselected(void);
 
 #ifndef LED_BRIGHTNESS_LO
 #define LED_BRIGHTNESS_LO       15
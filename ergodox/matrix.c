@@ -33,6 +33,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "matrix.h"
 #include "debounce.h"
 #include "ergodox_ez.h"
+#include "i2c_queue.h"
 
 
 /*
@@ -58,9 +59,84 @@ static void         select_row(uint8_t row);
 
 static uint8_t mcp23018_reset_loop;
 
+/*
+ * Each left row is scanned with a single I2C transaction: select the row by
+ * writing GPIOA, then read GPIOB (the column port) after a repeated start,
+ * since in mcp23018's sequential mode it is addressed directly after GPIOA.
+ * The transactions for all left rows are queued at once, and run in the
+ * background while the right rows are scanned from the teensy.
+ */
+_Static_assert(MATRIX_ROWS_PER_SIDE <= I2C_QUEUE_SIZE, "I2C_QUEUE_SIZE is too small for the left rows");
+
+static uint8_t                left_row_select[MATRIX_ROWS_PER_SIDE][2];
+static uint8_t                left_row_cols[MATRIX_ROWS_PER_SIDE];
+static struct i2c_transaction left_row_scan[MATRIX_ROWS_PER_SIDE];
+
+static void init_left_row_scan(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS_PER_SIDE; row++) {
+        left_row_select[row][0] = GPIOA;
+
+        left_row_scan[row].address   = I2C_ADDR;
+        left_row_scan[row].tx_data   = left_row_select[row];
+        left_row_scan[row].tx_length = 2;
+        left_row_scan[row].rx_data   = &left_row_cols[row];
+        left_row_scan[row].rx_length = 1;
+    }
+}
+
+// Queues the scan of all left rows, returning whether they were queued.
+static bool queue_left_rows(void) {
+    if (mcp23018_status) {  // if there was an error
+        return false;
+    }
+    // The row select also writes left LED 3, so keep its current state
+    uint8_t unselected = ergodox_left_rows_unselected();
+    for (uint8_t row = 0; row < MATRIX_ROWS_PER_SIDE; row++) {
+        // set active row low  : 0
+        // set other rows hi-Z : 1
+        left_row_select[row][1] = unselected & ~(1 << row);
+    }
+    for (uint8_t row = 0; row < MATRIX_ROWS_PER_SIDE; row++) {
+        if (!i2c_queue_add(&left_row_scan[row])) {
+            // Don't leave the rows already queued running in the background,
+            // since the blocking I2C functions can't be used until they are
+            // done
+            (void) i2c_queue_wait(ERGODOX_EZ_I2C_TIMEOUT);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Waits for the queued left rows and stores them, returning
+// whether a change occurred.
+static bool store_left_rows(bool is_queued) {
+    if (is_queued) {
+        i2c_status_t status = i2c_queue_wait(ERGODOX_EZ_I2C_TIMEOUT);
+        if (status != I2C_STATUS_SUCCESS) {
+            mcp23018_status = status;
+        }
+    }
+
+    bool changed = false;
+    for (uint8_t row = 0; row < MATRIX_ROWS_PER_SIDE; row++) {
+        matrix_row_t temp = 0;
+        if (is_queued && left_row_scan[row].status == I2C_STATUS_SUCCESS) {
+            temp = 0x3F & ~left_row_cols[row];
+        }
+        if (raw_matrix[row] != temp) {
+            raw_matrix[row] = temp;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
 void matrix_init_custom(void) {
     // initialize row and col
 
+    init_left_row_scan();
+
     mcp23018_status = init_mcp23018();
 
     unselect_rows();
@@ -99,18 +175,17 @@ bool matrix_scan_custom(matrix_row_t current_matrix[]) {
     mcp23018_status = ergodox_left_leds_update();
 #endif  // LEFT_LEDS
     bool changed = false;
+    bool is_left_queued = queue_left_rows();
     for (uint8_t i = 0; i < MATRIX_ROWS_PER_SIDE; i++) {
-        // select rows from left and right hands
-        uint8_t left_index  = i;
+        // scan the right hand while the left hand is read over I2C
         uint8_t right_index = i + MATRIX_ROWS_PER_SIDE;
-        select_row(left_index);
         select_row(right_index);
 
-        changed |= store_raw_matrix_row(left_index);
         changed |= store_raw_matrix_row(right_index);
 
         unselect_rows();
     }
+    changed |= store_left_rows(is_left_queued);
 
     return changed;
 }
@@ -139,25 +214,15 @@ static void init_cols(void) {
 }
 
 static matrix_row_t read_cols(uint8_t row) {
-    if (row < 7) {
-        if (mcp23018_status) {  // if there was an error
-            return 0;
-        } else {
-            uint8_t data = 0;
-            // reading GPIOB (column port) since in mcp23018's sequential mode
-            // it is addressed directly after writing to GPIOA in select_row()
-            mcp23018_status = i2c_receive(I2C_ADDR, &data, 1, ERGODOX_EZ_I2C_TIMEOUT);
-            return ~data;
-        }
-    } else {
-        /* read from teensy
-         * bitmask is 0b11110011, but we want those all
-         * in the lower six bits.
-         * we'll return 1s for the top two, but that's harmless.
-         */
+    // the left rows (0-6) are read in store_left_rows()
 
-        return ~((PINF & 0x03) | ((PINF & 0xF0) >> 2));
-    }
+    /* read from teensy
+     * bitmask is 0b11110011, but we want those all
+     * in the lower six bits.
+     * we'll return 1s for the top two, but that's harmless.
+     */
+
+    return ~((PINF & 0x03) | ((PINF & 0xF0) >> 2));
 }
 
 /* Row pin configuration
@@ -187,14 +252,7 @@ static void unselect_rows(void) {
 
 static void select_row(uint8_t row) {
     if (row < 7) {
-        // select on mcp23018
-        if (!mcp23018_status) {
-            // set active row low  : 0
-            // set other rows hi-Z : 1
-            uint8_t data;
-            data = 0xFF & ~(1 << row);
-            mcp23018_status = i2c_write_register(I2C_ADDR, GPIOA, &data, 1, ERGODOX_EZ_I2C_TIMEOUT);
-        }
+        // the left rows are selected as part of left_row_scan
     } else {
         // select on teensy
         // Output low(DDR:1, PORT:0) to select
@@ -8,6 +8,7 @@ POWER_CONSUMPTION ?= 500
 DEBOUNCE_TYPE ?= asym_eager_defer_pk
 SIMULATED_TYPING ?= 1
 ENABLE_HOST_FINGERPRINT ?= 1
+MATRIX_TIMER_SCAN_US ?= 0
 
 VENDOR_ID ?= 0x320F
 PRODUCT_ID ?= 0x5044
@@ -24,10 +25,11 @@ CONFIG_FLAGS ?= \
 	-DMAX_POWER_CONSUMPTION_MA=$(POWER_CONSUMPTION)
 
 DEVICE_FLAGS += -DAW20216S_ENABLE -DENCODER_ENABLE -DRGB_MATRIX_ENABLE -DISO_LAYOUT=$(ISO_LAYOUT) -DBOOTMAGIC_ENABLE -DBOOTMAGIC_ROW=1 -DBOOTMAGIC_COLUMN=3 -DENABLE_BOOTLOADER_SHORTCUT=0
+DEVICE_FLAGS += -DMATRIX_TIMER_SCAN_US=$(MATRIX_TIMER_SCAN_US)
 
 MCU_FAMILY = stm32f3
 
-DEVICE_OBJS = matrix_gpio.o $(QMK_CORE_OBJS) aw20216s.o led_map.o encoder.o spi_master.o rgb_matrix.o gmmkpro1.o
+DEVICE_OBJS = matrix_gpio.o matrix_timer.o $(QMK_CORE_OBJS) aw20216s.o led_map.o encoder.o spi_master.o rgb_matrix.o gmmkpro1.o
 
 # Select Vial layout JSON based on ISO/ANSI variant (must be before qmk_port.mk)
 VIAL_JSON_FILE = $(DEVICE)/vial_$(if $(filter 1,$(ISO_LAYOUT)),iso,ansi).json
@@ -0,0 +1,133 @@
+/**
+ * key_trace.c: Ring buffer of key events and resulting report states.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.dev/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "key_trace.h"
+
+#if KEY_TRACE_SIZE > 0
+#include <string.h>
+
+#include "aakbd.h"
+
+#define KEY_TRACE_INDEX_MASK    (KEY_TRACE_SIZE - 1)
+
+static struct key_trace_event trace[KEY_TRACE_SIZE];
+
+/// Index of the next event to write.
+static uint8_t trace_head = 0;
+
+/// The number of events in the trace.
+static uint8_t trace_count = 0;
+
+/// The number of events read by `key_trace_read_next` since rewind.
+static uint8_t trace_read_count = 0;
+
+/// Set if events were discarded since the last clear.
+static bool trace_overflowed = false;
+
+/// Set while a dump is in progress, recording is paused.
+static bool trace_is_reading = false;
+
+__attribute__((weak)) uint16_t
+key_trace_timestamp_ms (void) {
+    return ((uint16_t) current_10ms_tick_count()) * 10U;
+}
+
+static struct key_trace_event *
+next_event (const uint8_t type) {
+    if (trace_is_reading) {
+        return NULL;
+    }
+    struct key_trace_event *event = &trace[trace_head];
+    trace_head = (trace_head + 1) & KEY_TRACE_INDEX_MASK;
+    if (trace_count < KEY_TRACE_SIZE) {
+        ++trace_count;
+    } else {
+        trace_overflowed = true;
+    }
+    event->time_ms = key_trace_timestamp_ms();
+    event->flags = type;
+    return event;
+}
+
+void
+key_trace_input (uint8_t key, bool is_release, uint8_t row, uint8_t col) {
+    struct key_trace_event *event = next_event(is_release ? KEY_TRACE_TYPE_RELEASE : KEY_TRACE_TYPE_PRESS);
+    if (event) {
+        event->input.key = key;
+        event->input.row = row;
+        event->input.col = col;
+    }
+}
+
+void
+key_trace_report (uint8_t mods, const uint8_t keys[static 1]) {
+    uint_fast8_t count = 0;
+    while (count < MAX_KEY_ROLLOVER && keys[count]) {
+        ++count;
+    }
+    struct key_trace_event *event = next_event(KEY_TRACE_TYPE_REPORT | ((count > 15 ? 15 : count) << KEY_TRACE_REPORT_COUNT_SHIFT));
+    if (event) {
+        event->report.mods = mods;
+        for (uint_fast8_t i = 0; i < KEY_TRACE_REPORT_KEYS; ++i) {
+            event->report.keys[i] = (i < count) ? keys[i] : 0;
+        }
+    }
+}
+
+void
+key_trace_clear (void) {
+    trace_head = 0;
+    trace_count = 0;
+    trace_read_count = 0;
+    trace_overflowed = false;
+    trace_is_reading = false;
+}
+
+uint8_t
+key_trace_count (void) {
+    return trace_count;
+}
+
+void
+key_trace_rewind (void) {
+    trace_read_count = 0;
+    trace_is_reading = false;
+}
+
+bool
+key_trace_read_next (uint8_t event[static KEY_TRACE_EVENT_SIZE]) {
+    if (!trace_is_reading && trace_read_count == 0 && trace_overflowed) {
+        // Start with a marker so that the host knows the trace is partial
+        trace_is_reading = true;
+        (void) memset(event, 0, KEY_TRACE_EVENT_SIZE);
+        event[2] = KEY_TRACE_TYPE_OVERFLOW;
+        return true;
+    }
+    if (trace_read_count >= trace_count) {
+        trace_is_reading = false;
+        return false;
+    }
+    trace_is_reading = true;
+    const uint8_t oldest = (trace_head - trace_count) & KEY_TRACE_INDEX_MASK;
+    const uint8_t index = (oldest + trace_read_count) & KEY_TRACE_INDEX_MASK;
+    ++trace_read_count;
+    (void) memcpy(event, &trace[index], KEY_TRACE_EVENT_SIZE);
+    return true;
+}
+
+#endif
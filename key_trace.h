@@ -0,0 +1,117 @@
+/**
+ * key_trace.h: Ring buffer of key events and resulting report states.
+ *
+ * This is a debugging aid for reproducing timing-sensitive bugs (e.g., in
+ * hold/tap keys, combos and tap dance). When enabled, every physical key
+ * event passed to `process_key` and every keyboard report state produced by
+ * it is recorded with a millisecond timestamp. The trace can be read over the
+ * generic HID endpoint and fed back through `keys.c` on the host with the
+ * replay runner in `vial/replay_trace.c`.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.dev/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef KK_KEY_TRACE_H
+#define KK_KEY_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usbkbd_config.h"
+
+/// The size of one trace event in bytes (both in RAM and over HID).
+#define KEY_TRACE_EVENT_SIZE            8
+
+/// The number of report keys stored per report event.
+#define KEY_TRACE_REPORT_KEYS           4
+
+/// Event type: physical key pressed (`key`, `row`, `col`).
+#define KEY_TRACE_TYPE_PRESS            0x01U
+/// Event type: physical key released (`key`, `row`, `col`).
+#define KEY_TRACE_TYPE_RELEASE          0x02U
+/// Event type: keyboard report state (`mods`, first keys in report).
+#define KEY_TRACE_TYPE_REPORT           0x03U
+/// Event type: the trace overflowed and older events were discarded.
+#define KEY_TRACE_TYPE_OVERFLOW         0x0FU
+
+/// Mask of the type in the `flags` byte. The upper nibble of a report event
+/// is the number of keys in the report (which may exceed the stored keys).
+#define KEY_TRACE_TYPE_MASK             0x0FU
+#define KEY_TRACE_REPORT_COUNT_SHIFT    4
+
+/// A single trace event. The layout is fixed since it is sent as-is over HID:
+/// bytes 0-1 are the timestamp in ms (little endian), byte 2 is the flags
+/// (type and report key count), and the remaining 5 bytes depend on the type.
+struct key_trace_event {
+    uint16_t time_ms;
+    uint8_t flags;
+    union {
+        struct {
+            uint8_t key;
+            uint8_t row;
+            uint8_t col;
+        } input;
+        struct {
+            uint8_t mods;
+            uint8_t keys[KEY_TRACE_REPORT_KEYS];
+        } report;
+    };
+};
+
+_Static_assert(sizeof(struct key_trace_event) == KEY_TRACE_EVENT_SIZE, "key_trace_event must be packed");
+
+#if KEY_TRACE_SIZE > 0
+
+#if (KEY_TRACE_SIZE & (KEY_TRACE_SIZE - 1)) != 0 || KEY_TRACE_SIZE > 128
+#error "KEY_TRACE_SIZE must be a power of two, at most 128."
+#endif
+
+/// Record a physical key event. Called from `process_key`.
+void key_trace_input(uint8_t key, bool is_release, uint8_t row, uint8_t col);
+
+/// Record the keyboard report state `mods` and `keys` (zero-terminated, at
+/// most `MAX_KEY_ROLLOVER` keys). Called when a report is about to be sent.
+void key_trace_report(uint8_t mods, const uint8_t keys[static 1]);
+
+/// Clear the trace and rewind the read position.
+void key_trace_clear(void);
+
+/// The number of events currently in the trace.
+uint8_t key_trace_count(void);
+
+/// Rewind the read position to the oldest event in the trace.
+void key_trace_rewind(void);
+
+/// Copy the next unread event (oldest first) to `event` and advance the
+/// read position. Returns `false` if there are no more events. Recording is
+/// paused while there are unread events after the first read, so that the
+/// trace is not modified mid-dump; `key_trace_clear()` or reading past the
+/// end resumes it.
+bool key_trace_read_next(uint8_t event[static KEY_TRACE_EVENT_SIZE]);
+
+/// The millisecond timestamp for trace events. The default implementation is
+/// based on `current_10ms_tick_count()`, but QMK-based keyboards override it
+/// with the 1 ms timer.
+uint16_t key_trace_timestamp_ms(void);
+
+#else // ^ KEY_TRACE_SIZE
+
+#define key_trace_input(key, is_release, row, col)  do { } while (0)
+#define key_trace_report(mods, keys)                do { } while (0)
+#define key_trace_clear()                           do { } while (0)
+
+#endif
+
+#endif
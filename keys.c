@@ -1065,7 +1065,7 @@ process_keycode (const uint8_t physical_key, keycode_t keycode, int8_t action, u
                             key = keylock_key;
                             keylock_key = 0;
                             if (key != physical_key) {
-                                process_key(key, true, row, col);
+                                process_keycode(key, PASS, RELEASE, row, col);
                             }
                         } else {
                             arm_keylock();
@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "keycodes.h"
+#include "key_trace.h"
 
 // Standard USB LED bits (from the host computer).
 #define LED_NUM_LOCK_BIT                (1 << 0)
@@ -79,6 +80,7 @@ void process_keycode(uint8_t physical_key, keycode_t keycode, int8_t action, uin
 /// On non-matrix keyboards, pass row=0, col=usbkey.
 static inline void
 process_key (uint8_t key, bool is_release, uint8_t row, uint8_t col) {
+    key_trace_input(key, is_release, row, col);
     process_keycode(key, PASS, is_release ? RELEASE : PRESS, row, col);
 }
 
@@ -102,6 +102,52 @@
 
 #define ps2_delay_us(us) _delay_us(us)
 
+#ifndef PS2_DEVICE_TIMER_NUM
+/// The 16-bit timer used for device mode transfers (if enabled).
+#define PS2_DEVICE_TIMER_NUM 1
+#endif
+
+#define PS2_DEVICE_TIMER_VECTOR PASTE(TIMER, PASTE(PS2_DEVICE_TIMER_NUM, _COMPA_vect))
+#define PS2_DEVICE_TIMER_TCCRA  PASTE(PASTE(TCCR, PS2_DEVICE_TIMER_NUM), A)
+#define PS2_DEVICE_TIMER_TCCRB  PASTE(PASTE(TCCR, PS2_DEVICE_TIMER_NUM), B)
+#define PS2_DEVICE_TIMER_TCNT   PASTE(TCNT, PS2_DEVICE_TIMER_NUM)
+#define PS2_DEVICE_TIMER_OCRA   PASTE(PASTE(OCR, PS2_DEVICE_TIMER_NUM), A)
+#define PS2_DEVICE_TIMER_TIMSK  PASTE(TIMSK, PS2_DEVICE_TIMER_NUM)
+#define PS2_DEVICE_TIMER_TIFR   PASTE(TIFR, PS2_DEVICE_TIMER_NUM)
+#define PS2_DEVICE_TIMER_OCIEA  PASTE(PASTE(OCIE, PS2_DEVICE_TIMER_NUM), A)
+#define PS2_DEVICE_TIMER_OCFA   PASTE(PASTE(OCF, PS2_DEVICE_TIMER_NUM), A)
+#define PS2_DEVICE_TIMER_WGM2   PASTE(PASTE(WGM, PS2_DEVICE_TIMER_NUM), 2)
+#define PS2_DEVICE_TIMER_CS1    PASTE(PASTE(CS, PS2_DEVICE_TIMER_NUM), 1)
+
+/// Timer ticks (with the prescaler of 8) for `us` microseconds.
+#define PS2_DEVICE_TIMER_TICKS(us) ((uint16_t) (((us) * (F_CPU / 1000000UL)) / 8U))
+
+/// Set the interval to the next compare interrupt. In CTC mode the counter
+/// is cleared on compare match, so when called from the interrupt handler,
+/// the interval is measured from the previous match, not the handler.
+#define ps2_device_timer_schedule(us) \
+    do { \
+        PS2_DEVICE_TIMER_OCRA = PS2_DEVICE_TIMER_TICKS(us) - 1; \
+    } while (0)
+
+/// Start the timer in CTC mode with the first compare after `us` µs.
+#define ps2_device_timer_start(us) \
+    do { \
+        PS2_DEVICE_TIMER_TCCRB = 0; \
+        PS2_DEVICE_TIMER_TCCRA = 0; \
+        PS2_DEVICE_TIMER_TCNT = 0; \
+        ps2_device_timer_schedule(us); \
+        PS2_DEVICE_TIMER_TIFR = _BV(PS2_DEVICE_TIMER_OCFA); \
+        PS2_DEVICE_TIMER_TIMSK |= _BV(PS2_DEVICE_TIMER_OCIEA); \
+        PS2_DEVICE_TIMER_TCCRB = _BV(PS2_DEVICE_TIMER_WGM2) | _BV(PS2_DEVICE_TIMER_CS1); \
+    } while (0)
+
+#define ps2_device_timer_stop() \
+    do { \
+        PS2_DEVICE_TIMER_TCCRB = 0; \
+        PS2_DEVICE_TIMER_TIMSK &= ~_BV(PS2_DEVICE_TIMER_OCIEA); \
+    } while (0)
+
 static inline void
 ps2_clk_set_low (void) {
     ps2_clk_set(0);
@@ -1,5 +1,5 @@
 /**
- * kk_ps2_device.c: PS/2 device-mode (delay-based) implementation.
+ * kk_ps2_device.c: PS/2 device-mode implementation.
  *
  * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.dev/
  *
@@ -9,6 +9,15 @@
  * controls the clock, so apart from the actual transfer of bytes (where we
  * disable interrupts), we have quite a lot of leeway in the timing.
  *
+ * Optionally (`ENABLE_PS2_DEVICE_TIMER`), both directions are transferred
+ * from a timer compare interrupt instead, one clock phase per interrupt, so
+ * that flushing the output only starts the transmission and the main loop can
+ * keep scanning the matrix while it is in flight. When the bus is otherwise
+ * idle, the same interrupt polls for host requests, and the received commands
+ * are queued until the main loop gets around to them. The typematic repeat of
+ * the held key is also sent from the interrupt, at the time it is due, so its
+ * rate doesn't depend on how busy the main loop is.
+ *
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -33,6 +42,10 @@
 #include "kk_ps2_avr.h"
 #include "usbkbd_config.h"
 
+#if ENABLE_PS2_DEVICE_TIMER
+#include <qmk_core/platforms/timer.h>
+#endif
+
 #include <stdio.h>
 
 // MARK:  Configuration
@@ -76,8 +89,9 @@ static uint8_t ps2_buffer[KK_PS2_BUFFER_SIZE];
 /// Output ring buffer head.
 static uint8_t ps2_buffer_head = 0;
 
-/// Output ring buffer tail.
-static uint8_t ps2_buffer_tail = 0;
+/// Output ring buffer tail. This is the byte being transmitted, and it is
+/// only advanced once the byte has been sent.
+static volatile uint8_t ps2_buffer_tail = 0;
 
 /// The number of elements in `ps2_buffer`.
 #define ps2_buffer_count ((uint8_t) (ps2_buffer_head - ps2_buffer_tail))
@@ -160,10 +174,18 @@ ps2_device_host_detected (void) {
     return are_ps2_lines_high();
 }
 
+#if ENABLE_PS2_DEVICE_TIMER
+static void ps2_device_timer_begin(void);
+static void ps2_device_timer_cancel(void);
+#endif
+
 void
 ps2_device_attach (void) {
     ps2_clk_release();
     ps2_data_release();
+#if ENABLE_PS2_DEVICE_TIMER
+    ps2_device_timer_begin();
+#endif
 #ifdef PS2_STATUS_PIN
 #error
     ps2_status_set_output();
@@ -173,6 +195,9 @@ ps2_device_attach (void) {
 
 void
 ps2_device_shutdown (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    ps2_device_timer_cancel();
+#endif
     ps2_data_set(0);
     ps2_data_set_input();
     ps2_clk_set(0);
@@ -197,6 +222,428 @@ ps2_clock_pulse (void) {
     ps2_clk_release();
 }
 
+// MARK: - Timer-Driven Transfer
+
+#if ENABLE_PS2_DEVICE_TIMER
+
+/// The interval (µs) of polling the bus for a host request-to-send (the host
+/// waits up to 15 ms for the device to start clocking).
+#ifndef PS2_RX_POLL_US
+#define PS2_RX_POLL_US 500
+#endif
+
+/// The interval (µs) of checking that the bus is idle before each byte.
+#define PS2_TX_IDLE_CHECK_US (PS2_BUS_IDLE_TIME_US / 2)
+
+/// The number of idle checks (after the first) required before each byte.
+/// The host inhibits for at least 100 µs, so it can't fit between checks.
+#define PS2_TX_IDLE_CHECKS (PS2_BUS_IDLE_TIME_US / PS2_TX_IDLE_CHECK_US)
+
+/// The number of bits in a frame: start, 8 data, parity, and stop.
+#define PS2_TX_FRAME_BITS 11
+
+/// The number of bits clocked in from the host after the start bit.
+#define PS2_RX_FRAME_BITS 10
+
+#ifndef KK_PS2_RX_BUFFER_SIZE
+/// The size of the queue of bytes received from the host. The host waits
+/// for a reply to each command, so this doesn't need to be large.
+#define KK_PS2_RX_BUFFER_SIZE 4
+#endif
+
+#if (256 % KK_PS2_RX_BUFFER_SIZE) != 0
+#error "KK_PS2_RX_BUFFER_SIZE must be a power of 2"
+#endif
+
+enum ps2_timer_phase {
+    PHASE_STOPPED = 0,
+    PHASE_POLL,
+    TX_PHASE_WAIT_IDLE,
+    TX_PHASE_DATA,
+    TX_PHASE_CLOCK_LOW,
+    TX_PHASE_CLOCK_HIGH,
+    RX_PHASE_START_BIT,
+    RX_PHASE_CLOCK_LOW,
+    RX_PHASE_CLOCK_HIGH,
+    RX_PHASE_ACK,
+    RX_PHASE_ACK_CLOCK_LOW,
+    RX_PHASE_ACK_CLOCK_HIGH,
+    RX_PHASE_ACK_DONE,
+};
+
+/// The phase to run on the next timer interrupt, `PHASE_STOPPED` if the
+/// timer is not running.
+static volatile uint8_t ps2_timer_phase = PHASE_STOPPED;
+
+/// The number of bits of the current frame transferred, or the number of
+/// idle checks done while waiting for the bus.
+static uint8_t ps2_timer_count = 0;
+
+/// The remaining bits of the current frame being sent, least significant
+/// first.
+static uint16_t ps2_tx_frame = 0;
+
+/// The byte being received.
+static uint8_t ps2_rx_byte = 0;
+
+/// The parity of the byte being received.
+static uint8_t ps2_rx_parity = 0;
+
+/// The bytes received from the host, read with `ps2_device_recv()`.
+static uint8_t ps2_rx_buffer[KK_PS2_RX_BUFFER_SIZE];
+
+/// Receive buffer head (written by the interrupt handler).
+static volatile uint8_t ps2_rx_head = 0;
+
+/// Receive buffer tail.
+static volatile uint8_t ps2_rx_tail = 0;
+
+/// The scancode repeated by the timer interrupt, or 0 if none.
+static volatile uint8_t ps2_repeat_scancode = 0;
+
+/// Does the repeated scancode have the `PS2_EXT_PREFIX`?
+static volatile bool ps2_repeat_is_extended = false;
+
+/// Is the repeat paused until the main loop has replied to a host command?
+static volatile bool ps2_repeat_is_paused = false;
+
+/// The `timer_read()` time when the next repeat is due.
+static volatile uint16_t ps2_repeat_due = 0;
+
+/// The time (ms) between repeats.
+static volatile uint16_t ps2_repeat_period = 0;
+
+/// The scancode of the repeat being sent (copied so that it may be stopped
+/// or changed mid-sequence without sending a partial one).
+static uint8_t ps2_repeat_tx_scancode = 0;
+
+/// The number of bytes of the current repeat left to send: 2 for the prefix
+/// and the scancode, 1 for the scancode, 0 if no repeat is being sent. These
+/// are sent before the output buffer, which is empty when a repeat starts.
+static volatile uint8_t ps2_repeat_tx_count = 0;
+
+/// Was the last byte sent part of a repeat (for `ps2_device_resend()`)?
+static bool ps2_repeat_was_last_tx = false;
+
+#define is_ps2_rx_buffer_empty (ps2_rx_head == ps2_rx_tail)
+#define is_ps2_rx_buffer_full ((uint8_t) (ps2_rx_head - ps2_rx_tail) == KK_PS2_RX_BUFFER_SIZE)
+#define modulo_rx_buffer_size(x) ((uint8_t) ((x) % (sizeof ps2_rx_buffer)))
+
+/// Is there a repeat or buffered output to send?
+#define has_ps2_tx_data (ps2_repeat_tx_count || !is_ps2_buffer_empty)
+
+/// The next byte to send.
+#define ps2_tx_next_byte() \
+    (ps2_repeat_tx_count == 2 ? PS2_EXT_PREFIX : \
+        ps2_repeat_tx_count ? ps2_repeat_tx_scancode : \
+        ps2_buffer[modulo_buffer_size(ps2_buffer_tail)])
+
+/// Is the host requesting to send (clock released, data pulled low)?
+#define is_ps2_host_request_to_send() (is_ps2_clk_high() && !ps2_data_read())
+
+/// Returns the frame for `data` (start bit, data, odd parity, stop bit).
+static uint16_t
+ps2_tx_frame_for_byte (uint8_t data) {
+    uint16_t frame = ((uint16_t) data << 1) | (1U << 10);
+    uint8_t parity = 1;
+    while (data) {
+        parity ^= (data & 1);
+        data >>= 1;
+    }
+    if (parity) {
+        frame |= (1U << 9);
+    }
+    return frame;
+}
+
+/// Start the timer, polling for host requests.
+static void
+ps2_device_timer_begin (void) {
+    ps2_repeat_scancode = 0;
+    ps2_repeat_tx_count = 0;
+    ps2_repeat_was_last_tx = false;
+    ps2_timer_phase = PHASE_POLL;
+    ps2_device_timer_start(PS2_RX_POLL_US);
+}
+
+static void
+ps2_device_timer_cancel (void) {
+    ps2_device_timer_stop();
+    ps2_timer_phase = PHASE_STOPPED;
+}
+
+/// Start receiving a byte from the host (the host is requesting to send).
+static inline void
+ps2_rx_begin (void) {
+    ps2_timer_count = 0;
+    ps2_rx_byte = 0;
+    ps2_rx_parity = 0;
+    ps2_timer_phase = RX_PHASE_START_BIT;
+    ps2_device_timer_schedule(DATA_SETUP_US);
+}
+
+/// Start the repeat if it is due. Called only when there is no other output,
+/// so that a repeat never splits a multi-byte sequence.
+static inline void
+ps2_repeat_begin_if_due (void) {
+    if (!ps2_repeat_scancode || ps2_repeat_is_paused) {
+        return;
+    }
+    const uint16_t now = timer_read();
+    if ((int16_t) (now - ps2_repeat_due) < 0) {
+        return;
+    }
+    // Schedule the next one from when this one was due, so the rate doesn't
+    // drift, but don't try to catch up after falling a whole period behind
+    ps2_repeat_due += ps2_repeat_period;
+    if ((int16_t) (now - ps2_repeat_due) >= 0) {
+        ps2_repeat_due = now + ps2_repeat_period;
+    }
+    ps2_repeat_tx_scancode = ps2_repeat_scancode;
+    ps2_repeat_tx_count = ps2_repeat_is_extended ? 2 : 1;
+}
+
+/// Start waiting for the bus to be idle before sending the next byte.
+static inline void
+ps2_tx_begin (void) {
+    ps2_timer_count = 0;
+    ps2_timer_phase = TX_PHASE_WAIT_IDLE;
+    ps2_device_timer_schedule(PS2_TX_IDLE_CHECK_US);
+}
+
+/// Transfer bytes in both directions, one clock phase per interrupt. When
+/// idle, the bus is polled for a host request-to-send, which has priority
+/// over output, and received bytes are queued. No output is sent while there
+/// are received bytes in the queue, since the host expects the reply to its
+/// command next. The timing of each byte is the same as with the delay-based
+/// transfer, but the clock high time needs no compensation for processing,
+/// since the timer keeps running. The typematic repeat is started when due
+/// by the poll, so it is accurate to within `PS2_RX_POLL_US` when the bus is
+/// otherwise idle.
+ISR(PS2_DEVICE_TIMER_VECTOR) {
+    switch (ps2_timer_phase) {
+    case PHASE_POLL:
+        if (is_ps2_host_request_to_send()) {
+            ps2_rx_begin();
+            return;
+        }
+        if (is_ps2_rx_buffer_empty && are_ps2_lines_high()) {
+            if (!has_ps2_tx_data) {
+                ps2_repeat_begin_if_due();
+            }
+            if (has_ps2_tx_data) {
+                ps2_tx_begin();
+                return;
+            }
+        }
+        break;
+
+    // Transmit
+
+    case TX_PHASE_WAIT_IDLE:
+        if (!are_ps2_lines_high()) {
+            // The host is inhibiting or about to send
+            if (is_ps2_host_request_to_send()) {
+                ps2_rx_begin();
+                return;
+            }
+            break;
+        }
+        if (!has_ps2_tx_data) {
+            // Output cleared
+            break;
+        }
+        if (++ps2_timer_count < PS2_TX_IDLE_CHECKS) {
+            ps2_device_timer_schedule(PS2_TX_IDLE_CHECK_US);
+            return;
+        }
+        ps2_tx_frame = ps2_tx_frame_for_byte(ps2_tx_next_byte());
+        ps2_timer_count = 0;
+        // fallthrough
+    case TX_PHASE_DATA:
+        if (ps2_timer_count == PS2_TX_FRAME_BITS) {
+            // Sent, even if the host inhibits after the stop bit
+            ps2_repeat_was_last_tx = (ps2_repeat_tx_count != 0);
+            if (ps2_repeat_was_last_tx) {
+                --ps2_repeat_tx_count;
+            } else {
+                ++ps2_buffer_tail;
+            }
+            if (!has_ps2_tx_data) {
+                break;
+            }
+            ps2_tx_begin();
+            return;
+        }
+        if (!is_ps2_clk_high()) {
+            // Host inhibit, the whole byte will be sent again
+            ps2_data_release();
+            ps2_device_error = PS2_ERROR_BUSY;
+            break;
+        }
+        ps2_data_set_value(ps2_tx_frame & 1);
+        ps2_tx_frame >>= 1;
+        ++ps2_timer_count;
+        ps2_timer_phase = TX_PHASE_CLOCK_LOW;
+        ps2_device_timer_schedule(DATA_SETUP_US);
+        return;
+    case TX_PHASE_CLOCK_LOW:
+        ps2_clk_set_low();
+        ps2_timer_phase = TX_PHASE_CLOCK_HIGH;
+        ps2_device_timer_schedule(CLOCK_PULSE_US);
+        return;
+    case TX_PHASE_CLOCK_HIGH:
+        ps2_clk_release();
+        ps2_timer_phase = TX_PHASE_DATA;
+        ps2_device_timer_schedule(CLOCK_PULSE_US - DATA_SETUP_US);
+        return;
+
+    // Receive
+
+    case RX_PHASE_START_BIT:
+        if (ps2_data_read()) {
+            // Data is high - the host was supposed to pull it low
+            ps2_device_error = PS2_ERROR_START_BIT;
+            break;
+        }
+        // fallthrough
+    case RX_PHASE_CLOCK_LOW:
+        if (!is_ps2_clk_high()) {
+            ps2_device_error = PS2_ERROR_BUSY;
+            break;
+        }
+        ps2_clk_set_low();
+        ps2_timer_phase = RX_PHASE_CLOCK_HIGH;
+        ps2_device_timer_schedule(CLOCK_PULSE_US);
+        return;
+    case RX_PHASE_CLOCK_HIGH: {
+        ps2_clk_release();
+        const uint8_t bit = ps2_data_read() ? 1 : 0;
+        if (++ps2_timer_count <= 8) {
+            // Data
+            ps2_rx_byte >>= 1;
+            if (bit) {
+                ps2_rx_byte |= 0x80;
+            }
+            ps2_rx_parity ^= bit;
+        } else if (ps2_timer_count == 9) {
+            // Parity
+            ps2_rx_parity ^= bit;
+        } else if (!bit) {
+            // Stop bit
+            ps2_device_error = PS2_ERROR_STOP_BIT;
+            break;
+        }
+        if (ps2_timer_count == PS2_RX_FRAME_BITS) {
+            ps2_timer_phase = RX_PHASE_ACK;
+            ps2_device_timer_schedule(CLOCK_PULSE_US - DATA_SETUP_US);
+        } else {
+            ps2_timer_phase = RX_PHASE_CLOCK_LOW;
+            ps2_device_timer_schedule(CLOCK_PULSE_US);
+        }
+        return;
+    }
+    case RX_PHASE_ACK:
+        if (!is_ps2_clk_high()) {
+            ps2_device_error = PS2_ERROR_BUSY;
+            break;
+        }
+        if (ps2_rx_parity == 0) {
+            ps2_device_error = PS2_ERROR_PARITY;
+            break;
+        }
+        ps2_data_set_low();
+        ps2_timer_phase = RX_PHASE_ACK_CLOCK_LOW;
+        ps2_device_timer_schedule(DATA_SETUP_US);
+        return;
+    case RX_PHASE_ACK_CLOCK_LOW:
+        ps2_clk_set_low();
+        ps2_timer_phase = RX_PHASE_ACK_CLOCK_HIGH;
+        ps2_device_timer_schedule(CLOCK_PULSE_US);
+        return;
+    case RX_PHASE_ACK_CLOCK_HIGH:
+        ps2_clk_release();
+        ps2_timer_phase = RX_PHASE_ACK_DONE;
+        ps2_device_timer_schedule(CLOCK_PULSE_US);
+        return;
+    case RX_PHASE_ACK_DONE:
+        ps2_data_release();
+        if (is_ps2_rx_buffer_full) {
+            ps2_device_error = PS2_ERROR_BUFFER_OVERFLOW;
+        } else {
+            ps2_rx_buffer[modulo_rx_buffer_size(ps2_rx_head)] = ps2_rx_byte;
+            ++ps2_rx_head;
+        }
+        break;
+
+    default:
+        ps2_device_timer_cancel();
+        return;
+    }
+
+    // Back to polling
+    ps2_timer_phase = PHASE_POLL;
+    ps2_device_timer_schedule(PS2_RX_POLL_US);
+}
+
+void
+ps2_device_resend (void) {
+    disable_interrupts();
+    if (ps2_timer_phase <= PHASE_POLL && !has_ps2_tx_data) {
+        if (ps2_repeat_was_last_tx) {
+            // The last transmitted byte was the repeated scancode
+            ps2_repeat_tx_count = 1;
+        } else {
+            // The last transmitted byte is still in the buffer before the tail
+            --ps2_buffer_tail;
+        }
+    }
+    enable_interrupts();
+    (void) ps2_device_flush();
+}
+
+int
+ps2_device_recv (void) {
+    if (is_ps2_rx_buffer_empty) {
+        return EOF;
+    }
+    // Pause before the byte leaves the queue, so that the interrupt can't
+    // send a repeat in place of the reply to it
+    ps2_repeat_is_paused = true;
+    const uint8_t data = ps2_rx_buffer[modulo_rx_buffer_size(ps2_rx_tail)];
+    ++ps2_rx_tail;
+    return data;
+}
+
+void
+ps2_device_start_repeat (
+    const uint8_t scancode, const bool is_extended, const uint16_t due_ms, const uint16_t period_ms) {
+    disable_interrupts();
+    ps2_repeat_scancode = scancode;
+    ps2_repeat_is_extended = is_extended;
+    ps2_repeat_due = due_ms;
+    ps2_repeat_period = period_ms;
+    ps2_repeat_is_paused = false;
+    enable_interrupts();
+}
+
+void
+ps2_device_resume_repeat (const uint16_t period_ms) {
+    disable_interrupts();
+    ps2_repeat_period = period_ms;
+    ps2_repeat_is_paused = false;
+    enable_interrupts();
+}
+
+void
+ps2_device_stop_repeat (void) {
+    ps2_repeat_scancode = 0;
+}
+
+#else // ENABLE_PS2_DEVICE_TIMER
+
+// MARK: - Transmit
+
 /// Pulse the clock for transmission, delay after, then check for inhibit.
 /// The delay after the pulse assumes a `DATA_SETUP_US` delay before the
 /// next pulse.
@@ -237,8 +684,6 @@ ps2_wait_idle (uint8_t timeout_us) {
     return false;
 }
 
-// MARK: - Transmit
-
 /// Send one bit out (setup data, wait, pulse clock).
 /// Returns `false` from _caller_ (because this is a macro) on clock inhibit.
 #define PS2_DEVICE_TX_BIT(bit) \
@@ -288,6 +733,7 @@ ps2_device_tx_byte (const uint8_t data) {
     disable_interrupts();
     if (!are_ps2_lines_high()) {
         // Host inhibiting, maybe there was an interrupt after idle wait
+        enable_interrupts();
         return false;
     }
     const bool is_success = ps2_device_tx_byte_atomic(data);
@@ -384,6 +830,7 @@ ps2_device_recv (void) {
     disable_interrupts();
     if (is_ps2_clk_low()) {
         // Host is still inhibiting, wait until next main loop iteration
+        enable_interrupts();
         return EOF;
     }
     const int result = ps2_device_recv_atomic();
@@ -392,6 +839,8 @@ ps2_device_recv (void) {
     return result;
 }
 
+#endif // ENABLE_PS2_DEVICE_TIMER
+
 // MARK: - Output Queue
 
 bool
@@ -405,6 +854,39 @@ ps2_device_send (const uint8_t data) {
     return true;
 }
 
+#if ENABLE_PS2_DEVICE_TIMER
+bool
+ps2_device_flush (void) {
+    if (!has_ps2_tx_data) {
+        return true;
+    }
+    disable_interrupts();
+    if (ps2_timer_phase == PHASE_POLL && is_ps2_rx_buffer_empty && are_ps2_lines_high()) {
+        // Start now instead of at the next poll
+        ps2_timer_count = 0;
+        ps2_timer_phase = TX_PHASE_WAIT_IDLE;
+        ps2_device_timer_start(PS2_TX_IDLE_CHECK_US);
+    }
+    enable_interrupts();
+    return false;
+}
+
+void
+ps2_device_clear_output (void) {
+    disable_interrupts();
+    ps2_buffer_head = ps2_buffer_tail;
+    if (ps2_timer_phase >= TX_PHASE_DATA && ps2_timer_phase <= TX_PHASE_CLOCK_HIGH) {
+        // Let the byte in flight finish, it can't be cancelled cleanly (and
+        // a repeat in flight is finished whole, it is at most two bytes)
+        if (!ps2_repeat_tx_count) {
+            ++ps2_buffer_head;
+        }
+    } else {
+        ps2_repeat_tx_count = 0;
+    }
+    enable_interrupts();
+}
+#else
 bool
 ps2_device_flush (void) {
     while (!is_ps2_buffer_empty) {
@@ -422,12 +904,18 @@ void
 ps2_device_clear_output (void) {
     ps2_buffer_head = ps2_buffer_tail;
 }
+#endif
 
 bool
 ps2_device_has_pending_output (void) {
     return !is_ps2_buffer_empty;
 }
 
+uint16_t
+ps2_device_output_space (void) {
+    return KK_PS2_BUFFER_SIZE - ps2_buffer_count;
+}
+
 // MARK: - External queries
 
 char
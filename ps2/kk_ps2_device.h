@@ -47,23 +47,50 @@ bool ps2_device_send(uint8_t data);
 /// Receive a byte from the host as a PS/2 device. Blocks until
 /// received, generates the clock signal. Returns the byte, or
 /// `EOF` on error or timeout.
+///
+/// With `ENABLE_PS2_DEVICE_TIMER`, the bytes are received in the background
+/// and this only returns the next queued byte, or `EOF` if there is none.
 int ps2_device_recv(void);
 
 /// Flush any queued output bytes by sending them to the host.
 /// Returns `true` if all queued bytes were successfully sent.
+///
+/// With `ENABLE_PS2_DEVICE_TIMER`, this only starts sending the queued
+/// bytes in the background (unless already sending), and returns `false`
+/// until all of them have been sent.
 bool ps2_device_flush(void);
 
 /// Is there unsent uotput in the buffer?
 bool ps2_device_has_pending_output(void);
 
-/// Resend the last transmitted byte. Does not check for buffer overflow,
+/// Return the number of bytes that can still be queued with
+/// `ps2_device_send()` before the output buffer is full.
+uint16_t ps2_device_output_space(void);
+
+/// Resend the last transmitted byte (in the background with
+/// `ENABLE_PS2_DEVICE_TIMER`). Does not check for buffer overflow,
 /// so in theory might send incorrect bytes, but with regular flushing that
 /// should not happen.
 void ps2_device_resend(void);
 
-/// Discard any queued output bytes without sending them.
+/// Discard any queued output bytes without sending them. A byte that is
+/// already partially sent in the background is finished.
 void ps2_device_clear_output(void);
 
+/// Start repeating `scancode` (with the `PS2_EXT_PREFIX` if `is_extended`)
+/// from the timer interrupt, first at the `timer_read()` time `due_ms`, then
+/// every `period_ms`. The repeat is sent only when there is no other output,
+/// and it is paused whenever a byte is received from the host, until
+/// resumed with `ps2_device_resume_repeat()` after replying.
+/// Only available with `ENABLE_PS2_DEVICE_TIMER`.
+void ps2_device_start_repeat(uint8_t scancode, bool is_extended, uint16_t due_ms, uint16_t period_ms);
+
+/// Resume a paused repeat, and change its period to `period_ms`.
+void ps2_device_resume_repeat(uint16_t period_ms);
+
+/// Stop repeating. A repeat that has already started is sent whole.
+void ps2_device_stop_repeat(void);
+
 /// Return the last error character (printable). This is only for debugging.
 /// Note that the error is _not_ cleared automatically (because otherwise
 /// other successes would hide past errors, as this is not meant to be polled
@@ -215,6 +215,27 @@ setup_recv_bits (uint8_t byte) {
     } while (0)
 #define ps2_delay_us(u) _delay_us(u)
 
+// Mock device timer (ENABLE_PS2_DEVICE_TIMER): the interrupt handler is a
+// plain function, called by `run_timer_tick()` at the scheduled times.
+static bool mock_timer_on = false;
+static unsigned long mock_timer_due = 0;
+
+#define ISR(vector)             void vector(void)
+#define PS2_DEVICE_TIMER_VECTOR mock_timer_isr
+#define ps2_device_timer_schedule(u) \
+    do { \
+        mock_timer_due = now_us + (u); \
+    } while (0)
+#define ps2_device_timer_start(u) \
+    do { \
+        mock_timer_on = true; \
+        ps2_device_timer_schedule(u); \
+    } while (0)
+#define ps2_device_timer_stop() \
+    do { \
+        mock_timer_on = false; \
+    } while (0)
+
 // Do NOT define PS2_STATUS_PIN or PS2_ENABLE_PIN — the device code
 // uses #ifdef to conditionally compile status/enable pin code.
 // Keeping them undefined skips those code paths.
@@ -227,8 +248,121 @@ setup_recv_bits (uint8_t byte) {
 
 #include "kk_ps2_device.c"
 
+uint16_t
+timer_read (void) {
+    return (uint16_t) (now_us / 1000);
+}
+
 static int verbose = 0, tests_run = 0, tests_failed = 0;
 
+#if ENABLE_PS2_DEVICE_TIMER
+/// Advance the mock clock to the next timer interrupt and run it.
+static void
+run_timer_tick (void) {
+    if (mock_timer_due > now_us) {
+        _delay_us(mock_timer_due - now_us);
+    }
+    mock_timer_isr();
+}
+
+/// Is the timer only polling with nothing to do until the bus changes?
+static bool
+is_timer_idle (void) {
+    if (!mock_timer_on) {
+        return true;
+    }
+    if (ps2_timer_phase != PHASE_POLL || (is_ps2_clk_high() && !pin_data)) {
+        return false;
+    }
+    return !has_ps2_tx_data || !is_ps2_rx_buffer_empty || !are_ps2_lines_high();
+}
+
+/// Run the timer for `us` microseconds.
+static void
+run_timer_for (unsigned long us) {
+    const unsigned long end = now_us + us;
+    while (mock_timer_on && mock_timer_due <= end) {
+        run_timer_tick();
+    }
+    if (now_us < end) {
+        _delay_us(end - now_us);
+    }
+}
+
+/// Return the time of the first clock pulse of the sent frame `n`.
+static unsigned long
+sent_frame_time (int n) {
+    int pulses = 0;
+    for (int i = 0; i < edge_n; i++) {
+        if (strstr(edges[i].label, "CLK↓") && pulses++ == n * 11) {
+            return edges[i].t;
+        }
+    }
+    return 0;
+}
+
+/// Run the timer until it is idle, or until `max_edges` are logged.
+static void
+run_timer_until (int max_edges) {
+    int ticks = 0;
+    while (!is_timer_idle() && edge_n < max_edges && ++ticks < 10000) {
+        run_timer_tick();
+    }
+}
+#endif
+
+/// Flush the output and wait for it to be sent, like the blocking flush.
+static bool
+flush_output (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    if (!ps2_device_flush()) {
+        run_timer_until(MAX_EDGES);
+    }
+#endif
+    return ps2_device_flush();
+}
+
+/// Receive a byte, like the blocking receive.
+static int
+recv_byte (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    if (is_ps2_rx_buffer_empty) {
+        // Let the next poll see the current state of the bus
+        run_timer_tick();
+        run_timer_until(MAX_EDGES);
+    }
+#endif
+    return ps2_device_recv();
+}
+
+/// Decode the bytes sent by the device from the logged edges (data is read
+/// by the host on the falling clock edge). Returns the number of bytes, or
+/// -1 on a framing or parity error.
+static int
+decode_sent (uint8_t *bytes, int max_bytes) {
+    int n = 0, bit = 0;
+    unsigned frame = 0;
+    for (int i = 0; i < edge_n; i++) {
+        if (!strstr(edges[i].label, "CLK↓")) {
+            continue;
+        }
+        frame |= (edges[i].data ? 1U : 0U) << bit;
+        if (++bit == 11) {
+            unsigned ones = 0;
+            for (int b = 1; b <= 9; b++) {
+                ones += (frame >> b) & 1;
+            }
+            if ((frame & 1) || !(frame & (1U << 10)) || !(ones & 1) || n == max_bytes) {
+                return -1;
+            }
+            bytes[n++] = (uint8_t) (frame >> 1);
+            frame = 0;
+            bit = 0;
+        }
+    }
+    return bit ? -1 : n;
+}
+
 static void
 reset (void) {
     now_us = 0;
@@ -246,6 +380,16 @@ reset (void) {
     host_inhibit_after = 0;
     inhibit_after_pulse = 0;
     send_clock_count = 0;
+    mock_timer_on = false;
+    mock_timer_due = 0;
+#if ENABLE_PS2_DEVICE_TIMER
+    ps2_rx_head = 0;
+    ps2_rx_tail = 0;
+    ps2_repeat_is_paused = false;
+    ps2_device_attach();
+    edge_n = 0;
+    send_clock_count = 0;
+#endif
 }
 
 static void
@@ -264,7 +408,7 @@ test_send_byte (void) {
     reset();
     check(ps2_device_send(0xFA), "queue");
     unsigned long t0 = now_us;
-    check(ps2_device_flush(), "flush");
+    check(flush_output(), "flush");
     check(ps2_buffer_head == ps2_buffer_tail, "drained");
     check(now_us - t0 > 600, "send takes time");
     int clk = 0;
@@ -288,7 +432,7 @@ test_send_with_host_inhibit_after_stop (void) {
     reset();
     inhibit_after_pulse = 11; // inhibit after stop bit's clock rise
     check(ps2_device_send(0xFA), "queue");
-    check(ps2_device_flush(), "flush succeeds despite host inhibit");
+    check(flush_output(), "flush succeeds despite host inhibit");
     check(ps2_buffer_head == ps2_buffer_tail, "byte sent despite inhibit");
 }
 
@@ -301,6 +445,111 @@ test_send_overflow (void) {
     check(!ps2_device_send(0x55), "overflow");
 }
 
+static void
+test_send_sequence (void) {
+    reset();
+    check(ps2_device_send(0xE0), "queue 1");
+    check(ps2_device_send(0xF0), "queue 2");
+    check(ps2_device_send(0x14), "queue 3");
+    check(flush_output(), "flush");
+    uint8_t bytes[4];
+    check(decode_sent(bytes, 4) == 3, "3 bytes sent");
+    check(bytes[0] == 0xE0 && bytes[1] == 0xF0 && bytes[2] == 0x14, "bytes in order");
+    check(!ps2_device_has_pending_output(), "drained");
+}
+
+static void
+test_send_with_host_inhibit_mid_byte (void) {
+    reset();
+    inhibit_after_pulse = 5;
+    check(ps2_device_send(0xAA), "queue");
+    check(!flush_output(), "flush fails on host inhibit");
+    check(ps2_device_has_pending_output(), "byte kept for retransmit");
+    check(ps2_device_last_error() == PS2_ERROR_BUSY, "busy error");
+    check(pin_data, "data released");
+
+    pin_clk = true;
+    edge_n = 0;
+    now_us += 100;
+    check(flush_output(), "flush after inhibit");
+    uint8_t bytes[2];
+    check(decode_sent(bytes, 2) == 1 && bytes[0] == 0xAA, "whole byte sent again");
+}
+
+static void
+test_resend (void) {
+    reset();
+    check(ps2_device_send(0xFA), "queue");
+    check(flush_output(), "flush");
+    edge_n = 0;
+    ps2_device_clear_output();
+    ps2_device_resend();
+    check(flush_output(), "flush resend");
+    uint8_t bytes[2];
+    check(decode_sent(bytes, 2) == 1 && bytes[0] == 0xFA, "last byte resent");
+}
+
+static void
+test_timer_flush_does_not_block (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    reset();
+    check(ps2_device_send(0xFA), "queue");
+    unsigned long t0 = now_us;
+    check(!ps2_device_flush(), "flush returns before sent");
+    check(now_us == t0, "flush does not wait");
+    check(mock_timer_on, "timer started");
+    run_timer_until(4);
+    check(ps2_device_has_pending_output(), "in flight");
+    check(ps2_device_recv() == EOF, "no receive while sending");
+    check(!ps2_device_flush(), "flush while in flight");
+    run_timer_until(MAX_EDGES);
+    check(ps2_timer_phase == PHASE_POLL, "back to polling");
+    check(ps2_device_flush(), "flushed");
+    uint8_t bytes[2];
+    check(decode_sent(bytes, 2) == 1 && bytes[0] == 0xFA, "byte sent");
+#endif
+}
+
+static void
+test_timer_send_while_in_flight (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    reset();
+    check(ps2_device_send(0x12), "queue 1");
+    (void) ps2_device_flush();
+    run_timer_until(10);
+    check(ps2_device_send(0x34), "queue 2 while sending");
+    (void) ps2_device_flush();
+    run_timer_until(MAX_EDGES);
+    uint8_t bytes[3];
+    check(decode_sent(bytes, 3) == 2 && bytes[0] == 0x12 && bytes[1] == 0x34, "both sent");
+    check(!ps2_device_has_pending_output(), "drained");
+#endif
+}
+
+static void
+test_timer_clear_output_finishes_byte (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    reset();
+    check(ps2_device_send(0x12), "queue 1");
+    check(ps2_device_send(0x34), "queue 2");
+    (void) ps2_device_flush();
+    run_timer_until(4);
+    ps2_device_clear_output();
+    run_timer_until(MAX_EDGES);
+    uint8_t bytes[3];
+    check(decode_sent(bytes, 3) == 1 && bytes[0] == 0x12, "only the byte in flight sent");
+    check(!ps2_device_has_pending_output(), "cleared");
+
+    reset();
+    check(ps2_device_send(0x12), "queue before start");
+    (void) ps2_device_flush();
+    ps2_device_clear_output();
+    run_timer_until(MAX_EDGES);
+    check(edge_n == 0, "cleared before start bit");
+    check(ps2_timer_phase == PHASE_POLL, "back to polling");
+#endif
+}
+
 static void
 host_start (void) {
     pin_clk = false;
@@ -314,7 +563,7 @@ do_recv (uint8_t byte) {
     reset();
     setup_recv_bits(byte);
     host_start();
-    return ps2_device_recv();
+    return recv_byte();
 }
 
 static void
@@ -357,21 +606,155 @@ test_recv_start_err (void) {
     now_us += 160;
     pin_data = true;
     pin_clk = true;
-    check(ps2_device_recv() == EOF, "start error");
+    check(recv_byte() == EOF, "start error");
 }
 
 static void
 test_recv_inhibit (void) {
     reset();
     pin_clk = false;
-    check(ps2_device_recv() == EOF, "inhibit timeout");
+    check(recv_byte() == EOF, "inhibit timeout");
+}
+
+static void
+test_timer_recv_queues_bytes (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    reset();
+    setup_recv_bits(0xED);
+    host_start();
+    run_timer_tick();
+    run_timer_until(MAX_EDGES);
+    setup_recv_bits(0x02);
+    host_start();
+    run_timer_tick();
+    run_timer_until(MAX_EDGES);
+    check(ps2_device_recv() == 0xED, "first byte queued");
+    check(ps2_device_recv() == 0x02, "second byte queued");
+    check(ps2_device_recv() == EOF, "queue empty");
+#endif
+}
+
+static void
+test_timer_recv_parity_error (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    reset();
+    setup_recv_bits(0x55);
+    mock_bit_data[8] ^= 1;
+    host_start();
+    check(recv_byte() == EOF, "nothing received");
+    check(ps2_device_last_error() == PS2_ERROR_PARITY, "parity error");
+    bool acked = false;
+    for (int i = 0; i < edge_n; i++) {
+        if (strstr(edges[i].label, "DATA↓")) {
+            acked = true;
+        }
+    }
+    check(!acked, "no ack");
+    check(ps2_timer_phase == PHASE_POLL, "back to polling");
+#endif
+}
+
+static void
+test_timer_recv_command_before_output (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    reset();
+    pin_clk = false; // host inhibit
+    check(ps2_device_send(0x12), "queue");
+    check(!ps2_device_flush(), "can't flush while inhibited");
+    run_timer_tick();
+    setup_recv_bits(0xEE);
+    host_start();
+    run_timer_until(MAX_EDGES);
+    run_timer_tick();
+    run_timer_until(MAX_EDGES);
+    check(ps2_device_has_pending_output(), "output held while command unread");
+    check(ps2_device_recv() == 0xEE, "command received");
+    ps2_device_clear_output();
+    edge_n = 0;
+    check(ps2_device_send(0xEE), "queue reply");
+    check(flush_output(), "reply sent");
+    uint8_t bytes[2];
+    check(decode_sent(bytes, 2) == 1 && bytes[0] == 0xEE, "only the reply sent");
+#endif
+}
+
+static void
+test_timer_repeat_on_schedule (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    reset();
+    ps2_device_start_repeat(0x1C, false, 10, 100);
+    run_timer_for(9000);
+    check(edge_n == 0, "nothing before due");
+    run_timer_for(502000);
+    uint8_t bytes[8];
+    const int n = decode_sent(bytes, 8);
+    check(n == 6, "repeated every period");
+    bool on_time = true;
+    for (int i = 0; i < n; i++) {
+        const unsigned long due = (10 + 100UL * i) * 1000;
+        const unsigned long t = sent_frame_time(i);
+        on_time = on_time && bytes[i] == 0x1C && t >= due && t < due + PS2_RX_POLL_US + 100;
+    }
+    check(on_time, "each repeat within one poll of due");
+    check(ps2_device_flush(), "no output left");
+
+    ps2_device_stop_repeat();
+    edge_n = 0;
+    run_timer_for(300000);
+    check(edge_n == 0, "stopped");
+#endif
+}
+
+static void
+test_timer_repeat_extended_after_output (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    reset();
+    ps2_device_start_repeat(0x74, true, 0, 100);
+    check(ps2_device_send(0xF0), "queue 1");
+    check(ps2_device_send(0x12), "queue 2");
+    run_timer_for(5000);
+    uint8_t bytes[6];
+    check(decode_sent(bytes, 6) == 4 && bytes[0] == 0xF0 && bytes[1] == 0x12
+              && bytes[2] == PS2_EXT_PREFIX && bytes[3] == 0x74,
+        "output first, then the whole repeat");
+    check(!ps2_device_has_pending_output(), "drained");
+
+    edge_n = 0;
+    ps2_device_resend();
+    run_timer_until(MAX_EDGES);
+    check(decode_sent(bytes, 6) == 1 && bytes[0] == 0x74, "repeated scancode resent");
+#endif
+}
+
+static void
+test_timer_repeat_paused_by_command (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    reset();
+    ps2_device_start_repeat(0x1C, false, 200, 100);
+    setup_recv_bits(0xED);
+    host_start();
+    run_timer_tick();
+    run_timer_until(MAX_EDGES);
+    check(ps2_device_recv() == 0xED, "command received");
+    edge_n = 0;
+    run_timer_for(400000);
+    check(edge_n == 0, "no repeat before reply");
+    check(ps2_device_send(0xFA), "queue reply");
+    ps2_device_resume_repeat(50);
+    run_timer_for(60000);
+    uint8_t bytes[4];
+    check(decode_sent(bytes, 4) == 3 && bytes[0] == 0xFA && bytes[1] == 0x1C && bytes[2] == 0x1C,
+        "reply, then the late repeat");
+    const unsigned long interval = sent_frame_time(2) - sent_frame_time(1);
+    check(interval > 49000 && interval < 51000, "resynced to the new period instead of a burst");
+#endif
 }
 
 static void
 test_timing_send (void) {
     reset();
     ps2_device_send(0x55);
-    ps2_device_flush();
+    (void) flush_output();
     int bad_lo = 0, bad_asym = 0, bad_setup = 0, pulses = 0;
     unsigned long ft = 0, rt = 0, last_lo = 0, last_data_t = 0;
     int n_bad_asym = 0, pulse_bad = 0;
@@ -471,7 +854,7 @@ static void
 test_verbose_send (void) {
     reset();
     ps2_device_send(0x5A);
-    ps2_device_flush();
+    (void) flush_output();
     if (verbose) {
         printf("SEND 0x5A — %d edges:\n", edge_n);
         unsigned long ft = 0, rt = 0;
@@ -62,21 +62,34 @@ static volatile uint8_t ps2_data_byte = 0;
 static volatile char ps2_error = 0;
 
 #ifndef KK_PS2_BUFFER_SIZE
+/// The size of the receive buffer in bytes, a power of 2 (max. 256). One
+/// byte of it is always left unused.
 #define KK_PS2_BUFFER_SIZE 256
 #endif
 
+#if KK_PS2_BUFFER_SIZE > 256
+#error "KK_PS2_BUFFER_SIZE must be <= 256"
+#endif
+#if KK_PS2_BUFFER_SIZE < 2 || (256 % KK_PS2_BUFFER_SIZE) != 0
+#error "KK_PS2_BUFFER_SIZE must be a power of 2"
+#endif
+
 static uint8_t ps2_buffer[KK_PS2_BUFFER_SIZE];
 static volatile uint8_t ps2_buffer_tail = 0;
 static volatile uint8_t ps2_buffer_head = 0;
 
-#define buffer_size ((unsigned int) (sizeof ps2_buffer))
+/// Set when a received byte was dropped because the buffer was full. No
+/// further bytes are stored until the input is flushed, so the bytes in the
+/// buffer are exactly those received before the loss.
+static volatile bool ps2_buffer_overflowed = false;
+
+/// The number of times the buffer has overflowed (saturating).
+static volatile uint8_t ps2_buffer_overflow_count = 0;
 
 #if KK_PS2_BUFFER_SIZE == 256
 #define modulo_buffer_size(x) ((uint8_t) (x))
-#elif KK_PS2_BUFFER_SIZE > 256
-#error KK_PS2_BUFFER_SIZE too large (max. 256)!
 #else
-#define modulo_buffer_size(x) ((uint8_t) ((x) % buffer_size))
+#define modulo_buffer_size(x) ((uint8_t) ((x) & (KK_PS2_BUFFER_SIZE - 1)))
 #endif
 
 static inline void
@@ -179,7 +192,7 @@ ps2_write (const uint8_t data, const bool flush_input) {
 
 uint8_t
 ps2_bytes_available (void) {
-    return modulo_buffer_size(buffer_size + ps2_buffer_tail - ps2_buffer_head);
+    return modulo_buffer_size(ps2_buffer_tail - ps2_buffer_head);
 }
 
 int
@@ -341,9 +354,17 @@ ISR (PS2_CLK_INT_VECTOR) {
 
             if (bit) {
                 const uint8_t next_pos = modulo_buffer_size(ps2_buffer_tail + 1);
-                if (next_pos != ps2_buffer_head) {
+                if (ps2_buffer_overflowed) {
+                    // Discard until flushed
+                } else if (next_pos != ps2_buffer_head) {
                     ps2_buffer[ps2_buffer_tail] = ps2_data_byte;
                     ps2_buffer_tail = next_pos;
+                } else {
+                    ps2_buffer_overflowed = true;
+                    ps2_error = PS2_ERROR_BUFFER_OVERFLOW;
+                    if (ps2_buffer_overflow_count != UINT8_MAX) {
+                        ++ps2_buffer_overflow_count;
+                    }
                 }
             } else {
                 ps2_set_error(PS2_ERROR_STOP_BIT);
@@ -391,6 +412,17 @@ void
 ps2_flush_input (void) {
     ps2_buffer_tail = 0;
     ps2_buffer_head = 0;
+    ps2_buffer_overflowed = false;
+}
+
+bool
+ps2_input_overflowed (void) {
+    return ps2_buffer_overflowed;
+}
+
+uint8_t
+ps2_overflow_count (void) {
+    return ps2_buffer_overflow_count;
 }
 
 void
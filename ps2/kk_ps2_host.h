@@ -79,9 +79,20 @@ int ps2_get_byte(void);
 /// Returns the next available byte without consuming it.
 int ps2_peek_byte(void);
 
-/// Discard any unread bytes from the input buffer.
+/// Discard any unread bytes from the input buffer. This also clears the
+/// overflow state, see `ps2_input_overflowed`.
 void ps2_flush_input(void);
 
+/// Has input been lost because the buffer was full? The bytes remaining in
+/// the buffer are all from before the loss, and no more are received until
+/// the input is flushed (e.g., by sending a command), so the caller should
+/// read them and then resynchronize with the device.
+bool ps2_input_overflowed(void);
+
+/// Returns the number of times input has been lost to buffer overflow
+/// (saturates at 255).
+uint8_t ps2_overflow_count(void);
+
 /// Send a request to re-send the last byte received.
 #define ps2_request_resend() ps2_send(PS2_COMMAND_RESEND, true)
 
@@ -0,0 +1,180 @@
+/**
+ * ps2_decoder.c: Table-driven decoder for PS/2 keyboard scancodes (host).
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.dev/
+ *
+ * The scancodes in sets 2 and 3 are decoded with a small state machine: each
+ * byte is first classified (a prefix, a status byte, or a key), and the
+ * state and the class then index a table that gives the next state and the
+ * event to emit, if any. The prefixes are thus handled without any per-set
+ * special cases or branches: set 3 keyboards normally don't send the `E0`
+ * and `E1` prefixes, but some do for special keys, and they are decoded the
+ * same way.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ps2_decoder.h"
+#include "kk_ps2.h"
+#include "progmem.h"
+
+/// The scancode byte after the `E1` prefix in the set 2 Pause sequence
+/// (`E1 14 77 E1 F0 14 F0 77`).
+#define SET2_PAUSE_SCANCODE ((uint8_t) 0x14U)
+
+/// The byte sent by the keyboard on key overflow.
+#define PS2_KEY_OVERFLOW ((uint8_t) 0x00U)
+
+// MARK: - Byte Classes
+
+enum ps2_byte_class {
+    CLASS_KEY = 0,
+    /// The scancode after `E1` in the Pause sequence (otherwise a key).
+    CLASS_PAUSE_KEY,
+    CLASS_BREAK,
+    CLASS_EXTENDED,
+    CLASS_PAUSE,
+    CLASS_OVERFLOW,
+    CLASS_ERROR,
+    CLASS_INVALID,
+    CLASS_COUNT
+};
+
+/// The class of each byte (zero-initialised entries are keys).
+static const uint8_t PROGMEM ps2_byte_class[256] = {
+    [SET2_PAUSE_SCANCODE] = CLASS_PAUSE_KEY,
+    [PS2_BREAK_PREFIX] = CLASS_BREAK,
+    [PS2_EXT_PREFIX] = CLASS_EXTENDED,
+    [PS2_PAUSE_PREFIX] = CLASS_PAUSE,
+    [PS2_KEY_OVERFLOW] = CLASS_OVERFLOW,
+    [PS2_COMMAND_RESET] = CLASS_ERROR,
+    [PS2_REPLY_TEST_PASSED] = CLASS_INVALID,
+    [PS2_REPLY_RESEND] = CLASS_INVALID,
+    [PS2_COMMAND_ECHO] = CLASS_INVALID,
+};
+
+// MARK: - States
+
+/// The states. The first four are ordered so that the state bits are the
+/// `PS2_KEY_EVENT_RELEASE` and `PS2_KEY_EVENT_EXTENDED` flags of the key.
+enum ps2_decoder_state {
+    STATE_IDLE = 0,
+    STATE_BREAK = PS2_KEY_EVENT_RELEASE,
+    STATE_EXTENDED = PS2_KEY_EVENT_EXTENDED,
+    STATE_EXTENDED_BREAK = PS2_KEY_EVENT_EXTENDED | PS2_KEY_EVENT_RELEASE,
+    /// After `E1`, the press half of the Pause sequence.
+    STATE_PAUSE,
+    /// After `E1 F0`, the release half of the Pause sequence.
+    STATE_PAUSE_BREAK,
+    /// After `E1 14` or `E1 F0 14`, the second scancode of the Pause sequence.
+    STATE_PAUSE_TAIL,
+    /// After `F0` in the second part of the Pause sequence.
+    STATE_PAUSE_TAIL_BREAK,
+    STATE_COUNT
+};
+
+// MARK: - Transitions
+
+/// Set in the high byte of a table entry if an event is emitted.
+#define ENTRY_EMIT  ((uint8_t) 0x80U)
+#define STATE_MASK  ((uint8_t) 0x0FU)
+
+/// A table entry: move to the state `next` without emitting an event.
+#define MOVE(next) ((uint16_t) ((next) << 8))
+
+/// A table entry: emit an event with `flags`, and move to the state `next`.
+#define EMIT(next, flags) ((uint16_t) ((((next) | ENTRY_EMIT) << 8) | (flags)))
+
+/// The transitions of the states outside the Pause sequence, the key
+/// `flags` are those of the state.
+#define KEY_STATE(flags, after_break, after_extended) { \
+        [CLASS_KEY] = EMIT(STATE_IDLE, (flags)), \
+        [CLASS_PAUSE_KEY] = EMIT(STATE_IDLE, (flags)), \
+        [CLASS_BREAK] = MOVE(after_break), \
+        [CLASS_EXTENDED] = MOVE(after_extended), \
+        STATUS_AND_PAUSE \
+    }
+
+/// The transitions of the states in the Pause sequence. The sequence is
+/// emitted as a single event, and has no release.
+#define PAUSE_STATE(pause_key, after_key, after_break) { \
+        [CLASS_KEY] = MOVE(after_key), \
+        [CLASS_PAUSE_KEY] = (pause_key), \
+        [CLASS_BREAK] = MOVE(after_break), \
+        [CLASS_EXTENDED] = MOVE(STATE_EXTENDED), \
+        STATUS_AND_PAUSE \
+    }
+
+/// The status bytes end any sequence in progress, and so does the Pause
+/// prefix (which starts a new one).
+#define STATUS_AND_PAUSE \
+    [CLASS_PAUSE] = MOVE(STATE_PAUSE), \
+    [CLASS_OVERFLOW] = EMIT(STATE_IDLE, PS2_KEY_EVENT_OVERFLOW), \
+    [CLASS_ERROR] = EMIT(STATE_IDLE, PS2_KEY_EVENT_ERROR), \
+    [CLASS_INVALID] = EMIT(STATE_IDLE, PS2_KEY_EVENT_INVALID)
+
+/// The transitions for each state and byte class. Repeated prefixes are
+/// tolerated, and `E0` and `F0` combine in either order, but anything
+/// unexpected in the Pause sequence ends it.
+static const uint16_t PROGMEM ps2_decoder_table[STATE_COUNT][CLASS_COUNT] = {
+    [STATE_IDLE] = KEY_STATE(0, STATE_BREAK, STATE_EXTENDED),
+    [STATE_BREAK] = KEY_STATE(STATE_BREAK, STATE_BREAK, STATE_EXTENDED_BREAK),
+    [STATE_EXTENDED] = KEY_STATE(STATE_EXTENDED, STATE_EXTENDED_BREAK, STATE_EXTENDED),
+    [STATE_EXTENDED_BREAK] = KEY_STATE(STATE_EXTENDED_BREAK, STATE_EXTENDED_BREAK,
+                                       STATE_EXTENDED_BREAK),
+    [STATE_PAUSE] = PAUSE_STATE(EMIT(STATE_PAUSE_TAIL, PS2_KEY_EVENT_PAUSE), STATE_PAUSE_TAIL,
+                                STATE_PAUSE_BREAK),
+    [STATE_PAUSE_BREAK] = PAUSE_STATE(MOVE(STATE_PAUSE_TAIL), STATE_PAUSE_TAIL,
+                                      STATE_PAUSE_BREAK),
+    [STATE_PAUSE_TAIL] = PAUSE_STATE(MOVE(STATE_IDLE), STATE_IDLE, STATE_PAUSE_TAIL_BREAK),
+    [STATE_PAUSE_TAIL_BREAK] = PAUSE_STATE(MOVE(STATE_IDLE), STATE_IDLE,
+                                           STATE_PAUSE_TAIL_BREAK),
+};
+
+_Static_assert(STATE_COUNT <= STATE_MASK + 1, "Too many decoder states");
+
+// MARK: - Decoding
+
+void
+ps2_decoder_reset (struct ps2_decoder *decoder) {
+    decoder->state = STATE_IDLE;
+}
+
+uint8_t
+ps2_decoder_decode (struct ps2_decoder *decoder, uint8_t count,
+                    const uint8_t bytes[static count],
+                    struct ps2_key_event events[static count]) {
+    uint8_t state = decoder->state;
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < count; ++i) {
+        const uint8_t byte = bytes[i];
+        const uint16_t entry = pgm_read_word(
+            &ps2_decoder_table[state][pgm_read_byte(&ps2_byte_class[byte])]);
+        const uint8_t high = (uint8_t) (entry >> 8);
+
+        // The event is always stored, but only kept if emitted (there is
+        // room, since there are never more events than bytes)
+        events[n].scancode = byte;
+        events[n].flags = (uint8_t) entry;
+        n += (high & ENTRY_EMIT) ? 1 : 0;
+        state = high & STATE_MASK;
+    }
+
+    decoder->state = state;
+    return n;
+}
@@ -0,0 +1,67 @@
+/**
+ * ps2_decoder.h: Table-driven decoder for PS/2 keyboard scancodes (host).
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.dev/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KK_PS2_DECODER_H
+#define KK_PS2_DECODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// The key was released (otherwise pressed).
+#define PS2_KEY_EVENT_RELEASE  ((uint8_t) (1U << 0))
+/// The scancode had the `PS2_EXT_PREFIX`.
+#define PS2_KEY_EVENT_EXTENDED ((uint8_t) (1U << 1))
+/// The set 2 Pause key sequence (which has no release).
+#define PS2_KEY_EVENT_PAUSE    ((uint8_t) (1U << 2))
+/// The keyboard reported key overflow (rollover error).
+#define PS2_KEY_EVENT_OVERFLOW ((uint8_t) (1U << 3))
+/// The keyboard reported an error.
+#define PS2_KEY_EVENT_ERROR    ((uint8_t) (1U << 4))
+/// A byte that doesn't belong in the scancode stream (e.g., a self-test
+/// passed after the keyboard was reset or replugged).
+#define PS2_KEY_EVENT_INVALID  ((uint8_t) (1U << 5))
+/// The flags of status events, which are not key events.
+#define PS2_KEY_EVENT_STATUS   (PS2_KEY_EVENT_OVERFLOW | PS2_KEY_EVENT_ERROR | PS2_KEY_EVENT_INVALID)
+
+/// A decoded key event.
+struct ps2_key_event {
+    /// The scancode, without prefixes.
+    uint8_t scancode;
+    /// `PS2_KEY_EVENT_*` flags.
+    uint8_t flags;
+};
+
+/// The decoder state between batches of bytes (0 when not in the middle of
+/// a multi-byte sequence).
+struct ps2_decoder {
+    uint8_t state;
+};
+
+/// Reset the `decoder` to expect the start of a scancode.
+void ps2_decoder_reset(struct ps2_decoder *decoder);
+
+/// Decode `count` scancode bytes from the keyboard in scancode set 2 or 3,
+/// continuing from the state of the previous call. The decoded events are
+/// stored in `events` (there is at most one per byte), and their number is
+/// returned. Multi-byte sequences may be split between calls.
+uint8_t ps2_decoder_decode(struct ps2_decoder *decoder, uint8_t count,
+                           const uint8_t bytes[static count],
+                           struct ps2_key_event events[static count]);
+
+#endif
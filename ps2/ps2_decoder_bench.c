@@ -0,0 +1,151 @@
+// PS/2 host scancode decoder throughput benchmark.
+//
+// Usage: ps2_decoder_bench.bin
+//
+// Decodes a long Model M byte stream (typing with fake shifts, Pause and
+// status bytes) with the table-driven `ps2_decoder_decode`, in batches as
+// `kbd_input()` in `ps2usb.c` does, and with the previous per-byte prefix
+// flag decoding. Prints one line per batch size:
+//
+//      batch  reference_ns_per_byte  table_ns_per_byte
+//
+// This is measured on the host, so it only shows the relative difference.
+
+#define PS2_DECODER_TEST_NO_MAIN 1
+#include "ps2_decoder_test.c"
+
+#include <time.h>
+
+#ifndef BENCH_ROUNDS
+/// The number of rounds over the stream, the fastest is reported.
+#define BENCH_ROUNDS 200
+#endif
+
+#define STREAM_REPEATS 256
+
+static inline uint64_t
+now_ns (void) {
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/// Prevent the compiler from optimizing away the decoding.
+static volatile uint8_t sink;
+
+// MARK: - Reference
+
+#define KEY_FLAG_IS_RELEASE    ((uint8_t) (1U << 0))
+#define KEY_FLAG_IS_EXTENDED   ((uint8_t) (1U << 1))
+#define KEY_FLAG_OVERFLOW      ((uint8_t) (1U << 2))
+#define KEY_FLAG_ERROR         ((uint8_t) (1U << 3))
+#define KEY_FLAG_INVALID_STATE ((uint8_t) (1U << 4))
+#define KEY_FLAG_E1_PREFIX     ((uint8_t) (1U << 5))
+
+static uint8_t reference_key_state = 0;
+
+static uint8_t
+reference_key_flag (const uint8_t byte) {
+    switch (byte) {
+    case PS2_BREAK_PREFIX:      return KEY_FLAG_IS_RELEASE;
+    case PS2_EXT_PREFIX:        return KEY_FLAG_IS_EXTENDED;
+    case PS2_PAUSE_PREFIX:      return KEY_FLAG_E1_PREFIX;
+    case 0x00:                  return KEY_FLAG_OVERFLOW;
+    case PS2_COMMAND_RESET:     return KEY_FLAG_ERROR;
+    case PS2_REPLY_TEST_PASSED: // fallthrough
+    case PS2_REPLY_RESEND:      // fallthrough
+    case PS2_COMMAND_ECHO:      return KEY_FLAG_INVALID_STATE;
+    default:                    return 0U;
+    }
+}
+
+/// The previous decoding in `kbd_input()`, one byte at a time.
+static uint8_t
+reference_decode (uint8_t count, const uint8_t *bytes, struct ps2_key_event *events) {
+    uint8_t n = 0;
+    while (count--) {
+        const uint8_t key = *bytes++;
+        const uint8_t prefix_flag = reference_key_flag(key);
+        if (prefix_flag) {
+            reference_key_state |= prefix_flag;
+            continue;
+        }
+        const bool is_key_release = (reference_key_state & KEY_FLAG_IS_RELEASE) != 0;
+        const bool is_extended = (reference_key_state & KEY_FLAG_IS_EXTENDED) != 0;
+        const bool is_e1_prefix = (reference_key_state & KEY_FLAG_E1_PREFIX) != 0;
+        reference_key_state = 0U;
+        if (is_e1_prefix) {
+            if (key == SET2_PAUSE_SCANCODE && !is_key_release) {
+                events[n].scancode = key;
+                events[n++].flags = PS2_KEY_EVENT_PAUSE;
+                reference_key_state |= KEY_FLAG_E1_PREFIX;
+            }
+            continue;
+        }
+        events[n].scancode = key;
+        events[n++].flags = (is_key_release ? R : 0) | (is_extended ? X : 0);
+    }
+    return n;
+}
+
+// MARK: - Benchmark
+
+static const uint8_t model_m_stream[] = {
+    // Shift+H, e, l, l, o
+    0x12, 0x33, 0xF0, 0x33, 0xF0, 0x12, 0x24, 0xF0, 0x24, 0x4B, 0xF0, 0x4B,
+    0x4B, 0xF0, 0x4B, 0x44, 0xF0, 0x44,
+    // Insert with Num Lock on
+    0xE0, 0x12, 0xE0, 0x70, 0xE0, 0xF0, 0x70, 0xE0, 0xF0, 0x12,
+    // Shift + Left Arrow
+    0x12, 0xE0, 0xF0, 0x12, 0xE0, 0x6B, 0xE0, 0xF0, 0x6B, 0xE0, 0x12, 0xF0, 0x12,
+    // Right Ctrl
+    0xE0, 0x14, 0xE0, 0xF0, 0x14,
+    // Pause
+    0xE1, 0x14, 0x77, 0xE1, 0xF0, 0x14, 0xF0, 0x77,
+    // Overflow
+    0x00,
+};
+
+static uint8_t stream[sizeof(model_m_stream) * STREAM_REPEATS];
+
+static double
+bench_decode (uint8_t (*decode)(uint8_t, const uint8_t *, struct ps2_key_event *),
+              const uint8_t batch) {
+    struct ps2_key_event events[UINT8_MAX];
+    uint64_t best = UINT64_MAX;
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        uint8_t acc = 0;
+        const uint64_t start = now_ns();
+        for (size_t i = 0; i < sizeof(stream); i += batch) {
+            const uint8_t len = (sizeof(stream) - i < batch) ? (uint8_t) (sizeof(stream) - i) : batch;
+            const uint8_t n = decode(len, stream + i, events);
+            acc += n ? events[n - 1].scancode : 0;
+        }
+        const uint64_t elapsed = now_ns() - start;
+        sink = acc;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return (double) best / sizeof(stream);
+}
+
+static uint8_t
+table_decode (uint8_t count, const uint8_t *bytes, struct ps2_key_event *events) {
+    return ps2_decoder_decode(&decoder, count, bytes, events);
+}
+
+int
+main (void) {
+    for (int i = 0; i < STREAM_REPEATS; ++i) {
+        memcpy(stream + i * sizeof(model_m_stream), model_m_stream, sizeof(model_m_stream));
+    }
+    const uint8_t batches[] = { 1, 8, 32 };
+    for (unsigned i = 0; i < sizeof(batches); ++i) {
+        ps2_decoder_reset(&decoder);
+        const double reference = bench_decode(reference_decode, batches[i]);
+        const double table = bench_decode(table_decode, batches[i]);
+        (void) printf("batch%-3u %8.2f %8.2f\n", batches[i], reference, table);
+    }
+    return 0;
+}
@@ -0,0 +1,246 @@
+/**
+ * ps2_decoder_test.c: Tests for the PS/2 host scancode decoder.
+ *
+ * The `main()` is generated automatically by running every function in this
+ * file with a name starting `test_`. The decoder is reset before each test.
+ *
+ * The byte streams are as recorded from an IBM Model M (1391401) in scancode
+ * sets 2 and 3, including the fake shifts it sends around the tenkey block
+ * and Print Screen in set 2.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ps2/ps2_decoder.c"
+
+static int tests_run = 0;
+static int tests_failed = 0;
+static int verbose = 0;
+
+static struct ps2_decoder decoder;
+
+#define R PS2_KEY_EVENT_RELEASE
+#define X PS2_KEY_EVENT_EXTENDED
+
+/// Shorthand for an expected event.
+#define EV(code, flags) ((struct ps2_key_event) { (code), (flags) })
+
+#define MAX_EVENTS 64
+
+/// Decode `bytes` in chunks of `chunk` bytes, into `events`.
+static int
+decode_in_chunks (const uint8_t *bytes, int count, int chunk, struct ps2_key_event *events) {
+    int n = 0;
+    for (int i = 0; i < count; i += chunk) {
+        const int len = (count - i < chunk) ? count - i : chunk;
+        n += ps2_decoder_decode(&decoder, (uint8_t) len, bytes + i, events + n);
+    }
+    return n;
+}
+
+static void
+print_events (const char *label, const struct ps2_key_event *events, int n) {
+    (void) printf("  %s:", label);
+    for (int i = 0; i < n; ++i) {
+        (void) printf(" %02X/%02X", events[i].scancode, events[i].flags);
+    }
+    (void) printf("\n");
+}
+
+/// Decode `bytes` whole, one byte at a time, and in chunks of three bytes,
+/// and compare the events to `expected` each time. The decoder must be back
+/// in the idle state after.
+static void
+expect_events_line (const uint8_t *bytes, int count, const struct ps2_key_event *expected,
+                    int expected_count, const char *msg, int line) {
+    struct ps2_key_event events[MAX_EVENTS];
+    const int chunks[] = { count, 1, 3 };
+    for (unsigned c = 0; c < sizeof(chunks) / sizeof(*chunks); ++c) {
+        const int chunk = chunks[c];
+        ps2_decoder_reset(&decoder);
+        const int n = decode_in_chunks(bytes, count, chunk, events);
+        bool ok = (n == expected_count) && decoder.state == 0;
+        for (int i = 0; ok && i < n; ++i) {
+            ok = events[i].scancode == expected[i].scancode && events[i].flags == expected[i].flags;
+        }
+        tests_run++;
+        if (!ok) {
+            tests_failed++;
+            (void) printf("FAIL %d: %s (chunk %d)\n", line, msg, chunk);
+            print_events("expected", expected, expected_count);
+            print_events("got", events, n);
+        } else if (verbose) {
+            (void) printf("PASS %s (chunk %d)\n", msg, chunk);
+        }
+    }
+}
+
+#define expect_events(bytes, expected, msg) \
+    expect_events_line((bytes), (int) sizeof(bytes), (expected), \
+        (int) (sizeof(expected) / sizeof(*(expected))), (msg), __LINE__)
+
+static void
+test_set2_typing (void) {
+    // Shift+H, e, l, l, o
+    const uint8_t bytes[] = { 0x12, 0x33, 0xF0, 0x33, 0xF0, 0x12, 0x24, 0xF0, 0x24,
+                              0x4B, 0xF0, 0x4B, 0x4B, 0xF0, 0x4B, 0x44, 0xF0, 0x44 };
+    const struct ps2_key_event expected[] = {
+        EV(0x12, 0), EV(0x33, 0), EV(0x33, R), EV(0x12, R), EV(0x24, 0), EV(0x24, R),
+        EV(0x4B, 0), EV(0x4B, R), EV(0x4B, 0), EV(0x4B, R), EV(0x44, 0), EV(0x44, R),
+    };
+    expect_events(bytes, expected, "Set 2 typing");
+}
+
+static void
+test_set2_overlapping_keys (void) {
+    // Fast typing: the next key is pressed before the previous is released
+    const uint8_t bytes[] = { 0x2C, 0x33, 0xF0, 0x2C, 0x24, 0xF0, 0x33, 0xF0, 0x24 };
+    const struct ps2_key_event expected[] = {
+        EV(0x2C, 0), EV(0x33, 0), EV(0x2C, R), EV(0x24, 0), EV(0x33, R), EV(0x24, R),
+    };
+    expect_events(bytes, expected, "Set 2 overlapping keys");
+}
+
+static void
+test_set2_extended_modifiers (void) {
+    // Right Ctrl, Right Alt
+    const uint8_t bytes[] = { 0xE0, 0x14, 0xE0, 0x11, 0xE0, 0xF0, 0x11, 0xE0, 0xF0, 0x14 };
+    const struct ps2_key_event expected[] = {
+        EV(0x14, X), EV(0x11, X), EV(0x11, X | R), EV(0x14, X | R),
+    };
+    expect_events(bytes, expected, "Set 2 extended modifiers");
+}
+
+static void
+test_set2_model_m_insert_num_lock_on (void) {
+    // Num Lock on: Insert is wrapped in a fake Left Shift
+    const uint8_t bytes[] = { 0xE0, 0x12, 0xE0, 0x70, 0xE0, 0xF0, 0x70, 0xE0, 0xF0, 0x12 };
+    const struct ps2_key_event expected[] = {
+        EV(0x12, X), EV(0x70, X), EV(0x70, X | R), EV(0x12, X | R),
+    };
+    expect_events(bytes, expected, "Model M: Insert with Num Lock on");
+}
+
+static void
+test_set2_model_m_shift_arrow (void) {
+    // Left Shift held: the arrow is wrapped in a fake Left Shift release
+    const uint8_t bytes[] = { 0x12, 0xE0, 0xF0, 0x12, 0xE0, 0x6B, 0xE0, 0xF0, 0x6B,
+                              0xE0, 0x12, 0xF0, 0x12 };
+    const struct ps2_key_event expected[] = {
+        EV(0x12, 0), EV(0x12, X | R), EV(0x6B, X), EV(0x6B, X | R), EV(0x12, X), EV(0x12, R),
+    };
+    expect_events(bytes, expected, "Model M: Shift + Left Arrow");
+}
+
+static void
+test_set2_model_m_print_screen (void) {
+    const uint8_t bytes[] = { 0xE0, 0x12, 0xE0, 0x7C, 0xE0, 0xF0, 0x7C, 0xE0, 0xF0, 0x12 };
+    const struct ps2_key_event expected[] = {
+        EV(0x12, X), EV(0x7C, X), EV(0x7C, X | R), EV(0x12, X | R),
+    };
+    expect_events(bytes, expected, "Model M: Print Screen");
+}
+
+static void
+test_set2_model_m_alt_sysrq (void) {
+    const uint8_t bytes[] = { 0x11, 0x84, 0xF0, 0x84, 0xF0, 0x11 };
+    const struct ps2_key_event expected[] = {
+        EV(0x11, 0), EV(0x84, 0), EV(0x84, R), EV(0x11, R),
+    };
+    expect_events(bytes, expected, "Model M: Alt + SysRq");
+}
+
+static void
+test_set2_model_m_pause (void) {
+    // The whole sequence is one event, the trailing 77 is not Num Lock
+    const uint8_t bytes[] = { 0xE1, 0x14, 0x77, 0xE1, 0xF0, 0x14, 0xF0, 0x77, 0x1C, 0xF0, 0x1C };
+    const struct ps2_key_event expected[] = {
+        EV(0x14, PS2_KEY_EVENT_PAUSE), EV(0x1C, 0), EV(0x1C, R),
+    };
+    expect_events(bytes, expected, "Model M: Pause, then A");
+}
+
+static void
+test_set2_model_m_ctrl_break (void) {
+    const uint8_t bytes[] = { 0x14, 0xE0, 0x7E, 0xE0, 0xF0, 0x7E, 0xF0, 0x14 };
+    const struct ps2_key_event expected[] = {
+        EV(0x14, 0), EV(0x7E, X), EV(0x7E, X | R), EV(0x14, R),
+    };
+    expect_events(bytes, expected, "Model M: Ctrl + Break");
+}
+
+static void
+test_set3_model_m (void) {
+    // Set 3 (make/break): A, Right Ctrl, Pause, Right Arrow
+    const uint8_t bytes[] = { 0x1C, 0xF0, 0x1C, 0x58, 0xF0, 0x58, 0x62, 0xF0, 0x62, 0x6A, 0xF0,
+                              0x6A };
+    const struct ps2_key_event expected[] = {
+        EV(0x1C, 0), EV(0x1C, R), EV(0x58, 0), EV(0x58, R),
+        EV(0x62, 0), EV(0x62, R), EV(0x6A, 0), EV(0x6A, R),
+    };
+    expect_events(bytes, expected, "Set 3 Model M");
+}
+
+static void
+test_set3_extended_special_key (void) {
+    // Some set 3 keyboards send E0 for special keys, it is decoded all the same
+    const uint8_t bytes[] = { 0xE0, 0x5E, 0xE0, 0xF0, 0x5E };
+    const struct ps2_key_event expected[] = { EV(0x5E, X), EV(0x5E, X | R) };
+    expect_events(bytes, expected, "Set 3 extended special key");
+}
+
+static void
+test_status_bytes (void) {
+    const uint8_t bytes[] = { 0x1C, 0x00, 0xF0, 0x1C, 0xFF, 0xAA, 0xFE, 0xEE };
+    const struct ps2_key_event expected[] = {
+        EV(0x1C, 0), EV(0x00, PS2_KEY_EVENT_OVERFLOW), EV(0x1C, R),
+        EV(0xFF, PS2_KEY_EVENT_ERROR), EV(0xAA, PS2_KEY_EVENT_INVALID),
+        EV(0xFE, PS2_KEY_EVENT_INVALID), EV(0xEE, PS2_KEY_EVENT_INVALID),
+    };
+    expect_events(bytes, expected, "Status bytes");
+}
+
+static void
+test_status_byte_ends_sequence (void) {
+    // A keyboard replugged mid-sequence: the self-test result resyncs
+    const uint8_t bytes[] = { 0xE0, 0xF0, 0xAA, 0x1C };
+    const struct ps2_key_event expected[] = {
+        EV(0xAA, PS2_KEY_EVENT_INVALID), EV(0x1C, 0),
+    };
+    expect_events(bytes, expected, "Status byte ends sequence");
+}
+
+static void
+test_state_kept_between_batches (void) {
+    const uint8_t first[] = { 0xE0, 0xF0 };
+    const uint8_t second[] = { 0x74 };
+    struct ps2_key_event events[2];
+    ps2_decoder_reset(&decoder);
+    const uint8_t n = ps2_decoder_decode(&decoder, sizeof(first), first, events);
+    tests_run++;
+    if (n != 0 || decoder.state == 0) {
+        tests_failed++;
+        (void) printf("FAIL %d: prefixes pending\n", __LINE__);
+    }
+    const uint8_t m = ps2_decoder_decode(&decoder, sizeof(second), second, events);
+    tests_run++;
+    if (m != 1 || events[0].scancode != 0x74 || events[0].flags != (X | R) || decoder.state != 0) {
+        tests_failed++;
+        (void) printf("FAIL %d: completed by next batch\n", __LINE__);
+    } else if (verbose) {
+        (void) printf("PASS state kept between batches\n");
+    }
+}
+
+/// Reset the state. Run automatically before each test.
+static void
+reset (void) {
+    ps2_decoder_reset(&decoder);
+}
+
+#ifndef PS2_DECODER_TEST_NO_MAIN
+#include "decoder_test_runner.c"
+#endif
@@ -252,4 +252,29 @@ enum keycode_ps2_extended {
     EXTENDED_KEY_KP_EQUALS_SET2 = 0x5D,
 };
 
+/// Translation from set 2 to set 1 scancodes (as done by the keyboard
+/// controller of the PC), indexed by the set 2 scancode. This is a string so
+/// that `ps2_set2_to_set1` can be used in constant expressions, i.e., to
+/// derive the set 1 tables from the set 2 ones at compile time.
+#define PS2_SET2_TO_SET1_TRANSLATION \
+    "\xFF\x43\x41\x3F\x3D\x3B\x3C\x58\x64\x44\x42\x40\x3E\x0F\x29\x59" \
+    "\x65\x38\x2A\x70\x1D\x10\x02\x5A\x66\x71\x2C\x1F\x1E\x11\x03\x5B" \
+    "\x67\x2E\x2D\x20\x12\x05\x04\x5C\x68\x39\x2F\x21\x14\x13\x06\x5D" \
+    "\x69\x31\x30\x23\x22\x15\x07\x5E\x6A\x72\x32\x24\x16\x08\x09\x5F" \
+    "\x6B\x33\x25\x17\x18\x0B\x0A\x60\x6C\x34\x35\x26\x27\x19\x0C\x61" \
+    "\x6D\x73\x28\x74\x1A\x0D\x62\x6E\x3A\x36\x1C\x1B\x75\x2B\x63\x76" \
+    "\x55\x56\x77\x78\x79\x7A\x0E\x7B\x7C\x4F\x7D\x4B\x47\x7E\x7F\x6F" \
+    "\x52\x53\x50\x4C\x4D\x48\x01\x45\x57\x4E\x51\x4A\x37\x49\x46\x54" \
+    "\x80\x81\x82\x41\x54\x85\x86\x87\x88\x89\x8A\x8B\x8C\x8D\x8E\x8F" \
+    "\x90\x91\x92\x93\x94\x95\x96\x97\x98\x99\x9A\x9B\x9C\x9D\x9E\x9F" \
+    "\xA0\xA1\xA2\xA3\xA4\xA5\xA6\xA7\xA8\xA9\xAA\xAB\xAC\xAD\xAE\xAF" \
+    "\xB0\xB1\xB2\xB3\xB4\xB5\xB6\xB7\xB8\xB9\xBA\xBB\xBC\xBD\xBE\xBF" \
+    "\xC0\xC1\xC2\xC3\xC4\xC5\xC6\xC7\xC8\xC9\xCA\xCB\xCC\xCD\xCE\xCF" \
+    "\xD0\xD1\xD2\xD3\xD4\xD5\xD6\xD7\xD8\xD9\xDA\xDB\xDC\xDD\xDE\xDF" \
+    "\xE0\xE1\xE2\xE3\xE4\xE5\xE6\xE7\xE8\xE9\xEA\xEB\xEC\xED\xEE\xEF" \
+    "\xF0\xF1\xF2\xF3\xF4\xF5\xF6\xF7\xF8\xF9\xFA\xFB\xFC\xFD\xFE\xFF"
+
+/// The set 1 scancode of the set 2 `scancode` (also extended ones).
+#define ps2_set2_to_set1(scancode) ((uint8_t) PS2_SET2_TO_SET1_TRANSLATION[(scancode)])
+
 #endif
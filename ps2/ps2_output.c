@@ -48,6 +48,7 @@
 #include "usb2ps2_keys.h"
 #include <qmk_core/platforms/timer.h>
 #include <stdint.h>
+#include <string.h>
 
 #define KK_KEYCODES_INCLUDE_DUPLICATES 1
 #include "ps2_keys.h"
@@ -87,6 +88,16 @@
 #define PS2_OUTPUT_MAX_EVENTS_PER_TASK 2
 #endif
 
+#ifndef PS2_OUTPUT_MAX_DEFERRED_RELEASES
+/// The maximum number of key releases that can be held back when the key
+/// event queue is full. Releases are never dropped while there is room here,
+/// so keys don't get stuck down on the host; they are queued again (and sent)
+/// as soon as the key event queue has room. Presses that don't fit in the
+/// queue are dropped. If a release is dropped, every key the host believes
+/// is down is released once the queue has drained.
+#define PS2_OUTPUT_MAX_DEFERRED_RELEASES 6
+#endif
+
 #ifndef PS2_OUTPUT_NUM_LOCK_LED_EVENT
 /// Enabling this treats a Num Lock LED toggle from the host as kind of
 /// equivalent to having pressed the Num Lock key locally if keys are held
@@ -145,6 +156,12 @@ static uint8_t ps2_modifiers = 0;
     do { \
         --key_event_queue_tail; \
     } while (0)
+#define key_event_last modulo_key_event_queue((uint8_t) (key_event_queue_head - 1U))
+#define remove_last_key_event() \
+    do { \
+        --key_event_queue_head; \
+    } while (0)
+#define has_multiple_key_events (key_event_queue_count > 1)
 
 #else
 
@@ -167,6 +184,14 @@ static uint8_t ps2_modifiers = 0;
     do { \
         key_event_queue_tail = modulo_key_event_queue(key_event_queue_tail - 1); \
     } while (0)
+#define key_event_last modulo_key_event_queue(key_event_queue_head + PS2_OUTPUT_MAX_KEY_EVENTS)
+#define remove_last_key_event() \
+    do { \
+        key_event_queue_head = key_event_last; \
+    } while (0)
+#define has_multiple_key_events \
+    (!is_key_event_queue_empty \
+     && modulo_key_event_queue(key_event_queue_tail + 1) != key_event_queue_head)
 
 #endif
 
@@ -193,6 +218,36 @@ uint8_t key_event_queue_head = 0;
 /// Key event ring buffer tail.
 uint8_t key_event_queue_tail = 0;
 
+/// Releases that didn't fit in the key event queue, to be queued later.
+static uint8_t deferred_releases[PS2_OUTPUT_MAX_DEFERRED_RELEASES];
+
+/// The number of keys in `deferred_releases`.
+static uint8_t deferred_release_count = 0;
+
+/// Key event queue counters (see `ps2_output_queue_counters()`).
+static struct ps2_output_queue_counters queue_counters;
+
+/// Increment a saturating counter in `queue_counters`.
+#define count_queue_event(counter) \
+    do { \
+        if (queue_counters.counter != UINT8_MAX) { \
+            ++queue_counters.counter; \
+        } \
+    } while (0)
+
+/// Keys that have been sent as pressed and not released, i.e., the keys that
+/// the host believes are down (one bit per USB keycode).
+static uint8_t host_keys_down[32];
+
+#define host_key_bit(key) ((uint8_t) (1U << ((key) % 8U)))
+#define is_host_key_down(key) (host_keys_down[(key) / 8U] & host_key_bit(key))
+#define set_host_key_down(key) (host_keys_down[(key) / 8U] |= host_key_bit(key))
+#define set_host_key_up(key) (host_keys_down[(key) / 8U] &= (uint8_t) ~host_key_bit(key))
+
+/// A release was dropped because the queue and the deferred releases were
+/// full, so release every key the host believes is down once they drain.
+static bool is_release_resync_pending = false;
+
 // MARK: Tenkey Tracking
 
 #if ENABLE_PS2_LEGACY_COMPATIBILITY
@@ -207,8 +262,9 @@ static uint8_t tenkey_count = 0;
 
 /// Key repeat state. At most one key can be repeating at once. This saves
 /// the scancode (in the current PS/2 scancode set), flags, and timestamp.
-/// The timestamp is the last event of that key, i.e., initially the original
-/// press, later the previous repetition.
+/// The timestamp is when the last event of that key was due, i.e., initially
+/// the original press, later the scheduled time of the previous repetition
+/// (so that the main loop latency doesn't accumulate into the repeat rate).
 static struct {
     uint8_t scancode;
     uint8_t flags;
@@ -218,6 +274,16 @@ static struct {
 #define REPEAT_FLAG_KEY_IS_EXTENDED ((uint8_t) 0x01U)
 #define REPEAT_FLAG_IS_REPEATING    ((uint8_t) 0x02U)
 
+#if ENABLE_PS2_DEVICE_TIMER
+// The repeats are sent by the device timer interrupt, and
+// `REPEAT_FLAG_IS_REPEATING` means that they have been scheduled.
+#define cancel_scheduled_repeat() ps2_device_stop_repeat()
+#else
+#define cancel_scheduled_repeat() \
+    do { \
+    } while (0)
+#endif
+
 /// The configured F3 typematic rate/delay byte (default: ~10.9 cps, 500 ms).
 static uint8_t repeat_rate = PS2_KEYBOARD_DEFAULT_REPEAT_RATE;
 
@@ -313,6 +379,7 @@ clear_repeat_for_key (const uint8_t scancode, const bool is_extended) {
             && (ps2_repeat_key.flags & REPEAT_FLAG_KEY_IS_EXTENDED)
                 == (is_extended ? REPEAT_FLAG_KEY_IS_EXTENDED : 0))) {
         ps2_repeat_key.scancode = 0;
+        cancel_scheduled_repeat();
     }
 }
 
@@ -356,6 +423,7 @@ ps2_output_reset (const bool include_power_up_delay) {
 void
 ps2_output_init (void) {
     pending_cmd = 0;
+    queue_counters = (struct ps2_output_queue_counters) { 0 };
     ps2_output_reset(true);
     ps2_device_attach();
     ps2_output_flags = FLAG_OUTPUT_INITIALIZED;
@@ -560,6 +628,7 @@ ps2_send_key_press (const uint8_t usb_keycode) {
     if (!is_ps2_scanning_enabled) {
         return;
     }
+    set_host_key_down(usb_keycode);
 
     uint8_t scancode = ps2_scancode_for_usb_keycode(usb_keycode, ps2_active_scancode_set);
 
@@ -601,7 +670,10 @@ ps2_send_key_press (const uint8_t usb_keycode) {
                 ps2_repeat_key.scancode = scancode;
                 ps2_repeat_key.flags = is_extended ? REPEAT_FLAG_KEY_IS_EXTENDED : 0;
             }
+            // The new press restarts the repeat delay
+            ps2_repeat_key.flags &= ~REPEAT_FLAG_IS_REPEATING;
             ps2_repeat_key.timestamp = timer_read();
+            cancel_scheduled_repeat();
         } else {
             clear_repeat();
         }
@@ -689,6 +761,8 @@ clear_key_state (void) {
     tenkey_count = 0;
 #endif
     ps2_modifiers = 0;
+    memset(host_keys_down, 0, sizeof(host_keys_down));
+    is_release_resync_pending = false;
 }
 
 void
@@ -696,6 +770,7 @@ ps2_send_key_release (const uint8_t usb_keycode) {
     if (!is_ps2_scanning_enabled) {
         return;
     }
+    set_host_key_up(usb_keycode);
 
     const uint8_t scancode = ps2_scancode_for_usb_keycode(usb_keycode, ps2_active_scancode_set);
 
@@ -837,6 +912,27 @@ decode_repeat_delay_ms (const uint8_t rate) {
     return 250U * ((rate >> 5) + 1);
 }
 
+#if ENABLE_PS2_DEVICE_TIMER
+static inline void
+process_repeat (void) {
+    if (!ps2_repeat_key.scancode) {
+        return;
+    }
+
+    const uint16_t period = decode_repeat_period_ms(repeat_rate);
+
+    if (ps2_repeat_key.flags & REPEAT_FLAG_IS_REPEATING) {
+        // Already scheduled: resume after any host command, and apply any
+        // change of rate
+        ps2_device_resume_repeat(period);
+    } else {
+        ps2_repeat_key.flags |= REPEAT_FLAG_IS_REPEATING;
+        ps2_device_start_repeat(ps2_repeat_key.scancode,
+            ps2_repeat_key.flags & REPEAT_FLAG_KEY_IS_EXTENDED,
+            ps2_repeat_key.timestamp + decode_repeat_delay_ms(repeat_rate), period);
+    }
+}
+#else
 static inline void
 process_repeat (void) {
     if (!ps2_repeat_key.scancode) {
@@ -845,21 +941,29 @@ process_repeat (void) {
 
     const uint16_t now = timer_read();
     const uint16_t elapsed = now - ps2_repeat_key.timestamp;
+    const uint16_t period = decode_repeat_period_ms(repeat_rate);
+    uint16_t interval;
 
     if (ps2_repeat_key.flags & REPEAT_FLAG_IS_REPEATING) {
-        if (elapsed < decode_repeat_period_ms(repeat_rate)) {
-            // Repeats after the first: wait repeat period ms between them
-            return;
-        }
+        // Repeats after the first: wait repeat period ms between them
+        interval = period;
     } else {
-        if (elapsed < decode_repeat_delay_ms(repeat_rate)) {
-            // First repeat: wait for repeat delay ms
-            return;
-        }
-        ps2_repeat_key.flags |= REPEAT_FLAG_IS_REPEATING;
+        // First repeat: wait for repeat delay ms
+        interval = decode_repeat_delay_ms(repeat_rate);
     }
+    if (elapsed < interval) {
+        return;
+    }
+    ps2_repeat_key.flags |= REPEAT_FLAG_IS_REPEATING;
 
-    ps2_repeat_key.timestamp = now;
+    if ((uint16_t) (elapsed - interval) < period) {
+        // Schedule the next one from when this one was due
+        ps2_repeat_key.timestamp += interval;
+    } else {
+        // Fell behind by a whole period (e.g., a long host inhibit), resync
+        // instead of sending a burst of repeats
+        ps2_repeat_key.timestamp = now;
+    }
 
     if (ps2_repeat_key.flags & REPEAT_FLAG_KEY_IS_EXTENDED) {
         send_2_bytes(PS2_EXT_PREFIX, ps2_repeat_key.scancode);
@@ -867,25 +971,122 @@ process_repeat (void) {
         send_byte(ps2_repeat_key.scancode);
     }
 }
+#endif
+
+// MARK: - Key Event Queue
+
+static inline void
+queue_key_event (const uint8_t key, const bool is_release) {
+    key_event_queue[key_event_head].key = key;
+    key_event_queue[key_event_head].is_release = is_release;
+    increment_key_event_queue();
+}
+
+/// Move as many deferred releases to the key event queue as there is room.
+static void
+requeue_deferred_releases (void) {
+    uint_fast8_t i = 0;
+    while (i < deferred_release_count && !is_key_event_queue_full) {
+        queue_key_event(deferred_releases[i++], true);
+        count_queue_event(resynced);
+    }
+    if (i) {
+        deferred_release_count -= i;
+        for (uint_fast8_t j = 0; j < deferred_release_count; ++j) {
+            deferred_releases[j] = deferred_releases[i + j];
+        }
+    }
+}
+
+/// Removes `key` from the deferred releases. Returns `true` if it was there.
+static bool
+cancel_deferred_release (const uint8_t key) {
+    for (uint_fast8_t i = 0; i < deferred_release_count; ++i) {
+        if (deferred_releases[i] == key) {
+            --deferred_release_count;
+            for (; i < deferred_release_count; ++i) {
+                deferred_releases[i] = deferred_releases[i + 1];
+            }
+            return true;
+        }
+    }
+    return false;
+}
 
 void
 ps2_press_key (const uint8_t key) {
+    if (deferred_release_count) {
+        if (cancel_deferred_release(key)) {
+            // The release was never sent, so the key is still down on the
+            // host. Cancelling the release loses this keystroke, but keeps
+            // the state in sync without waiting for room in the queue.
+            count_queue_event(coalesced);
+            return;
+        }
+        requeue_deferred_releases();
+    }
+    if (IS_MODIFIER(key) && has_multiple_key_events) {
+        // Cancel modifier churn, i.e., a release followed by a press of the
+        // same modifier, neither of which has been sent, so the modifier
+        // just stays down on the host. (The last event can't be the one at
+        // the tail, which may be partially sent.) The opposite case of a
+        // press followed by a release is not cancelled, since a modifier
+        // tapped on its own may mean something to the host.
+        const uint8_t last = key_event_last;
+        if (key_event_queue[last].key == key && key_event_queue[last].is_release) {
+            remove_last_key_event();
+            count_queue_event(coalesced);
+            return;
+        }
+    }
     if (!is_key_event_queue_full) {
-        key_event_queue[key_event_head].key = key;
-        key_event_queue[key_event_head].is_release = false;
-        increment_key_event_queue();
+        queue_key_event(key, false);
+    } else {
+        count_queue_event(dropped);
     }
 }
 
 void
 ps2_release_key (const uint8_t key) {
+    if (deferred_release_count) {
+        requeue_deferred_releases();
+    }
     if (!is_key_event_queue_full) {
-        key_event_queue[key_event_head].key = key;
-        key_event_queue[key_event_head].is_release = true;
-        increment_key_event_queue();
+        queue_key_event(key, true);
+    } else if (deferred_release_count < PS2_OUTPUT_MAX_DEFERRED_RELEASES) {
+        // Never drop a release if we can help it, since the key would then
+        // be stuck down on the host. Hold it back until there is room.
+        deferred_releases[deferred_release_count++] = key;
+        count_queue_event(deferred);
+    } else {
+        count_queue_event(dropped);
+        is_release_resync_pending = true;
     }
 }
 
+const struct ps2_output_queue_counters *
+ps2_output_queue_counters (void) {
+    return &queue_counters;
+}
+
+/// Queue a release of every key the host believes is down, to recover from
+/// dropped releases. This must only be called when the key event queue and
+/// the deferred releases are empty, so that nothing is released twice.
+static void
+resync_dropped_releases (void) {
+    for (uint_fast16_t key = 1; key < 8U * sizeof(host_keys_down); ++key) {
+        if (is_host_key_down(key)) {
+            if (is_key_event_queue_full) {
+                // The rest are released once these have been sent
+                return;
+            }
+            queue_key_event((uint8_t) key, true);
+            count_queue_event(resynced);
+        }
+    }
+    is_release_resync_pending = false;
+}
+
 // MARK: - Special Key Events
 
 static void
@@ -1211,6 +1412,46 @@ read_and_process_cmd (void) {
 
 // MARK: - Main Loop Task
 
+#if ENABLE_PS2_DEVICE_TIMER
+/// The most bytes that a key press or release is sent as, other than Pause
+/// (F13-F24 in set 3 with the added Shift are 4).
+#define PS2_PLAIN_EVENT_MAX_BYTES       4
+
+/// The most bytes that the Pause press is sent as.
+#define PS2_PAUSE_EVENT_MAX_BYTES       8
+
+/// The most bytes sent before any key event to end the legacy virtual shift
+/// or to restore the suppressed shifts (only one of these can be active).
+#define PS2_LEGACY_RESTORE_MAX_BYTES    4
+
+/// The most bytes sent around the keys that suppress the shifts or turn on
+/// the virtual shift (both shifts released).
+#define PS2_LEGACY_SUPPRESS_MAX_BYTES   6
+
+/// Returns the most bytes that the key event `key` can be sent as in the
+/// current state. The next event is only encoded while the previous ones are
+/// still being sent if the device output buffer has room for this many.
+static inline uint8_t
+key_event_max_bytes (const uint8_t key) {
+    uint8_t max_bytes = (key == USB_KEY_PAUSE_BREAK) ? PS2_PAUSE_EVENT_MAX_BYTES : PS2_PLAIN_EVENT_MAX_BYTES;
+#if ENABLE_PS2_LEGACY_COMPATIBILITY
+    if (ps2_output_flags & (FLAG_SHIFT_VIRTUAL_ON | FLAG_SHIFT_SUPPRESSED_LEFT | FLAG_SHIFT_SUPPRESSED_RIGHT)) {
+        max_bytes += PS2_LEGACY_RESTORE_MAX_BYTES;
+    }
+    if (is_tenkey_cluster_key(key) || key == USB_KEY_PRINT_SCREEN || key == USB_KEY_KP_DIVIDE) {
+        max_bytes += PS2_LEGACY_SUPPRESS_MAX_BYTES;
+    }
+#endif
+    return max_bytes;
+}
+
+/// Is there room in the device output buffer for the next key event? An
+/// event is always added to an empty buffer.
+#define has_room_for_next_key_event() \
+    (!ps2_device_has_pending_output() \
+        || ps2_device_output_space() >= key_event_max_bytes(key_event_queue[key_event_tail].key))
+#endif
+
 void
 ps2_output_task (void) {
     if (!(ps2_output_flags & FLAG_OUTPUT_INITIALIZED)) {
@@ -1227,37 +1468,61 @@ ps2_output_task (void) {
         }
     }
 
-    if (!pending_cmd && ps2_device_flush()) {
-        // No unsent output or in-progress command
+    if (pending_cmd) {
+        return;
+    }
 
-        if (is_key_event_queue_empty) {
-            // No queued events, check for repeats
-            process_repeat();
-            (void) ps2_device_flush();
-        } else {
-            int_fast8_t sent_events = 0;
-            do {
-                const uint8_t key = key_event_queue[key_event_tail].key;
-                if (key == KEY_EVENT_SPECIAL) {
-                    handle_special_key_event(key_event_queue[key_event_tail].is_release);
-                    goto remove_key_from_queue;
-                } else if (key_event_queue[key_event_tail].is_release) {
-                    ps2_send_key_release(key);
-                } else {
-                    ps2_send_key_press(key);
-                }
+    const bool is_flushed = ps2_device_flush();
+
+    if (is_flushed && is_key_event_queue_empty) {
+        // No unsent output, in-progress command, or queued events, check
+        // for repeats
+        process_repeat();
+        (void) ps2_device_flush();
+    } else if (!is_key_event_queue_empty) {
+#if ENABLE_PS2_DEVICE_TIMER
+        // The output is sent in the background, so keep adding events while
+        // they fit in the buffer instead of waiting for it to be empty
+        while (!is_key_event_queue_empty && has_room_for_next_key_event()) {
+#else
+        int_fast8_t sent_events = 0;
+        while (is_flushed && sent_events < PS2_OUTPUT_MAX_EVENTS_PER_TASK && !is_key_event_queue_empty) {
+#endif
+            const uint8_t key = key_event_queue[key_event_tail].key;
+            if (key == KEY_EVENT_SPECIAL) {
+                handle_special_key_event(key_event_queue[key_event_tail].is_release);
+                decrement_key_event_queue();
+                continue;
+            } else if (key_event_queue[key_event_tail].is_release) {
+                ps2_send_key_release(key);
+            } else {
+                ps2_send_key_press(key);
+            }
 
-                if (!ps2_device_flush() && read_and_process_cmd()) {
+            if (!ps2_device_flush()) {
+                if (read_and_process_cmd()) {
                     // We were interrupted by a command, leave event in queue
                     break;
                 }
+            }
 
-                ++sent_events;
-            remove_key_from_queue:
-                decrement_key_event_queue();
-            } while (sent_events < PS2_OUTPUT_MAX_EVENTS_PER_TASK && !is_key_event_queue_empty);
+            decrement_key_event_queue();
+#if !ENABLE_PS2_DEVICE_TIMER
+            ++sent_events;
+#endif
         }
     }
+
+#if ENABLE_PS2_DEVICE_TIMER
+    if (deferred_release_count) {
+#else
+    if (is_flushed && deferred_release_count) {
+#endif
+        requeue_deferred_releases();
+    }
+    if (is_release_resync_pending && is_key_event_queue_empty && !deferred_release_count) {
+        resync_dropped_releases();
+    }
 }
 
 // MARK: - External Queries
@@ -1284,7 +1549,7 @@ ps2_output_is_initialized (void) {
 
 bool
 ps2_output_queue_is_clear (void) {
-    return is_key_event_queue_empty;
+    return is_key_event_queue_empty && !deferred_release_count && !is_release_resync_pending;
 }
 
 void
@@ -1293,8 +1558,12 @@ ps2_output_clear_keys (const bool should_discard_unsent_keys) {
     if (should_discard_unsent_keys) {
         key_event_queue_head = 0;
         key_event_queue_tail = 0;
+        deferred_release_count = 0;
         clear_key_state();
     } else {
+        if (deferred_release_count) {
+            requeue_deferred_releases();
+        }
         // Add sentinel after all existing events so cleanup runs
         // after they have all been processed naturally
         if (is_key_event_queue_full) {
@@ -65,6 +65,24 @@ void ps2_press_key(uint8_t usb_keycode);
 /// Queue a key release event (USB keycode) to be sent later.
 void ps2_release_key(uint8_t usb_keycode);
 
+/// Counters of the key event queue, saturating at 255. These are cleared by
+/// `ps2_output_init()`.
+struct ps2_output_queue_counters {
+    /// Events cancelled against an unsent opposite event of the same key.
+    uint8_t coalesced;
+    /// Releases held back because the queue was full.
+    uint8_t deferred;
+    /// Releases queued again once there was room: the held back ones, and
+    /// those of keys still down after a release was dropped.
+    uint8_t resynced;
+    /// Events lost because the queue (and for releases, the deferred
+    /// releases) was full.
+    uint8_t dropped;
+};
+
+/// Returns the key event queue counters.
+const struct ps2_output_queue_counters *ps2_output_queue_counters(void);
+
 /// Clear queued key events and key state.
 /// - Parameter should_discard_unsent_keys: If `true`, the key event queue
 /// is cleared entirely (discard all pending events). If `false`, all events
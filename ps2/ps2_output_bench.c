@@ -0,0 +1,569 @@
+// PS/2 output throughput and latency benchmark.
+//
+// Usage: ps2_output_bench.bin [--clock-hz hz] [--inhibit-us us --inhibit-ms ms]
+//                             [--check baseline.txt] [--threshold percent]
+//
+// Drives `ps2_output.c` with synthetic key event workloads on top of the
+// unit test harness, with the mocked device layer replaced by a model of the
+// bus: each byte is 11 bits at the clock rate, preceded by the bus idle time,
+// and the host may inhibit the clock periodically, which aborts any byte in
+// progress (it is then sent again). Time is modeled, not measured, so the
+// results are deterministic and independent of the machine. Prints one line
+// per workload:
+//
+//      name  events  bytes_per_event  avg_us  max_us  key_queue  out_buffer  stall_us  dropped  aborts
+//
+// The name is suffixed with the scancode set, and `/timer` if built with
+// `ENABLE_PS2_DEVICE_TIMER` (e.g., `typing@2/timer`). The latency is from the
+// key event (as seen by the matrix scan) until its last byte is on the wire.
+// `key_queue` and `out_buffer` are the high-water marks of the key event
+// queue and the unsent device output, `stall_us` is the longest time the main
+// loop spent in `ps2_output_task` (during which it cannot scan the matrix),
+// `dropped` is the number of events lost to a full key event queue, and
+// `aborts` the number of bytes aborted by the host inhibiting the clock.
+//
+// With `--check`, the results are compared against a baseline (the output of
+// a previous run), and the exit status is non-zero if any workload has more
+// latency or stall than the baseline by more than the threshold (default 1 %),
+// or if the bytes per event or dropped events changed at all.
+
+#define PS2_OUTPUT_TEST_NO_MAIN 1
+#include "ps2_output_test.c"
+
+#include <limits.h>
+
+#ifndef PS2_BENCH_CLOCK_HZ
+/// The default clock rate, that of `kk_ps2_device.c` (2 × 39 µs per bit).
+#define PS2_BENCH_CLOCK_HZ 12800
+#endif
+
+/// The time the bus must be idle before the device starts sending.
+#define PS2_BENCH_IDLE_US 50
+
+/// The time the blocking transmitter waits for the bus to become idle.
+#define PS2_BENCH_READY_TIMEOUT_US 200
+
+/// The interval of the main loop (matrix scan).
+#define PS2_BENCH_LOOP_US 1000
+
+/// Give up on a workload if it hasn't finished in this time.
+#define PS2_BENCH_MAX_US 30000000ULL
+
+#define PS2_BENCH_MAX_EVENTS 1024
+
+#if ENABLE_PS2_DEVICE_TIMER
+#define PS2_BENCH_SUFFIX "/timer"
+#else
+#define PS2_BENCH_SUFFIX ""
+#endif
+
+// MARK: - Bus Model
+
+static uint32_t byte_us;
+static uint32_t inhibit_us = 0;
+static uint32_t inhibit_period_us = 0;
+
+/// The modeled time of the main loop.
+static uint64_t now_us = 0;
+
+/// The time the last byte was completely on the wire.
+static uint64_t wire_free_us = 0;
+
+static unsigned long wire_bytes = 0;
+
+/// The number of recent bytes whose completion time is kept.
+#define PS2_BENCH_BYTE_HISTORY 256
+
+/// The time each recent byte was completely on the wire, by byte number.
+static uint64_t byte_done_us[PS2_BENCH_BYTE_HISTORY];
+
+/// The number of bytes on the wire once the event at each key event queue
+/// position is sent, recorded when it is flushed. (`ULONG_MAX` if not.)
+static unsigned long queue_end_byte[256];
+
+/// Record the end byte of the event being sent (at the queue tail).
+static inline void
+record_end_byte (void) {
+    queue_end_byte[key_event_queue_tail] = wire_bytes + (unsigned long) pending_send_count;
+}
+static unsigned long wire_aborts = 0;
+static int max_out_buffer = 0;
+
+enum wire_result {
+    WIRE_SENT,
+    WIRE_INHIBITED,
+    WIRE_ABORTED,
+};
+
+/// Try to send a byte when the device is ready at `ready_us`. The time the
+/// byte is done, the inhibit ends, or the byte is aborted, is in `end_us`.
+static enum wire_result
+wire_try_byte (const uint64_t ready_us, uint64_t *end_us) {
+    const uint64_t start = ready_us + PS2_BENCH_IDLE_US;
+    if (inhibit_period_us) {
+        const uint64_t window = start - (start % inhibit_period_us);
+        if (start < window + inhibit_us) {
+            *end_us = window + inhibit_us;
+            return WIRE_INHIBITED;
+        }
+        if (start + byte_us > window + inhibit_period_us) {
+            *end_us = window + inhibit_period_us;
+            return WIRE_ABORTED;
+        }
+    }
+    *end_us = start + byte_us;
+    return WIRE_SENT;
+}
+
+/// Move the first unsent byte to the wire.
+static void
+wire_commit_byte (void) {
+    if (sent_count < (int) sizeof(sent_buffer)) {
+        sent_buffer[sent_count++] = pending_send_buffer[0];
+    }
+    (void) memmove(pending_send_buffer, pending_send_buffer + 1, (size_t) --pending_send_count);
+    byte_done_us[wire_bytes % PS2_BENCH_BYTE_HISTORY] = wire_free_us;
+    ++wire_bytes;
+}
+
+#if ENABLE_PS2_DEVICE_TIMER
+
+static bool tx_active = false;
+static uint64_t tx_ready_us = 0;
+
+/// Complete the bytes sent in the background by now.
+static void
+wire_catch_up (void) {
+    while (pending_send_count) {
+        if (!tx_active) {
+            tx_active = true;
+            tx_ready_us = (now_us > wire_free_us) ? now_us : wire_free_us;
+        }
+        uint64_t end;
+        const enum wire_result result = wire_try_byte(tx_ready_us, &end);
+        if (end > now_us) {
+            return;
+        }
+        if (result == WIRE_SENT) {
+            wire_free_us = end;
+            wire_commit_byte();
+        } else if (result == WIRE_ABORTED) {
+            ++wire_aborts;
+        }
+        tx_ready_us = end;
+    }
+    tx_active = false;
+}
+
+static bool
+bench_flush (void) {
+    record_end_byte();
+    if (pending_send_count > max_out_buffer) {
+        max_out_buffer = pending_send_count;
+    }
+    wire_catch_up();
+    return pending_send_count == 0;
+}
+
+#else
+
+static inline void
+wire_catch_up (void) {
+}
+
+static bool
+bench_flush (void) {
+    record_end_byte();
+    if (pending_send_count > max_out_buffer) {
+        max_out_buffer = pending_send_count;
+    }
+    while (pending_send_count) {
+        uint64_t end;
+        switch (wire_try_byte(now_us, &end)) {
+        case WIRE_SENT:
+            now_us = end;
+            wire_free_us = end;
+            wire_commit_byte();
+            break;
+        case WIRE_INHIBITED:
+            if (end - now_us > PS2_BENCH_READY_TIMEOUT_US) {
+                now_us += PS2_BENCH_READY_TIMEOUT_US;
+                return false;
+            }
+            now_us = end;
+            break;
+        case WIRE_ABORTED:
+            ++wire_aborts;
+            now_us = end;
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
+
+// MARK: - Workloads
+
+struct bench_event {
+    uint32_t time_us;
+    uint16_t order;
+    uint8_t key;
+    bool is_release;
+};
+
+static struct bench_event events[PS2_BENCH_MAX_EVENTS];
+static int event_count = 0;
+
+static void
+add_event (const uint32_t time_ms, const uint8_t key, const bool is_release) {
+    if (event_count < PS2_BENCH_MAX_EVENTS) {
+        events[event_count] = (struct bench_event) {
+            .time_us = time_ms * 1000UL,
+            .order = (uint16_t) event_count,
+            .key = key,
+            .is_release = is_release,
+        };
+        ++event_count;
+    }
+}
+
+static void
+add_keystroke (const uint32_t time_ms, const uint8_t key, const uint32_t hold_ms) {
+    add_event(time_ms, key, false);
+    add_event(time_ms + hold_ms, key, true);
+}
+
+/// Fast typing: 200 letters 40 ms apart (300 wpm), each held 60 ms so
+/// consecutive keys overlap, and a Shift around every 10th letter.
+static void
+workload_typing (void) {
+    uint32_t t = 1;
+    for (int i = 0; i < 200; ++i, t += 40) {
+        const uint8_t key = (uint8_t) (USB_KEY_A + ((i * 7) % 26));
+        if (i % 10 == 0) {
+            add_keystroke(t, USB_KEY_LEFT_SHIFT, 30);
+            add_keystroke(t + 5, key, 20);
+        } else {
+            add_keystroke(t, key, 60);
+        }
+    }
+}
+
+static const uint8_t chord_keys[] = {
+    USB_KEY_LEFT_CTRL, USB_KEY_LEFT_SHIFT, USB_KEY_LEFT_ALT,
+    USB_KEY_A,         USB_KEY_S,          USB_KEY_D,
+    USB_KEY_F,         USB_KEY_J,          USB_KEY_K,
+    USB_KEY_L,         USB_KEY_RIGHT_ARROW, USB_KEY_HOME,
+};
+
+/// NKRO chords: 12 keys (including extended keys) pressed in the same scan,
+/// held for 50 ms and released in the same scan, 20 times.
+static void
+workload_nkro (void) {
+    for (uint32_t round = 0, t = 1; round < 20; ++round, t += 150) {
+        for (unsigned i = 0; i < sizeof(chord_keys); ++i) {
+            add_keystroke(t, chord_keys[i], 50);
+        }
+    }
+}
+
+/// Pause and Print Screen, which have the longest sequences, alternating
+/// and also with modifiers (which change the sequences).
+static void
+workload_pause (void) {
+    static const uint8_t modifiers[] = { 0, USB_KEY_LEFT_CTRL, USB_KEY_LEFT_ALT, USB_KEY_LEFT_SHIFT };
+    for (uint32_t i = 0, t = 1; i < 40; ++i, t += 60) {
+        const uint8_t modifier = modifiers[(i / 2) % sizeof(modifiers)];
+        const uint8_t key = (i % 2) ? USB_KEY_PRINT_SCREEN : USB_KEY_PAUSE;
+        if (modifier) {
+            add_keystroke(t, modifier, 30);
+            add_keystroke(t + 2, key, 20);
+        } else {
+            add_keystroke(t, key, 20);
+        }
+    }
+}
+
+struct workload {
+    const char *name;
+    void (*generate)(void);
+    uint32_t inhibit_us;
+    uint32_t inhibit_period_ms;
+};
+
+static const struct workload workloads[] = {
+    { "typing", workload_typing, 0, 0 },
+    { "nkro", workload_nkro, 0, 0 },
+    { "pause_prtsc", workload_pause, 0, 0 },
+    // A host that inhibits the clock for 300 µs every 2 ms (e.g., to
+    // process each byte received)
+    { "nkro_inhibit", workload_nkro, 300, 2 },
+};
+
+static int
+compare_events (const void *a, const void *b) {
+    const struct bench_event *x = a;
+    const struct bench_event *y = b;
+    if (x->time_us != y->time_us) {
+        return (x->time_us < y->time_us) ? -1 : 1;
+    }
+    return (int) x->order - (int) y->order;
+}
+
+// MARK: - Running
+
+struct bench_result {
+    int events;
+    int dropped;
+    double bytes_per_event;
+    double avg_us;
+    uint64_t max_us;
+    int max_key_queue;
+    int max_out_buffer;
+    uint64_t max_stall_us;
+    unsigned long aborts;
+};
+
+/// The event time of each queued event, in queue order.
+static uint32_t queued_at[PS2_BENCH_MAX_EVENTS];
+
+/// The time each event was removed from the key event queue.
+static uint64_t consumed_at[PS2_BENCH_MAX_EVENTS];
+
+/// The number of bytes on the wire once each consumed event is sent, i.e.,
+/// its last byte is byte number `consumed_end_byte - 1`.
+static unsigned long consumed_end_byte[PS2_BENCH_MAX_EVENTS];
+
+static bool
+run_workload (const struct workload *workload, const uint8_t set, struct bench_result *result) {
+    event_count = 0;
+    workload->generate();
+    qsort(events, (size_t) event_count, sizeof(*events), compare_events);
+
+    reset();
+    api_set_scancode_set(set);
+
+    mock_flush_hook = bench_flush;
+    now_us = 0;
+    wire_free_us = 0;
+    wire_bytes = 0;
+    wire_aborts = 0;
+    max_out_buffer = 0;
+#if ENABLE_PS2_DEVICE_TIMER
+    tx_active = false;
+#endif
+
+    *result = (struct bench_result) { 0 };
+
+    int next_event = 0;
+    int queued = 0;
+    int consumed = 0;
+    int delivered = 0;
+    uint64_t total_latency = 0;
+    uint8_t last_tail = key_event_queue_tail;
+    uint64_t loop_us = 0;
+
+    while (next_event < event_count || delivered < queued || pending_send_count) {
+        if (now_us > PS2_BENCH_MAX_US) {
+            (void) fprintf(stderr, "%s@%u: did not finish\n", workload->name, set);
+            mock_flush_hook = NULL;
+            return false;
+        }
+        if (now_us < loop_us) {
+            now_us = loop_us;
+        }
+        loop_us = now_us + PS2_BENCH_LOOP_US;
+        mock_timer = (uint16_t) (now_us / 1000);
+
+        wire_catch_up();
+
+        for (; next_event < event_count && events[next_event].time_us <= now_us; ++next_event) {
+            const struct bench_event *event = &events[next_event];
+            const uint8_t head = key_event_queue_head;
+            if (event->is_release) {
+                release_key(event->key);
+            } else {
+                press_key(event->key);
+            }
+            if (key_event_queue_head != head) {
+                queued_at[queued++] = event->time_us;
+            } else {
+                ++result->dropped;
+            }
+        }
+        const int queue_count = (uint8_t) (key_event_queue_head - key_event_queue_tail);
+        if (queue_count > result->max_key_queue) {
+            result->max_key_queue = queue_count;
+        }
+
+        for (int i = 0; i < (int) (sizeof(queue_end_byte) / sizeof(*queue_end_byte)); ++i) {
+            queue_end_byte[i] = ULONG_MAX;
+        }
+        const uint64_t task_start = now_us;
+        ps2_output_task();
+        if (now_us - task_start > result->max_stall_us) {
+            result->max_stall_us = now_us - task_start;
+        }
+
+        // Each event is sent once the bytes up to its flush are, and an
+        // event without bytes once the previous ones are
+        unsigned long end_byte = consumed ? consumed_end_byte[consumed - 1] : 0;
+        for (; last_tail != key_event_queue_tail; ++last_tail) {
+            if (queue_end_byte[last_tail] != ULONG_MAX) {
+                end_byte = queue_end_byte[last_tail];
+            }
+            consumed_end_byte[consumed] = end_byte;
+            consumed_at[consumed++] = now_us;
+        }
+
+        // An event is delivered once its last byte is on the wire
+        for (; delivered < consumed && consumed_end_byte[delivered] <= wire_bytes; ++delivered) {
+            uint64_t done = consumed_at[delivered];
+            if (consumed_end_byte[delivered] > 0) {
+                const uint64_t last_byte_us = byte_done_us[(consumed_end_byte[delivered] - 1) % PS2_BENCH_BYTE_HISTORY];
+                if (last_byte_us > done) {
+                    done = last_byte_us;
+                }
+            }
+            const uint64_t latency = done - queued_at[delivered];
+            total_latency += latency;
+            if (latency > result->max_us) {
+                result->max_us = latency;
+            }
+        }
+    }
+
+    mock_flush_hook = NULL;
+
+    result->events = queued;
+    result->bytes_per_event = queued ? (double) wire_bytes / queued : 0.0;
+    result->avg_us = queued ? (double) total_latency / queued : 0.0;
+    result->max_out_buffer = max_out_buffer;
+    result->aborts = wire_aborts;
+    return true;
+}
+
+// MARK: - Baseline
+
+static bool
+find_baseline (FILE *file, const char *name, struct bench_result *baseline) {
+    char line[256];
+    rewind(file);
+    while (fgets(line, sizeof(line), file)) {
+        char line_name[64];
+        unsigned long max_us, stall_us;
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%63s %d %lf %lf %lu %d %d %lu %d %lu", line_name, &baseline->events,
+                   &baseline->bytes_per_event, &baseline->avg_us, &max_us, &baseline->max_key_queue,
+                   &baseline->max_out_buffer, &stall_us, &baseline->dropped, &baseline->aborts)
+                == 10
+            && strcmp(line_name, name) == 0) {
+            baseline->max_us = max_us;
+            baseline->max_stall_us = stall_us;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool
+exceeds (const double value, const double baseline, const double threshold) {
+    return value > baseline + (baseline * threshold) / 100.0 + 0.05;
+}
+
+int
+main (int argc, char **argv) {
+    const char *baseline_path = NULL;
+    double threshold = 1.0;
+    unsigned long clock_hz = PS2_BENCH_CLOCK_HZ;
+    long override_inhibit_us = -1;
+    unsigned long override_inhibit_ms = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--clock-hz") == 0 && i + 1 < argc) {
+            clock_hz = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--inhibit-us") == 0 && i + 1 < argc) {
+            override_inhibit_us = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--inhibit-ms") == 0 && i + 1 < argc) {
+            override_inhibit_ms = strtoul(argv[++i], NULL, 10);
+        } else {
+            (void) fprintf(stderr,
+                           "Usage: %s [--clock-hz hz] [--inhibit-us us --inhibit-ms ms]\n"
+                           "       [--check baseline.txt] [--threshold percent]\n",
+                           argv[0]);
+            return 2;
+        }
+    }
+    if (clock_hz < 1000 || clock_hz > 100000) {
+        (void) fprintf(stderr, "Clock rate must be 1000 to 100000 Hz\n");
+        return 2;
+    }
+    byte_us = (uint32_t) ((11UL * 1000000UL + clock_hz / 2) / clock_hz);
+
+    FILE *baseline = NULL;
+    if (baseline_path && !(baseline = fopen(baseline_path, "r"))) {
+        perror(baseline_path);
+        return 2;
+    }
+
+    int failures = 0;
+    for (unsigned w = 0; w < sizeof(workloads) / sizeof(*workloads); ++w) {
+        const struct workload *workload = &workloads[w];
+        inhibit_us = workload->inhibit_us;
+        inhibit_period_us = workload->inhibit_period_ms * 1000UL;
+        if (override_inhibit_us >= 0) {
+            inhibit_us = (uint32_t) override_inhibit_us;
+            inhibit_period_us = inhibit_us ? override_inhibit_ms * 1000UL : 0;
+        }
+        if (inhibit_period_us && inhibit_us + PS2_BENCH_IDLE_US + byte_us >= inhibit_period_us) {
+            (void) fprintf(stderr, "Inhibit period too short to send any bytes\n");
+            return 2;
+        }
+
+        for (uint8_t set = 1; set <= 3; ++set) {
+            struct bench_result result;
+            char name[64];
+            (void) snprintf(name, sizeof(name), "%s@%u%s", workload->name, set, PS2_BENCH_SUFFIX);
+            if (!run_workload(workload, set, &result)) {
+                ++failures;
+                continue;
+            }
+            (void) printf("%-20s %4d %7.3f %8.1f %6lu %3d %3d %6lu %3d %4lu", name, result.events,
+                          result.bytes_per_event, result.avg_us, (unsigned long) result.max_us,
+                          result.max_key_queue, result.max_out_buffer,
+                          (unsigned long) result.max_stall_us, result.dropped, result.aborts);
+
+            struct bench_result base;
+            if (baseline && find_baseline(baseline, name, &base)) {
+                const bool regressed = exceeds(result.avg_us, base.avg_us, threshold)
+                    || exceeds((double) result.max_us, (double) base.max_us, threshold)
+                    || exceeds((double) result.max_stall_us, (double) base.max_stall_us, threshold)
+                    || result.bytes_per_event - base.bytes_per_event > 0.0005
+                    || base.bytes_per_event - result.bytes_per_event > 0.0005
+                    || result.dropped != base.dropped;
+                if (regressed) {
+                    ++failures;
+                }
+                (void) printf("  (baseline %.1f/%lu us)%s", base.avg_us, (unsigned long) base.max_us,
+                              regressed ? "  REGRESSION" : "");
+            } else if (baseline) {
+                (void) printf("  (no baseline)");
+            }
+            (void) printf("\n");
+        }
+    }
+
+    if (baseline) {
+        (void) fclose(baseline);
+        if (failures) {
+            (void) printf("\n%d workload(s) regressed beyond %.0f %% of baseline\n", failures, threshold);
+        }
+    }
+    return failures ? 1 : 0;
+}
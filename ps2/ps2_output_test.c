@@ -119,13 +119,70 @@ ps2_device_send (const uint8_t data) {
     return false;
 }
 
+#if ENABLE_PS2_DEVICE_TIMER
+// Mock of the repeat sent by the device timer interrupt: the due repeat is
+// sent when `process_repeat()` starts or resumes it, i.e., when the main loop
+// has no other output. (The timing is tested in `kk_ps2_device_test.c`.)
+static uint8_t mock_repeat_scancode = 0;
+static bool mock_repeat_is_extended = false;
+static bool mock_repeat_is_paused = false;
+static uint16_t mock_repeat_due = 0;
+static uint16_t mock_repeat_period = 0;
+
+static void
+mock_send_due_repeat (void) {
+    if (!mock_repeat_scancode || mock_repeat_is_paused || pending_send_count
+        || (int16_t) (mock_timer - mock_repeat_due) < 0) {
+        return;
+    }
+    mock_repeat_due += mock_repeat_period;
+    if ((int16_t) (mock_timer - mock_repeat_due) >= 0) {
+        mock_repeat_due = mock_timer + mock_repeat_period;
+    }
+    if (mock_repeat_is_extended) {
+        sent_buffer[sent_count++] = PS2_EXT_PREFIX;
+    }
+    sent_buffer[sent_count++] = mock_repeat_scancode;
+}
+
+void
+ps2_device_start_repeat (
+    const uint8_t scancode, const bool is_extended, const uint16_t due_ms, const uint16_t period_ms) {
+    mock_repeat_scancode = scancode;
+    mock_repeat_is_extended = is_extended;
+    mock_repeat_due = due_ms;
+    mock_repeat_period = period_ms;
+    mock_repeat_is_paused = false;
+    mock_send_due_repeat();
+}
+
+void
+ps2_device_resume_repeat (const uint16_t period_ms) {
+    mock_repeat_period = period_ms;
+    mock_repeat_is_paused = false;
+    mock_send_due_repeat();
+}
+
+void
+ps2_device_stop_repeat (void) {
+    mock_repeat_scancode = 0;
+}
+#endif
+
 static bool ps2_device_flush_returns_false = false;
+
+/// If set, replaces the instant flush (the benchmark models the bus timing).
+static bool (*mock_flush_hook)(void) = NULL;
+
 bool
 ps2_device_flush (void) {
     if (ps2_device_flush_returns_false) {
         ps2_device_flush_returns_false = false;
         return false;
     }
+    if (mock_flush_hook) {
+        return mock_flush_hook();
+    }
     for (int i = 0; i < pending_send_count; ++i) {
         if (sent_count < (int) sizeof(sent_buffer)) {
             sent_buffer[sent_count++] = pending_send_buffer[i];
@@ -140,6 +197,14 @@ ps2_device_has_pending_output (void) {
     return pending_send_count > 0;
 }
 
+/// The output buffer size reported by the mock, that of `kk_ps2_device.c`.
+#define MOCK_OUTPUT_BUFFER_SIZE 16
+
+uint16_t
+ps2_device_output_space (void) {
+    return pending_send_count < MOCK_OUTPUT_BUFFER_SIZE ? MOCK_OUTPUT_BUFFER_SIZE - pending_send_count : 0;
+}
+
 void
 ps2_device_resend (void) {
     if (mock_last_tx) {
@@ -161,6 +226,9 @@ ps2_device_recv (void) {
     if (recv_head == recv_tail) {
         return EOF;
     }
+#if ENABLE_PS2_DEVICE_TIMER
+    mock_repeat_is_paused = true;
+#endif
     int data = recv_queue[recv_head];
     recv_head = (recv_head + 1) % (int) sizeof(recv_queue);
     return data;
@@ -370,6 +438,27 @@ expect_repeat_line (uint8_t key, bool should_repeat, const char *msg, int line)
     clear_sent();
 }
 
+static void
+expect_true_line (bool ok, const char *msg, int line) {
+    tests_run++;
+    if (!ok) {
+        tests_failed++;
+        (void) printf("FAIL %d: %s\n", line, msg);
+    } else if (verbose) {
+        (void) printf("PASS %s\n", msg);
+    }
+}
+
+static bool
+sent_contains (uint8_t byte) {
+    for (int i = 0; i < sent_count; ++i) {
+        if (sent_buffer[i] == byte) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static void
 api_set_scancode_set (uint8_t set) {
     queue_recv(PS2_COMMAND_SET_SCAN_CODES);
@@ -410,6 +499,7 @@ api_all_keys_typematic (void) {
 #define expect_none(m)            expect_none_line(m, __LINE__)
 #define expect_none_release(k, m) expect_none_release_line(k, m, __LINE__)
 #define expect_repeat(k, r, m)    expect_repeat_line(k, r, m, __LINE__)
+#define expect_true(c, m)         expect_true_line(c, m, __LINE__)
 
 /// S2 KEY - basic alpha key make/break
 static void
@@ -3954,6 +4044,249 @@ test_set2_model_m_two_tenkeys_plus_printscreen_deferred_teardown (void) {
 #endif
 }
 
+// MARK: - Key Event Queue
+
+/// Fill the key event queue with presses of A, B, C…
+static void
+fill_key_event_queue (void) {
+    for (uint8_t i = 0; i < PS2_OUTPUT_MAX_KEY_EVENTS; ++i) {
+        press_key(USB_KEY_A + i);
+    }
+}
+
+static void
+test_queue_modifier_churn_is_coalesced (void) {
+    press_key(USB_KEY_LEFT_SHIFT);
+    drain_all();
+    clear_sent();
+
+    press_key(USB_KEY_A);
+    release_key(USB_KEY_LEFT_SHIFT);
+    press_key(USB_KEY_LEFT_SHIFT);
+    release_key(USB_KEY_A);
+    uint8_t exp[] = { 0x1C, 0xF0, 0x1C };
+    check_result(exp, 3, "Unsent Shift release + press cancelled");
+    expect_true(ps2_output_queue_counters()->coalesced == 1, "coalesced counted");
+}
+
+static void
+test_queue_modifier_tap_is_sent (void) {
+    press_key(USB_KEY_A);
+    press_key(USB_KEY_LEFT_SHIFT);
+    release_key(USB_KEY_LEFT_SHIFT);
+    release_key(USB_KEY_A);
+    uint8_t exp[] = { 0x1C, 0x12, 0xF0, 0x12, 0xF0, 0x1C };
+    check_result(exp, 6, "Shift tap is not cancelled");
+    expect_true(ps2_output_queue_counters()->coalesced == 0, "nothing coalesced");
+}
+
+static void
+test_queue_overflow_defers_release (void) {
+    fill_key_event_queue();
+    release_key(USB_KEY_A);
+    press_key(USB_KEY_Q);
+    expect_true(ps2_output_queue_counters()->deferred == 1, "release deferred");
+    expect_true(ps2_output_queue_counters()->dropped == 1, "press dropped");
+    expect_true(!ps2_output_queue_is_clear(), "deferred release is pending");
+
+    drain_all();
+    expect_true(sent_count == PS2_OUTPUT_MAX_KEY_EVENTS + 2 && sent_buffer[sent_count - 2] == 0xF0
+            && sent_buffer[sent_count - 1] == 0x1C && !sent_contains(0x15),
+        "deferred release sent last, dropped press not sent");
+    expect_true(ps2_output_queue_counters()->resynced == 1, "release resynced");
+    expect_true(ps2_output_queue_is_clear(), "queue clear after drain");
+}
+
+static void
+test_queue_overflow_press_cancels_deferred_release (void) {
+    fill_key_event_queue();
+    release_key(USB_KEY_A);
+    press_key(USB_KEY_A);
+    expect_true(ps2_output_queue_counters()->coalesced == 1, "deferred release cancelled");
+    drain_all();
+    expect_true(sent_count == PS2_OUTPUT_MAX_KEY_EVENTS && !sent_contains(0xF0), "only the presses sent");
+    clear_sent();
+
+    uint8_t exp[] = { 0xF0, 0x1C };
+    release(USB_KEY_A, exp, 2, "A still down on host, released normally");
+}
+
+static void
+test_queue_dropped_release_resyncs_keys_down (void) {
+    press_key(USB_KEY_Z);
+    drain_all();
+    clear_sent();
+
+    fill_key_event_queue();
+    for (uint8_t i = 0; i <= PS2_OUTPUT_MAX_DEFERRED_RELEASES; ++i) {
+        release_key(USB_KEY_A + i);
+    }
+    drain_all();
+    // The presses of A…P, the deferred releases of A…F, then the resync
+    // releases of the keys still down, including G whose release was dropped
+    const int resync_start = PS2_OUTPUT_MAX_KEY_EVENTS + 2 * PS2_OUTPUT_MAX_DEFERRED_RELEASES;
+    expect_true(sent_count > resync_start + 1 && sent_buffer[resync_start] == 0xF0
+            && sent_buffer[resync_start + 1] == 0x34,
+        "dropped G release sent on resync");
+    int releases = 0;
+    for (int i = resync_start; i < sent_count; ++i) {
+        releases += (sent_buffer[i] == 0xF0);
+    }
+    expect_true(releases == PS2_OUTPUT_MAX_KEY_EVENTS - PS2_OUTPUT_MAX_DEFERRED_RELEASES + 1,
+        "resync releases every key down on the host once");
+    expect_true(ps2_output_queue_counters()->dropped == 1, "release dropped");
+    expect_true(ps2_output_queue_counters()->resynced == PS2_OUTPUT_MAX_DEFERRED_RELEASES + releases,
+        "deferred and resync releases counted");
+    expect_true(ps2_output_queue_is_clear(), "queue clear after resync");
+    clear_sent();
+}
+
+static void
+test_queue_discard_clears_deferred_releases (void) {
+    fill_key_event_queue();
+    release_key(USB_KEY_A);
+    ps2_output_clear_keys(true);
+    expect_true(ps2_output_queue_is_clear(), "discarded");
+    expect_none("Nothing sent after discarding");
+}
+
+// MARK: - Typematic Repeat Timing
+
+/// The maximum simulated main loop iteration time (ms) under load.
+#define SIMULATED_LOAD_MAX_MS 9
+
+/// Hold A with the main loop taking 1 to `SIMULATED_LOAD_MAX_MS` ms per
+/// iteration: each repeat must be sent no later than one iteration after it
+/// was due, i.e., the latency must not accumulate into the rate.
+static void
+test_repeat_jitter_under_load (void) {
+    api_set_repeat_rate(0x00);
+    const uint16_t delay = decode_repeat_delay_ms(repeat_rate);
+    const uint16_t period = decode_repeat_period_ms(repeat_rate);
+    uint8_t mk_a[] = { 0x1C };
+    mock_timer = 0;
+    press(USB_KEY_A, mk_a, 1, "Jitter: A make");
+
+    enum { REPEATS = 64 };
+    uint16_t sent_at[REPEATS];
+    int repeats = 0;
+    uint32_t seed = 1;
+    bool one_at_a_time = true;
+    while (repeats < REPEATS && mock_timer < delay + (REPEATS + 1) * period) {
+        seed = seed * 1103515245U + 12345U;
+        mock_timer += 1 + (seed >> 16) % SIMULATED_LOAD_MAX_MS;
+        ps2_output_task();
+        if (sent_count) {
+            one_at_a_time = one_at_a_time && sent_count == 1 && sent_buffer[0] == 0x1C;
+            sent_at[repeats++] = mock_timer;
+            clear_sent();
+        }
+    }
+    expect_true(repeats == REPEATS, "Jitter: all repeats sent");
+    expect_true(one_at_a_time, "Jitter: one repeat at a time");
+
+    int max_late = 0;
+    for (int i = 0; i < repeats; ++i) {
+        const int late = (int) (uint16_t) (sent_at[i] - (delay + i * period));
+        if (late > max_late) {
+            max_late = late;
+        }
+    }
+    if (verbose) {
+        (void) printf("Jitter: period %u ms, max latency %d ms\n", period, max_late);
+    }
+    expect_true(max_late < SIMULATED_LOAD_MAX_MS, "Jitter: latency bounded by one iteration");
+    const int total = (uint16_t) (sent_at[repeats - 1] - sent_at[0]);
+    expect_true(abs(total - (repeats - 1) * period) < SIMULATED_LOAD_MAX_MS,
+        "Jitter: average interval is the decoded period");
+
+    uint8_t brk_a[] = { 0xF0, 0x1C };
+    release(USB_KEY_A, brk_a, 2, "Jitter: A break");
+}
+
+// MARK: - Background Output
+
+#if ENABLE_PS2_DEVICE_TIMER
+static bool
+mock_flush_keeps_pending (void) {
+    return false;
+}
+#endif
+
+/// While the previous events are still being sent in the background, the
+/// next ones are added to the output buffer as long as they fit.
+static void
+test_timer_queues_events_while_sending (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    mock_flush_hook = mock_flush_keeps_pending;
+    ps2_press_key(USB_KEY_A);
+    ps2_press_key(USB_KEY_B);
+    ps2_press_key(USB_KEY_C);
+    ps2_output_task();
+    expect_true(pending_send_count == 3, "Background: all presses in the buffer");
+    expect_true(ps2_output_queue_is_clear(), "Background: key event queue empty");
+
+    // Fill the buffer so that the next release doesn't fit
+    for (int i = 0; i < MOCK_OUTPUT_BUFFER_SIZE - 3 - (PS2_PLAIN_EVENT_MAX_BYTES - 1); ++i) {
+        (void) ps2_device_send(0x00);
+    }
+    ps2_release_key(USB_KEY_A);
+    ps2_output_task();
+    expect_true(!ps2_output_queue_is_clear(), "Background: release waits for room");
+    // The buffer has been sent
+    mock_flush_hook = NULL;
+    pending_send_count = 0;
+    sent_count = 0;
+    uint8_t brk_a[] = { 0xF0, 0x1C };
+    check_result(brk_a, 2, "Background: release sent once there is room");
+    ps2_release_key(USB_KEY_B);
+    ps2_release_key(USB_KEY_C);
+    drain_all();
+    clear_sent();
+#endif
+}
+
+/// `key_event_max_bytes` must cover every key in every set and legacy state,
+/// otherwise the output buffer could overflow in the middle of an event.
+static void
+test_timer_event_max_bytes_covers_every_key (void) {
+#if ENABLE_PS2_DEVICE_TIMER
+    static const uint8_t shift_states[] = { 0, SHIFT_BIT, RIGHT_SHIFT_BIT, SHIFT_BIT | RIGHT_SHIFT_BIT };
+    bool ok = true;
+    for (uint8_t set = 1; set <= 3; ++set) {
+        api_set_scancode_set(set);
+        for (int leds = 0; leds <= PS2_LED_NUM_LOCK_BIT; leds += PS2_LED_NUM_LOCK_BIT) {
+            api_set_leds((uint8_t) leds);
+            for (size_t shifts = 0; shifts < sizeof(shift_states); ++shifts) {
+                for (int key = 1; key <= USB_KEY_RIGHT_GUI; ++key) {
+                    ps2_modifiers = shift_states[shifts];
+                    uint8_t max_bytes = key_event_max_bytes((uint8_t) key);
+                    ps2_send_key_press((uint8_t) key);
+                    int bytes = pending_send_count;
+                    ps2_device_clear_output();
+                    if (bytes > max_bytes) {
+                        ok = false;
+                        (void) printf("Set %u key %02X press: %d > %u bytes\n", set, key, bytes, max_bytes);
+                    }
+                    max_bytes = key_event_max_bytes((uint8_t) key);
+                    ps2_send_key_release((uint8_t) key);
+                    bytes = pending_send_count;
+                    ps2_device_clear_output();
+                    if (bytes > max_bytes) {
+                        ok = false;
+                        (void) printf("Set %u key %02X release: %d > %u bytes\n", set, key, bytes, max_bytes);
+                    }
+                    clear_key_state();
+                }
+            }
+        }
+    }
+    expect_true(ok, "Background: max bytes per event covers every key");
+    clear_repeat();
+    clear_sent();
+#endif
+}
+
 /// Reset the state. Run automatically before each test, do not call manually.
 /// This must set everything to a fresh state, blank slate for the next test.
 static void
@@ -3976,9 +4309,14 @@ reset (void) {
     mock_last_tx = 0;
     ps2_device_send_fail_count = 0;
     ps2_device_flush_returns_false = false;
+#if ENABLE_PS2_DEVICE_TIMER
+    mock_repeat_scancode = 0;
+#endif
     clear_recv();
     clear_sent();
     // tests_run and tests_failed accumulate across tests
 }
 
+#ifndef PS2_OUTPUT_TEST_NO_MAIN
 #include "test_runner.c"
+#endif
@@ -0,0 +1,64 @@
+// USB to PS/2 scancode lookup micro-benchmark.
+//
+// Usage: usb2ps2_keys_bench.bin
+//
+// Times `ps2_scancode_for_usb_keycode` and `is_extended_ps2_key` (as done
+// for each key event) against the previous implementation in
+// `usb2ps2_keys_reference.c`, for every keycode in each set, and prints
+// one line per set:
+//
+//      set  reference_ns_per_lookup  flat_ns_per_lookup
+//
+// This is measured on the host, so it only shows the relative difference;
+// on AVR the set 1 translation and range checks cost more in comparison.
+
+#define USB2PS2_KEYS_TEST_NO_MAIN 1
+#include "usb2ps2_keys_test.c"
+
+#include <time.h>
+
+#ifndef BENCH_ROUNDS
+/// The number of rounds over all keycodes, the fastest is reported.
+#define BENCH_ROUNDS 2000
+#endif
+
+static inline uint64_t
+now_ns (void) {
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/// Prevent the compiler from optimizing away the lookups.
+static volatile uint8_t sink;
+
+static double
+bench_lookups (uint8_t (*scancode)(uint8_t, uint8_t), bool (*is_extended)(uint8_t, uint8_t),
+               const uint8_t set) {
+    uint64_t best = UINT64_MAX;
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        uint8_t acc = 0;
+        const uint64_t start = now_ns();
+        for (int key = 0; key <= UINT8_MAX; ++key) {
+            acc ^= scancode((uint8_t) key, set);
+            acc += is_extended((uint8_t) key, set) ? 1 : 0;
+        }
+        const uint64_t elapsed = now_ns() - start;
+        sink = acc;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return (double) best / (UINT8_MAX + 1);
+}
+
+int
+main (void) {
+    for (uint8_t set = 1; set <= 3; ++set) {
+        const double reference
+            = bench_lookups(reference_scancode_for_usb_keycode, reference_is_extended_ps2_key, set);
+        const double flat = bench_lookups(ps2_scancode_for_usb_keycode, is_extended_ps2_key, set);
+        (void) printf("set%u %8.2f %8.2f\n", set, reference, flat);
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+/**
+ * usb2ps2_keys_test.c: Equivalence tests for the USB to PS/2 scancode tables.
+ *
+ * The `main()` is generated automatically by running every function in this
+ * file with a name starting `test_`.
+ *
+ * The flat per-set tables in `usb2ps2_keys.c` must give exactly the same
+ * results as the previous lookup in `usb2ps2_keys_reference.c` for every
+ * keycode and set. The Makefile builds this with different configurations,
+ * since the tables depend on the enabled sets and media keys.
+ */
+#define KK_KEYCODES_INCLUDE_DUPLICATES 1
+
+#ifndef ENABLE_PS2_DEVICE
+#define ENABLE_PS2_DEVICE 1
+#endif
+#ifndef ENABLE_PS2_DEVICE_SET_1
+#define ENABLE_PS2_DEVICE_SET_1 1
+#endif
+#ifndef ENABLE_PS2_DEVICE_SET_3
+#define ENABLE_PS2_DEVICE_SET_3 1
+#endif
+#ifndef ENABLE_MEDIA_KEYS
+#define ENABLE_MEDIA_KEYS 1
+#endif
+#if ENABLE_MEDIA_KEYS && !defined(MEDIA_KEYS_COUNT)
+#define MEDIA_KEYS_COUNT 7
+#endif
+
+#define PROGMEM
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ps2/usb2ps2_keys_reference.c"
+#include "ps2/usb2ps2_keys.c"
+
+static int tests_run = 0;
+static int tests_failed = 0;
+static int verbose = 0;
+
+/// Compare the scancodes of every keycode in `set` against the reference.
+static void
+check_scancodes (const uint8_t set) {
+    int mismatches = 0;
+    for (int key = 0; key <= UINT8_MAX; ++key) {
+        const uint8_t expected = reference_scancode_for_usb_keycode((uint8_t) key, set);
+        const uint8_t actual = ps2_scancode_for_usb_keycode((uint8_t) key, set);
+        if (expected != actual) {
+            if (mismatches++ < 5) {
+                (void) printf("FAIL set %u key %02X: scancode %02X, expected %02X\n", set, key, actual,
+                    expected);
+            }
+        }
+    }
+    tests_run++;
+    if (mismatches) {
+        tests_failed++;
+    } else if (verbose) {
+        (void) printf("PASS set %u scancodes\n", set);
+    }
+}
+
+/// Compare the E0 prefix of every keycode in `set` against the reference.
+static void
+check_extended (const uint8_t set) {
+    int mismatches = 0;
+    for (int key = 0; key <= UINT8_MAX; ++key) {
+        const bool expected = reference_is_extended_ps2_key((uint8_t) key, set);
+        const bool actual = is_extended_ps2_key((uint8_t) key, set);
+        if (expected != actual) {
+            if (mismatches++ < 5) {
+                (void) printf("FAIL set %u key %02X: extended %d, expected %d\n", set, key, actual,
+                    expected);
+            }
+        }
+    }
+    tests_run++;
+    if (mismatches) {
+        tests_failed++;
+    } else if (verbose) {
+        (void) printf("PASS set %u extended\n", set);
+    }
+}
+
+static void
+test_set1_scancodes (void) {
+    check_scancodes(1);
+}
+
+static void
+test_set2_scancodes (void) {
+    check_scancodes(2);
+}
+
+static void
+test_set3_scancodes (void) {
+    check_scancodes(3);
+}
+
+static void
+test_invalid_set_scancodes (void) {
+    check_scancodes(0);
+    check_scancodes(4);
+}
+
+static void
+test_set1_extended (void) {
+    check_extended(1);
+}
+
+static void
+test_set2_extended (void) {
+    check_extended(2);
+}
+
+static void
+test_set3_extended (void) {
+    check_extended(3);
+}
+
+static void
+test_invalid_set_extended (void) {
+    check_extended(0);
+    check_extended(4);
+}
+
+static void
+test_known_keys (void) {
+    // Spot check against the scancode sets themselves, so the test doesn't
+    // only compare two implementations with each other
+    const struct {
+        uint8_t key;
+        uint8_t set;
+        uint8_t scancode;
+        bool is_extended;
+    } known[] = {
+        { USB_KEY_A, 2, 0x1C, false },
+        { USB_KEY_RIGHT_ARROW, 2, 0x74, true },
+        { USB_KEY_KP_ENTER, 2, 0x5A, true },
+        { USB_KEY_RIGHT_CTRL, 2, 0x14, true },
+#if ENABLE_PS2_DEVICE_SET_1
+        { USB_KEY_A, 1, 0x1E, false },
+        { USB_KEY_RIGHT_ARROW, 1, 0x4D, true },
+        { USB_KEY_F7, 1, 0x41, false },
+#endif
+#if ENABLE_PS2_DEVICE_SET_3
+        { USB_KEY_A, 3, 0x1C, false },
+        { USB_KEY_RIGHT_ARROW, 3, 0x6A, false },
+        { USB_KEY_RIGHT_CTRL, 3, 0x58, false },
+#endif
+    };
+    for (unsigned i = 0; i < sizeof(known) / sizeof(*known); ++i) {
+        const uint8_t scancode = ps2_scancode_for_usb_keycode(known[i].key, known[i].set);
+        const bool is_extended = is_extended_ps2_key(known[i].key, known[i].set);
+        tests_run++;
+        if (scancode != known[i].scancode || is_extended != known[i].is_extended) {
+            tests_failed++;
+            (void) printf("FAIL set %u key %02X: got %s%02X, expected %s%02X\n", known[i].set,
+                known[i].key, is_extended ? "E0 " : "", scancode, known[i].is_extended ? "E0 " : "",
+                known[i].scancode);
+        } else if (verbose) {
+            (void) printf("PASS set %u key %02X\n", known[i].set, known[i].key);
+        }
+    }
+}
+
+/// Reset the state. Run automatically before each test.
+static void
+reset (void) {
+}
+
+#ifndef USB2PS2_KEYS_TEST_NO_MAIN
+#include "keys_test_runner.c"
+#endif
@@ -38,6 +38,7 @@
 
 #include "led.h"
 #include "kk_ps2_host.h"
+#include "ps2_decoder.h"
 #define KK_KEYCODES_INCLUDE_DUPLICATES 1
 #include "ps2_keys.h"
 #include "ps2usb_keys.h"
@@ -55,27 +56,13 @@ static uint8_t scancode_set = 2;
 static volatile uint8_t kbd_error_count = 0;
 static bool error_handled = false;
 static volatile uint8_t kbd_idle_10ms_count = 0;
-static uint8_t kbd_key_state;
+static struct ps2_decoder kbd_decoder;
 static uint8_t kbd_led_state = 0U;
 
-#define KEY_FLAG_IS_RELEASE     ((uint8_t) (1U << 0))
-#define KEY_FLAG_IS_EXTENDED    ((uint8_t) (1U << 1))
-#define KEY_FLAG_OVERFLOW       ((uint8_t) (1U << 2))
-#define KEY_FLAG_ERROR          ((uint8_t) (1U << 3))
-#define KEY_FLAG_INVALID_STATE  ((uint8_t) (1U << 4))
-#define KEY_FLAG_E1_PREFIX      ((uint8_t) (1U << 5))
-
-/// Scancode byte after E1 prefix in Set 2 Pause sequence
-#define SET2_PAUSE_SCANCODE     ((uint8_t) 0x14U)
-
-/// The keycode prefix before a break (release) event.
-#define KBD_BREAK_PREFIX        ((uint8_t) 0xF0U)
-
-/// The keycode prefix before an extended keycode.
-/// Normally this should not happen in scan code set 3, but some manufacturers
-/// have special keys that still send this, so the parser should be able to
-/// skip them.
-#define KBD_EXTENDED_PREFIX     ((uint8_t) 0xE0U)
+#ifndef KBD_INPUT_BATCH_SIZE
+/// The maximum number of bytes read from the keyboard and decoded at once.
+#define KBD_INPUT_BATCH_SIZE    8U
+#endif
 
 #ifdef JDT
 #define disable_jtag()          (MCUCR |= (1 << JTD))
@@ -132,7 +119,7 @@ ISR (TIMER_COMPA_VECTOR) {
 
 inline static void
 kbd_reset_key_state (void) {
-    kbd_key_state = 0U;
+    ps2_decoder_reset(&kbd_decoder);
 }
 
 static void
@@ -221,21 +208,6 @@ kbd_set_leds (uint8_t new_state) {
     return kbd_led_state;
 }
 
-static uint8_t
-key_flag (const uint8_t byte) {
-    switch (byte) {
-    case KBD_BREAK_PREFIX:      return KEY_FLAG_IS_RELEASE;
-    case KBD_EXTENDED_PREFIX:   return KEY_FLAG_IS_EXTENDED;
-    case PS2_PAUSE_PREFIX:      return KEY_FLAG_E1_PREFIX;
-    case 0x00:                  return KEY_FLAG_OVERFLOW;
-    case PS2_COMMAND_RESET:     return KEY_FLAG_ERROR;
-    case PS2_REPLY_TEST_PASSED: // fallthrough
-    case PS2_REPLY_RESEND:      // fallthrough
-    case PS2_COMMAND_ECHO:      return KEY_FLAG_INVALID_STATE;
-    default:                    return 0U;
-    }
-}
-
 #if PS2USB_DEBUG_COMMANDS
 static uint8_t debug_led_state = 0;
 
@@ -266,17 +238,48 @@ debug_led_toggle (const uint8_t bit) {
 }
 #endif
 
+/// Resynchronize with the keyboard after input was lost to receive buffer
+/// overflow. The lost bytes may have included releases, and whatever
+/// follows the gap may be the middle of a scancode, so all keys are
+/// released, and the keyboard is told to discard its own output buffer (by
+/// enabling it again) so that decoding restarts at a scancode boundary.
+static void
+kbd_resync (void) {
+    reset_keys(false);
+    kbd_reset_key_state();
+    if (send_cmd(PS2_COMMAND_ENABLE) == PS2_REPLY_ACK) {
+        ++kbd_error_count;
+    } else {
+        kbd_error_count = MAX_ERROR_COUNT + 1;
+    }
+}
+
 static bool
 kbd_input (void) {
     bool have_changes = false;
+    uint8_t status = 0U;
 
     wdt_reset();
 
     while (ps2_bytes_available() && ps2_is_ok()) {
-        uint8_t key = ps2_get_byte();
+        uint8_t bytes[KBD_INPUT_BATCH_SIZE];
+        uint8_t batch_size = KBD_INPUT_BATCH_SIZE;
+        uint8_t count = 0;
 
 #if PS2USB_DEBUG_SCANCODES
         if (is_debug_active) {
+            // Handle one byte at a time, since this may end debug mode
+            batch_size = 1;
+        }
+#endif
+
+        do {
+            bytes[count++] = (uint8_t) ps2_get_byte();
+        } while (count < batch_size && ps2_bytes_available());
+
+#if PS2USB_DEBUG_SCANCODES
+        if (is_debug_active) {
+            const uint8_t key = bytes[0];
             (void) fprintf_P(usb_kbd_type, PSTR(" %02X"), key);
 
             if (key == 0xF0) {
@@ -341,44 +344,46 @@ kbd_input (void) {
         }
 #endif
 
-        const uint8_t prefix_flag = key_flag(key);
-        if (prefix_flag) {
-            kbd_key_state |= prefix_flag;
-            continue;
-        }
+        struct ps2_key_event events[KBD_INPUT_BATCH_SIZE];
+        const uint8_t event_count = ps2_decoder_decode(&kbd_decoder, count, bytes, events);
 
-        const bool is_key_release = (kbd_key_state & KEY_FLAG_IS_RELEASE) != 0;
-        const bool is_extended = (kbd_key_state & KEY_FLAG_IS_EXTENDED) != 0;
+        for (uint8_t i = 0; i < event_count; ++i) {
+            const uint8_t key = events[i].scancode;
+            const uint8_t flags = events[i].flags;
 
-        const bool is_e1_prefix = (kbd_key_state & KEY_FLAG_E1_PREFIX) != 0;
-        kbd_key_state = 0U;
+            if (flags & PS2_KEY_EVENT_STATUS) {
+                status |= flags;
+                continue;
+            }
 
-        if (is_e1_prefix) {
-            if (key == SET2_PAUSE_SCANCODE) {
-                if (!is_key_release) {
-                    usb_keyboard_simulate_keypress(USB_KEY_PAUSE_BREAK, 0);
-                    kbd_key_state |= KEY_FLAG_E1_PREFIX;
-                }
-                have_changes = true;
+            have_changes = true;
+
+            if (flags & PS2_KEY_EVENT_PAUSE) {
+                usb_keyboard_simulate_keypress(USB_KEY_PAUSE_BREAK, 0);
+                continue;
             }
-            continue;
+
+            process_key((flags & PS2_KEY_EVENT_EXTENDED) ? usb_keycode_for_ps2_extended_keycode(key)
+                                                         : usb_keycode_for_ps2_keycode(key, scancode_set),
+                        (flags & PS2_KEY_EVENT_RELEASE) != 0, 0, key);
         }
+    }
 
+    if (ps2_input_overflowed() && !ps2_bytes_available()) {
+        // All bytes from before the overflow have been processed above
+        kbd_resync();
         have_changes = true;
-        process_key(is_extended ? usb_keycode_for_ps2_extended_keycode(key)
-                                : usb_keycode_for_ps2_keycode(key, scancode_set),
-                    is_key_release, 0, key);
     }
 
-    if (kbd_key_state & KEY_FLAG_OVERFLOW) {
+    if (status & PS2_KEY_EVENT_OVERFLOW) {
         report_keyboard_error(true);
-    } else if (kbd_key_state & KEY_FLAG_ERROR) {
+    } else if (status & PS2_KEY_EVENT_ERROR) {
         report_keyboard_error(false);
     }
 
     if (have_changes) {
         kbd_idle_reset();
-    } else if (kbd_key_state & KEY_FLAG_INVALID_STATE) {
+    } else if (status & PS2_KEY_EVENT_INVALID) {
         ++kbd_error_count;
     }
 
@@ -609,6 +614,21 @@ update_keyboard_leds (const uint8_t usb_state) {
 }
 
 #ifndef NO_SUSPEND_POWER_DOWN
+#ifndef PS2USB_SUSPEND_WDTO
+/// The watchdog timeout while sleeping in USB suspend. The sleep normally
+/// ends on the PS/2 clock or USB activity, so this is only a safety net.
+#define PS2USB_SUSPEND_WDTO     WDTO_1S
+#endif
+
+#ifdef SLEEP_MODE_STANDBY
+/// Standby keeps the oscillator running, so the CPU wakes up within a few
+/// cycles of the first PS/2 clock edge (INT3:0 are detected asynchronously)
+/// and the interrupt handler still reads that bit in time.
+#define SUSPEND_SLEEP_MODE      SLEEP_MODE_STANDBY
+#else
+#define SUSPEND_SLEEP_MODE      SLEEP_MODE_IDLE
+#endif
+
 static void
 wdt_intr_enable (uint8_t wdto) {
     wdt_reset();
@@ -616,14 +636,22 @@ wdt_intr_enable (uint8_t wdto) {
     WDTCSR |= _BV(WDIE);
 }
 
+/// Sleep until the PS/2 clock interrupt (i.e., the keyboard starts to send),
+/// USB activity, or the watchdog wakes us up.
 static void
-power_down (uint8_t wdto) {
-    wdt_intr_enable(wdto);
-    set_sleep_mode(SLEEP_MODE_IDLE);
-    sleep_enable();
+power_down (void) {
+    wdt_intr_enable(PS2USB_SUSPEND_WDTO);
+    set_sleep_mode(SUSPEND_SLEEP_MODE);
+    cli();
+    if (usb_is_suspended() && !ps2_bytes_available()) {
+        // Interrupts are enabled only after sleep_cpu(), so a byte completed
+        // or a wake-up after the check wakes it up immediately.
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
     sei();
-    sleep_cpu();
-    sleep_disable();
     wdt_disable();
 }
 
@@ -646,9 +674,7 @@ main (void) {
             kbd_reset_key_state();
             while (usb_is_suspended()) {
 #ifndef NO_SUSPEND_POWER_DOWN
-                if (!ps2_bytes_available()) {
-                    power_down(WDTO_15MS);
-                }
+                power_down();
 #endif
                 if (ps2_bytes_available()) {
                     (void) usb_wake_up_host();
@@ -841,6 +867,9 @@ enum generic_request {
     NONE,
     RESET_KEYBOARD,
     JUMP_TO_BOOTLOADER,
+    KEY_TRACE_READ,
+    KEY_TRACE_CLEAR,
+    GET_OVERFLOW_COUNT,
 };
 
 uint8_t
@@ -859,6 +888,34 @@ handle_generic_hid_report (uint8_t report_id, uint8_t count, uint8_t report[stat
         return RESPONSE_OK;
     case JUMP_TO_BOOTLOADER:
         return JUMP_TO_BOOTLOADER;
+#if KEY_TRACE_SIZE > 0
+    case KEY_TRACE_READ:
+        // One event per report, an all-zero event marks the end (and the
+        // next read starts over from the oldest event)
+        if (*response_length < KEY_TRACE_EVENT_SIZE) {
+            return RESPONSE_ERROR;
+        }
+        if (!key_trace_read_next(response)) {
+            for (int_fast8_t i = 0; i < KEY_TRACE_EVENT_SIZE; ++i) {
+                response[i] = 0;
+            }
+            key_trace_rewind();
+        }
+        *response_length = KEY_TRACE_EVENT_SIZE;
+        return RESPONSE_SEND_REPLY;
+    case KEY_TRACE_CLEAR:
+        key_trace_clear();
+        return RESPONSE_OK;
+#endif
+    case GET_OVERFLOW_COUNT:
+        // The number of times input from the keyboard was lost to receive
+        // buffer overflow (saturating)
+        if (*response_length < 1) {
+            return RESPONSE_ERROR;
+        }
+        response[0] = ps2_overflow_count();
+        *response_length = 1;
+        return RESPONSE_SEND_REPLY;
     default:
         return RESPONSE_ERROR;
     }
@@ -870,6 +927,17 @@ handle_generic_hid_report (uint8_t report_id, uint8_t count, uint8_t report[stat
 #error "GENERIC_HID_REPORT_SIZE should be 8 or 0."
 #endif
 
+/// The generic HID report is for debugging, with the bytes:
+///
+/// 0. `usb_last_error()`
+/// 1. `ps2_last_error()`
+/// 2. the keyboard error count
+/// 3. `keys_error()`
+/// 4. `1` if the USB keyboard is in boot protocol, otherwise `0`
+/// 5. the scancode decoder state (`ps2_decoder.state`), `0` between scancodes
+///    (this used to be the prefix flags of the scancode being received)
+/// 6. `usb_address()`
+/// 7. the time since the keyboard last sent anything, in units of 10 ms
 bool
 make_generic_hid_report (uint8_t report_id, uint8_t count, uint8_t report[static count]) {
 #if GENERIC_HID_REPORT_SIZE
@@ -881,7 +949,7 @@ make_generic_hid_report (uint8_t report_id, uint8_t count, uint8_t report[static
     report[2] = kbd_error_count;
     report[3] = keys_error();
     report[4] = usb_keyboard_is_in_boot_protocol;
-    report[5] = kbd_key_state;
+    report[5] = kbd_decoder.state;
     report[6] = usb_address();
     report[7] = kbd_idle_10ms_count;
 #endif
@@ -76,4 +76,7 @@ __attribute__((weak)) void bootmagic_scan(void) {
 
 void bootmagic(void) {
     bootmagic_scan();
+
+    // Report the keys held since power up on the first real scan
+    matrix_set_all_rows_changed();
 }
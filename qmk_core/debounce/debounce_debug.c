@@ -20,6 +20,10 @@
 #include "timer.h"
 #include "usbkbd.h"
 
+#if DEBOUNCE_TUNING
+#include "debounce_tuning.h"
+#endif
+
 #if DEBOUNCE == 0
 #error "DEBOUNCE_DEBUG requires DEBOUNCE > 0"
 #endif
@@ -78,6 +82,12 @@ void debounce_debug_update(matrix_row_t raw[], matrix_row_t cooked[], uint8_t ro
                 if (cooked_changed & bit) {
                     uint8_t idx = r * MATRIX_COLS + c;
 
+#if DEBOUNCE_TUNING
+                    if (event_active[r] & bit) {
+                        debounce_tuning_observe(idx, max_gap[idx]);
+                    }
+#endif
+
                     if (max_gap[idx] > 0) {
                         uint8_t need = max_gap[idx] + 1;
 
@@ -106,6 +116,7 @@ void debounce_debug_update(matrix_row_t raw[], matrix_row_t cooked[], uint8_t ro
     }
 }
 
+#if ENABLE_SIMULATED_TYPING
 void debounce_debug_print_histogram(void) {
     fprintf_P(usb_kbd_type, PSTR("D:"));
     for (uint8_t i = 0; i < DEBOUNCE; i++) {
@@ -120,5 +131,10 @@ void debounce_debug_print_histogram(void) {
     }
     uint8_t need = highest + 1;
     if (need > DEBOUNCE) need = DEBOUNCE;
+#if DEBOUNCE_TUNING
+    fprintf_P(usb_kbd_type, PSTR(" need=%u tuning=%u\n"), need, debounce_tuning_mode());
+#else
     fprintf_P(usb_kbd_type, PSTR(" need=%u\n"), need);
+#endif
 }
+#endif
@@ -0,0 +1,158 @@
+/*
+ * debounce_tuning.c: Self-tuning per-key debounce times.
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <string.h>
+
+#include "debounce_tuning.h"
+#include "config.h"
+#include "eeconfig.h"
+#include "dynamic_storage.h"
+
+#if !defined(DEBOUNCE_TUNING) || !DEBOUNCE_TUNING
+#error "debounce_tuning.c should only be compiled when DEBOUNCE_TUNING is enabled"
+#endif
+
+#if !defined(DEBOUNCE_DEBUG) || !DEBOUNCE_DEBUG
+#error "DEBOUNCE_TUNING requires DEBOUNCE_DEBUG (for the bounce statistics)"
+#endif
+
+#if DEBOUNCE > 15
+#error "DEBOUNCE_TUNING supports DEBOUNCE up to 15 ms"
+#endif
+
+_Static_assert(MATRIX_ROWS * MATRIX_COLS <= UINT8_MAX, "Too many keys for DEBOUNCE_TUNING");
+_Static_assert(EECONFIG_DEBOUNCE_TUNING_SIZE == 2 + DEBOUNCE_TUNING_TABLE_SIZE, "Debounce tuning EEPROM size mismatch");
+
+// EEPROM: magic byte, mode byte, table
+#define DEBOUNCE_TUNING_MAGIC       ((uint8_t) (0xD0 | DEBOUNCE))
+#define EEPROM_MAGIC_ADDR           (EECONFIG_DEBOUNCE_TUNING)
+#define EEPROM_MODE_ADDR            (EECONFIG_DEBOUNCE_TUNING + 1)
+#define EEPROM_TABLE_ADDR           (EECONFIG_DEBOUNCE_TUNING + 2)
+
+static uint8_t times[DEBOUNCE_TUNING_TABLE_SIZE];
+static uint8_t mode = DEBOUNCE_TUNING_OFF;
+
+static inline uint8_t
+stored_time (uint8_t index) {
+    const uint8_t byte = times[index / 2];
+    return (index & 1) ? (byte >> 4) : (byte & 0x0F);
+}
+
+static inline void
+set_stored_time (uint8_t index, uint8_t ms) {
+    uint8_t *byte = &times[index / 2];
+    if (index & 1) {
+        *byte = (*byte & 0x0F) | (uint8_t) (ms << 4);
+    } else {
+        *byte = (*byte & 0xF0) | (ms & 0x0F);
+    }
+}
+
+static void
+save_table (void) {
+    for (uint8_t i = 0; i < DEBOUNCE_TUNING_TABLE_SIZE; ++i) {
+        eeprom_update_byte(EEPROM_TABLE_ADDR + i, times[i]);
+    }
+    eeprom_update_byte(EEPROM_MAGIC_ADDR, DEBOUNCE_TUNING_MAGIC);
+}
+
+void
+debounce_tuning_init (void) {
+    if (eeprom_read_byte(EEPROM_MAGIC_ADDR) != DEBOUNCE_TUNING_MAGIC) {
+        // Not saved, or saved with a different `DEBOUNCE`
+        (void) memset(times, 0, sizeof(times));
+        mode = DEBOUNCE_TUNING_OFF;
+        return;
+    }
+    for (uint8_t i = 0; i < DEBOUNCE_TUNING_TABLE_SIZE; ++i) {
+        times[i] = eeprom_read_byte(EEPROM_TABLE_ADDR + i);
+    }
+    for (uint8_t i = 0; i < MATRIX_ROWS * MATRIX_COLS; ++i) {
+        if (stored_time(i) > DEBOUNCE) {
+            set_stored_time(i, DEBOUNCE);
+        }
+    }
+    mode = eeprom_read_byte(EEPROM_MODE_ADDR);
+    if (mode > DEBOUNCE_TUNING_LEARN) {
+        mode = DEBOUNCE_TUNING_OFF;
+    }
+}
+
+uint8_t
+debounce_tuning_mode (void) {
+    return mode;
+}
+
+void
+debounce_tuning_set_mode (uint8_t new_mode) {
+    if (new_mode > DEBOUNCE_TUNING_LEARN || new_mode == mode) {
+        return;
+    }
+    if (new_mode == DEBOUNCE_TUNING_LEARN) {
+        (void) memset(times, 0, sizeof(times));
+    } else if (mode == DEBOUNCE_TUNING_LEARN) {
+        save_table();
+    }
+    mode = new_mode;
+    eeprom_update_byte(EEPROM_MODE_ADDR, mode);
+    if (eeprom_read_byte(EEPROM_MAGIC_ADDR) != DEBOUNCE_TUNING_MAGIC) {
+        // The magic makes the table valid, so it must not be written alone
+        save_table();
+    }
+}
+
+uint8_t
+debounce_tuning_key_time (uint8_t index) {
+    if (mode == DEBOUNCE_TUNING_ON) {
+        const uint8_t ms = stored_time(index);
+        if (ms && ms < DEBOUNCE) {
+            return ms;
+        }
+    }
+    return DEBOUNCE;
+}
+
+void
+debounce_tuning_set_key_time (uint8_t index, uint8_t ms) {
+    if (index >= MATRIX_ROWS * MATRIX_COLS) {
+        return;
+    }
+    set_stored_time(index, (ms < DEBOUNCE) ? ms : DEBOUNCE);
+    save_table();
+}
+
+void
+debounce_tuning_observe (uint8_t index, uint8_t max_gap) {
+    if (mode != DEBOUNCE_TUNING_LEARN || index >= MATRIX_ROWS * MATRIX_COLS) {
+        return;
+    }
+    // A gap of `max_gap` needs a stable time of `max_gap + 1` to filter,
+    // and the stored time is never above `DEBOUNCE`, so 0 is "not seen"
+    uint16_t ms = (uint16_t) max_gap + 1 + DEBOUNCE_TUNING_MARGIN;
+    if (ms > DEBOUNCE) {
+        ms = DEBOUNCE;
+    }
+    if (ms > stored_time(index)) {
+        set_stored_time(index, (uint8_t) ms);
+    }
+}
+
+uint8_t
+debounce_tuning_read_table (uint8_t offset, uint8_t count, uint8_t *buffer) {
+    if (offset >= DEBOUNCE_TUNING_TABLE_SIZE) {
+        return 0;
+    }
+    if (count > DEBOUNCE_TUNING_TABLE_SIZE - offset) {
+        count = DEBOUNCE_TUNING_TABLE_SIZE - offset;
+    }
+    (void) memcpy(buffer, times + offset, count);
+    return count;
+}
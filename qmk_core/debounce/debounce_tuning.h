@@ -0,0 +1,69 @@
+/*
+ * debounce_tuning.h: Self-tuning per-key debounce times.
+ *
+ * Used by the `sym_defer_pk_tuned` debounce algorithm, which defers each key
+ * change until the key has been stable for that key's debounce time. In the
+ * learning mode every key uses the full `DEBOUNCE`, and the longest bounce
+ * gap of each key (as measured by `debounce_debug.c`) is used to derive its
+ * time: `max_gap + 1 + DEBOUNCE_TUNING_MARGIN`, at most `DEBOUNCE`. Keys that
+ * are not pressed while learning keep the full `DEBOUNCE`. When learning is
+ * stopped, the times are saved in EEPROM.
+ *
+ * Build with `make DEBOUNCE_TUNING=1` to enable.
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+#ifndef DEBOUNCE_TUNING_MARGIN
+/// The safety margin (ms) added to the measured bounce of each key.
+#define DEBOUNCE_TUNING_MARGIN 1
+#endif
+
+/// Every key uses `DEBOUNCE` (the tuned times are kept).
+#define DEBOUNCE_TUNING_OFF     0
+/// Every key uses its tuned time.
+#define DEBOUNCE_TUNING_ON      1
+/// Every key uses `DEBOUNCE` while the tuned times are learned.
+#define DEBOUNCE_TUNING_LEARN   2
+
+/// The size of the table of per-key times in bytes (4 bits per key, the
+/// low bits are the even key index `row * MATRIX_COLS + col`). The times are
+/// at most `DEBOUNCE`, and zero means the key has not been tuned and uses
+/// `DEBOUNCE`.
+#define DEBOUNCE_TUNING_TABLE_SIZE (((MATRIX_ROWS * MATRIX_COLS) + 1) / 2)
+
+/// Load the mode and the per-key times from EEPROM.
+void debounce_tuning_init(void);
+
+/// The current mode (`DEBOUNCE_TUNING_OFF`, `_ON` or `_LEARN`).
+uint8_t debounce_tuning_mode(void);
+
+/// Set the mode. Entering learning mode clears the per-key times, and leaving
+/// it saves them. The mode is also saved.
+void debounce_tuning_set_mode(uint8_t mode);
+
+/// The debounce time currently in effect for the key at `index`
+/// (`row * MATRIX_COLS + col`).
+uint8_t debounce_tuning_key_time(uint8_t index);
+
+/// Set the tuned time of the key at `index` (0 = `DEBOUNCE`), and save it.
+void debounce_tuning_set_key_time(uint8_t index, uint8_t ms);
+
+/// Called by `debounce_debug.c` when an event of the key at `index` has been
+/// debounced, with the longest gap (ms) between its raw changes.
+void debounce_tuning_observe(uint8_t index, uint8_t max_gap);
+
+/// Copy up to `count` bytes of the per-key time table starting from `offset`
+/// to `buffer`. Returns the number of bytes copied.
+uint8_t debounce_tuning_read_table(uint8_t offset, uint8_t count, uint8_t *buffer);
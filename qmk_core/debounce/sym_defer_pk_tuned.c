@@ -0,0 +1,136 @@
+/*
+ * sym_defer_pk_tuned.c: Per-key deferred debounce with tuned per-key times.
+ *
+ * A key change is reported only after the key has been stable for its
+ * debounce time, which comes from `debounce_tuning.c` (normally `DEBOUNCE`,
+ * but clean switches can be tuned to a shorter time for less latency). If
+ * the key returns to its reported state before that, the change is dropped.
+ *
+ * On split keyboards both halves use the times of the first half.
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "debounce.h"
+#include "debounce_tuning.h"
+#include "timer.h"
+#include "util.h"
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+#if !defined(DEBOUNCE_TUNING) || !DEBOUNCE_TUNING
+#    error "sym_defer_pk_tuned requires DEBOUNCE_TUNING"
+#endif
+
+#define DEBOUNCE_ELAPSED 0
+
+#if DEBOUNCE > 0
+typedef uint8_t debounce_counter_t;
+// Uses MATRIX_ROWS_PER_HAND instead of MATRIX_ROWS to support split keyboards
+static debounce_counter_t debounce_counters[MATRIX_ROWS_PER_HAND * MATRIX_COLS] = {DEBOUNCE_ELAPSED};
+static bool               counters_need_update;
+static bool               cooked_changed;
+
+static inline void update_debounce_counters_and_transfer_if_expired(matrix_row_t raw[], matrix_row_t cooked[], uint8_t elapsed_time);
+static inline void start_debounce_counters(matrix_row_t raw[], matrix_row_t cooked[]);
+
+void debounce_init(void) {
+    debounce_tuning_init();
+}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], bool changed) {
+    static fast_timer_t last_time;
+    bool                updated_last = false;
+    cooked_changed                   = false;
+
+    if (counters_need_update) {
+        fast_timer_t now          = timer_read_fast();
+        fast_timer_t elapsed_time = TIMER_DIFF_FAST(now, last_time);
+
+        last_time    = now;
+        updated_last = true;
+
+        if (elapsed_time > 0) {
+            update_debounce_counters_and_transfer_if_expired(raw, cooked, MIN(elapsed_time, UINT8_MAX));
+        }
+    }
+
+    if (changed) {
+        if (!updated_last) {
+            last_time = timer_read_fast();
+        }
+
+        start_debounce_counters(raw, cooked);
+    }
+
+    return cooked_changed;
+}
+
+/**
+ * @brief Decrements the active counters, and transfers the keys whose counter
+ * expired from the raw matrix to the cooked matrix.
+ */
+static inline void update_debounce_counters_and_transfer_if_expired(matrix_row_t raw[], matrix_row_t cooked[], uint8_t elapsed_time) {
+    counters_need_update = false;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS_PER_HAND; row++) {
+        uint16_t     row_offset   = row * MATRIX_COLS;
+        matrix_row_t existing_row = cooked[row];
+        matrix_row_t raw_row      = raw[row];
+
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint16_t index = row_offset + col;
+
+            if (debounce_counters[index] != DEBOUNCE_ELAPSED) {
+                if (debounce_counters[index] <= elapsed_time) {
+                    matrix_row_t col_mask    = (MATRIX_ROW_SHIFTER << col);
+                    debounce_counters[index] = DEBOUNCE_ELAPSED;
+                    existing_row             = (existing_row & ~col_mask) | (raw_row & col_mask);
+                } else {
+                    debounce_counters[index] -= elapsed_time;
+                    counters_need_update = true;
+                }
+            }
+        }
+
+        if (existing_row != cooked[row]) {
+            cooked[row]    = existing_row;
+            cooked_changed = true;
+        }
+    }
+}
+
+/**
+ * @brief Starts the counters of keys that differ from the cooked matrix with
+ * the key's tuned time, and stops the counters of keys that no longer differ.
+ */
+static inline void start_debounce_counters(matrix_row_t raw[], matrix_row_t cooked[]) {
+    for (uint8_t row = 0; row < MATRIX_ROWS_PER_HAND; row++) {
+        uint16_t     row_offset = row * MATRIX_COLS;
+        matrix_row_t delta      = raw[row] ^ cooked[row];
+
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint16_t index = row_offset + col;
+
+            if (delta & (MATRIX_ROW_SHIFTER << col)) {
+                if (debounce_counters[index] == DEBOUNCE_ELAPSED) {
+                    debounce_counters[index] = debounce_tuning_key_time(index);
+                    counters_need_update     = true;
+                }
+            } else {
+                debounce_counters[index] = DEBOUNCE_ELAPSED;
+            }
+        }
+    }
+}
+
+#else
+#    include "none.c"
+#endif
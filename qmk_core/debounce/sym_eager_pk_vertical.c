@@ -0,0 +1,172 @@
+/*
+ * sym_eager_pk_vertical.c: Per-key eager debounce with vertical counters.
+ *
+ * Behaves exactly like sym_eager_pk: a key changes state immediately, and
+ * then further changes of that key are ignored until DEBOUNCE ms have passed.
+ * However, instead of a byte counter per key, the counters are bit-sliced
+ * ("vertical") over the matrix rows: bit `b` of the counter of every key in
+ * a row is stored in `counter_bits[b][row]`. This way all the columns of a
+ * row are updated with a handful of bitwise operations, and the counters
+ * take only `DEBOUNCE_BITS * MATRIX_ROWS_PER_HAND * sizeof(matrix_row_t)`
+ * bytes of RAM (e.g., 3 * 6 * 4 = 72 bytes instead of 6 * 21 = 126 bytes for
+ * a 6×21 matrix with DEBOUNCE=5).
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "debounce.h"
+#include "timer.h"
+#include "util.h"
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+// Maximum debounce: 255ms
+#if DEBOUNCE > UINT8_MAX
+#    undef DEBOUNCE
+#    define DEBOUNCE UINT8_MAX
+#endif
+
+#if DEBOUNCE > 0
+
+// The number of bits needed for a counter of `DEBOUNCE`
+#if DEBOUNCE < 2
+#    define DEBOUNCE_BITS 1
+#elif DEBOUNCE < 4
+#    define DEBOUNCE_BITS 2
+#elif DEBOUNCE < 8
+#    define DEBOUNCE_BITS 3
+#elif DEBOUNCE < 16
+#    define DEBOUNCE_BITS 4
+#elif DEBOUNCE < 32
+#    define DEBOUNCE_BITS 5
+#elif DEBOUNCE < 64
+#    define DEBOUNCE_BITS 6
+#elif DEBOUNCE < 128
+#    define DEBOUNCE_BITS 7
+#else
+#    define DEBOUNCE_BITS 8
+#endif
+
+#define ALL_COLUMNS ((matrix_row_t) ~(matrix_row_t)0)
+
+// Uses MATRIX_ROWS_PER_HAND instead of MATRIX_ROWS to support split keyboards
+static matrix_row_t counter_bits[DEBOUNCE_BITS][MATRIX_ROWS_PER_HAND];
+static bool         counters_need_update;
+static bool         matrix_need_update;
+static bool         cooked_changed;
+
+static inline void update_debounce_counters(uint8_t elapsed_time);
+static inline void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[]);
+
+void debounce_init(void) {}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], bool changed) {
+    static fast_timer_t last_time;
+    bool                updated_last = false;
+    cooked_changed                   = false;
+
+    if (counters_need_update) {
+        fast_timer_t now          = timer_read_fast();
+        fast_timer_t elapsed_time = TIMER_DIFF_FAST(now, last_time);
+
+        last_time    = now;
+        updated_last = true;
+
+        if (elapsed_time > 0) {
+            // No counter is above DEBOUNCE, so it is the largest useful step
+            update_debounce_counters(MIN(elapsed_time, DEBOUNCE));
+        }
+    }
+
+    if (changed || matrix_need_update) {
+        if (!updated_last) {
+            last_time = timer_read_fast();
+        }
+
+        transfer_matrix_values(raw, cooked);
+    }
+
+    return cooked_changed;
+}
+
+/// Returns the columns of `row` that have a non-zero debounce counter.
+static inline matrix_row_t active_columns(uint8_t row) {
+    matrix_row_t active = 0;
+    for (uint8_t bit = 0; bit < DEBOUNCE_BITS; ++bit) {
+        active |= counter_bits[bit][row];
+    }
+    return active;
+}
+
+/// Subtracts `elapsed_time` from all counters of each row at once, using a
+/// bit-sliced ripple borrow subtractor. The counters that would go to zero
+/// or below are cleared, and the matrix is marked for update.
+static inline void update_debounce_counters(uint8_t elapsed_time) {
+    counters_need_update = false;
+    matrix_need_update   = false;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS_PER_HAND; row++) {
+        const matrix_row_t active = active_columns(row);
+        if (!active) {
+            continue;
+        }
+
+        matrix_row_t borrow    = 0;
+        matrix_row_t remaining = 0;
+        for (uint8_t bit = 0; bit < DEBOUNCE_BITS; ++bit) {
+            const matrix_row_t counter    = counter_bits[bit][row];
+            const matrix_row_t subtrahend = (elapsed_time & (1U << bit)) ? ALL_COLUMNS : 0;
+            const matrix_row_t difference = counter ^ subtrahend ^ borrow;
+
+            borrow = (~counter & (subtrahend | borrow)) | (subtrahend & borrow);
+            counter_bits[bit][row] = difference;
+            remaining |= difference;
+        }
+
+        // Counters that underflowed have elapsed (as have those now zero)
+        remaining &= ~borrow;
+        for (uint8_t bit = 0; bit < DEBOUNCE_BITS; ++bit) {
+            counter_bits[bit][row] &= remaining;
+        }
+
+        if (active & ~remaining) {
+            matrix_need_update = true;
+        }
+        if (remaining) {
+            counters_need_update = true;
+        }
+    }
+}
+
+/// Transfers the changed keys whose counter has elapsed from `raw` to
+/// `cooked`, and starts their counters from `DEBOUNCE`.
+static inline void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[]) {
+    matrix_need_update = false;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS_PER_HAND; row++) {
+        const matrix_row_t flip = (raw[row] ^ cooked[row]) & ~active_columns(row);
+        if (!flip) {
+            continue;
+        }
+
+        cooked[row] ^= flip;
+        for (uint8_t bit = 0; bit < DEBOUNCE_BITS; ++bit) {
+            if (DEBOUNCE & (1U << bit)) {
+                counter_bits[bit][row] |= flip;
+            }
+        }
+        counters_need_update = true;
+        cooked_changed       = true;
+    }
+}
+
+#else
+#    include "none.c"
+#endif
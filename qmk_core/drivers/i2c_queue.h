@@ -0,0 +1,54 @@
+/*
+ * i2c_queue.h: Interrupt-driven queue of I2C master transactions.
+ *
+ * Each transaction writes `tx_length` bytes and then (with a repeated start)
+ * reads `rx_length` bytes, so that, e.g., selecting a register and reading
+ * it is a single transaction. The queued transactions run in the background
+ * one after another while the caller does something else, and the status of
+ * each is `I2C_STATUS_PENDING` until it is done. The blocking functions of
+ * `i2c_master.h` must not be used while the queue is busy.
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "i2c_master.h"
+
+#define I2C_STATUS_PENDING (1)
+
+#ifndef I2C_QUEUE_SIZE
+/// The maximum number of queued transactions.
+#define I2C_QUEUE_SIZE 8
+#endif
+
+struct i2c_transaction {
+    /// The 8-bit address of the device (i.e., the 7-bit address << 1).
+    uint8_t address;
+    uint8_t tx_length;
+    uint8_t rx_length;
+    const uint8_t *tx_data;
+    uint8_t *rx_data;
+    /// `I2C_STATUS_PENDING` while queued, then the result.
+    volatile i2c_status_t status;
+};
+
+/// Queue `transaction`, which must remain valid until it is done. Returns
+/// `false` if the queue is full. The I2C must be initialised with `i2c_init`.
+bool i2c_queue_add(struct i2c_transaction *transaction);
+
+/// Returns `true` if there are queued transactions that are not done.
+bool i2c_queue_is_busy(void);
+
+/// Wait for the queued transactions to be done. On timeout, the transaction
+/// in progress and the rest of the queue are aborted with
+/// `I2C_STATUS_TIMEOUT`. Returns the status of the last transaction.
+i2c_status_t i2c_queue_wait(uint16_t timeout);
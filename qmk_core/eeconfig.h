@@ -215,11 +215,28 @@ void     eeconfig_init_user_datablock(void);
 // AAKBD stores the default layer as a layer number, not a bitmask.
 #define DEFAULT_LAYER_STATE_IS_VALUE_NOT_BITMASK
 
-#define EECONFIG_SIZE 35
 #define EECONFIG_KEYMAP_UPPER_BYTE ((uint8_t *) 34)
 
+#if DEBOUNCE_TUNING
+// Per-key debounce times (see debounce/debounce_tuning.h): a header of 2
+// bytes and then 4 bits per key.
+#define EECONFIG_DEBOUNCE_TUNING        ((uint8_t *) 35)
+#define EECONFIG_DEBOUNCE_TUNING_SIZE   (2 + (((MATRIX_ROWS * MATRIX_COLS) + 1) / 2))
+#else
+#define EECONFIG_DEBOUNCE_TUNING_SIZE   0
+#endif
+
+#define EECONFIG_SIZE (35 + EECONFIG_DEBOUNCE_TUNING_SIZE)
+
 #define EECONFIG_MAGIC              0xFEE9
+#if DEBOUNCE_TUNING
+// The debounce tuning moves everything from `EECONFIG_SIZE` onwards (e.g.,
+// the Vial keymaps), so the layout has a different magic number. Toggling
+// `DEBOUNCE_TUNING` thus resets the settings instead of misreading them.
+#define EECONFIG_MAGIC_NUMBER       ((uint16_t) 0xFEE7)
+#else
 #define EECONFIG_MAGIC_NUMBER       ((uint16_t) 0xFEE8)
+#endif
 #define EECONFIG_MAGIC_NUMBER_OFF   ((uint16_t) 0xFFFF)
 #define EECONFIG_MAGIC_NUMBER_PTR   ((uint16_t *) 0)
 #define EECONFIG_DEBUG              ((uint8_t *) 2)
@@ -238,3 +255,7 @@ void     eeconfig_init_user_datablock(void);
 #define EECONFIG_RGB_MATRIX         ((uint32_t *) 28)
 #define EECONFIG_LED_MATRIX_EXTENDED ((uint16_t *) 32)
 #define EECONFIG_RGB_MATRIX_EXTENDED ((uint16_t *) 32)
+
+// AAKBD has no steno mode, so its byte holds the protocol (USB or PS/2)
+// chosen at the last power-up (see qmk_main.c).
+#define EECONFIG_PROTOCOL_HINT      EECONFIG_STENOMODE
@@ -35,6 +35,16 @@ typedef uint32_t matrix_row_t;
 #    error "MATRIX_COLS: invalid value"
 #endif
 
+#if (MATRIX_ROWS <= 8)
+typedef uint8_t matrix_rows_mask_t;
+#elif (MATRIX_ROWS <= 16)
+typedef uint16_t matrix_rows_mask_t;
+#elif (MATRIX_ROWS <= 32)
+typedef uint32_t matrix_rows_mask_t;
+#else
+#    error "MATRIX_ROWS: invalid value"
+#endif
+
 #ifdef SPLIT_KEYBOARD
 #    define MATRIX_ROWS_PER_HAND (MATRIX_ROWS / 2)
 #else
@@ -55,8 +65,15 @@ uint8_t matrix_cols(void);
 void matrix_setup(void);
 /* intialize matrix for scaning. */
 void matrix_init(void);
-/* scan all key states on matrix */
-uint8_t matrix_scan(void);
+/* scan all key states on matrix, returns the changed rows (bit n = row n) */
+matrix_rows_mask_t matrix_scan(void);
+/* the rows changed since the previous call, for matrix_scan (changed = debounce result) */
+matrix_rows_mask_t matrix_changed_rows(bool changed);
+/* the rows changed in all scans since the previous call, including the scans
+ * whose result was discarded (e.g., by a calibration loop) */
+matrix_rows_mask_t matrix_take_changed_rows(void);
+/* report all rows as changed on the next scan (e.g., after discarding scan results) */
+void matrix_set_all_rows_changed(void);
 /* whether matrix scanning operations should be executed */
 bool matrix_can_read(void);
 /* whether a switch is on */
@@ -21,6 +21,12 @@
 matrix_row_t raw_matrix[MATRIX_ROWS];
 matrix_row_t matrix[MATRIX_ROWS];
 
+/* debounced matrix state as of the previous scan, for matrix_changed_rows() */
+static matrix_row_t previous_matrix[MATRIX_ROWS];
+static bool         all_rows_changed = true;
+/* rows changed in any scan since matrix_take_changed_rows() */
+static matrix_rows_mask_t untaken_changed_rows = 0;
+
 #ifdef SPLIT_KEYBOARD
 // row offsets for each hand
 uint8_t thisHand, thatHand;
@@ -145,6 +151,35 @@ __attribute__((weak)) void matrix_slave_scan_kb(void) {
 __attribute__((weak)) void matrix_slave_scan_user(void) {}
 #endif
 
+matrix_rows_mask_t matrix_changed_rows(bool changed) {
+    matrix_rows_mask_t changed_rows = 0;
+
+    // Only compare the rows if debounce reported a change
+    if (changed || all_rows_changed) {
+        matrix_rows_mask_t row_bit = 1;
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++, row_bit <<= 1) {
+            if (matrix[row] != previous_matrix[row] || all_rows_changed) {
+                previous_matrix[row] = matrix[row];
+                changed_rows |= row_bit;
+            }
+        }
+        all_rows_changed = false;
+        untaken_changed_rows |= changed_rows;
+    }
+
+    return changed_rows;
+}
+
+matrix_rows_mask_t matrix_take_changed_rows(void) {
+    const matrix_rows_mask_t changed_rows = untaken_changed_rows;
+    untaken_changed_rows = 0;
+    return changed_rows;
+}
+
+void matrix_set_all_rows_changed(void) {
+    all_rows_changed = true;
+}
+
 __attribute__((weak)) void matrix_init(void) {
 #ifdef SPLIT_KEYBOARD
     thisHand = is_keyboard_left() ? 0 : (MATRIX_ROWS_PER_HAND);
@@ -164,7 +199,7 @@ __attribute__((weak)) void matrix_init(void) {
     matrix_init_kb();
 }
 
-__attribute__((weak)) uint8_t matrix_scan(void) {
+__attribute__((weak)) matrix_rows_mask_t matrix_scan(void) {
     bool changed = matrix_scan_custom(raw_matrix);
 
 #ifdef SPLIT_KEYBOARD
@@ -180,7 +215,7 @@ __attribute__((weak)) uint8_t matrix_scan(void) {
 #endif
 #endif
 
-    return changed;
+    return matrix_changed_rows(changed);
 }
 
 __attribute__((weak)) bool peek_matrix(uint8_t row_index, uint8_t col_index, bool raw) {
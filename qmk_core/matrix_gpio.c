@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #endif
 #include "debounce.h"
 #include "atomic_util.h"
+#include "matrix_timer.h"
 
 #ifdef SPLIT_KEYBOARD
 #    include "split_common/split_util.h"
@@ -46,6 +47,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    define SPLIT_MUTABLE_COL const
 #endif
 
+#if MATRIX_TIMER_SCAN_US
+#    if defined(SPLIT_KEYBOARD) || defined(DIRECT_PINS) || (DIODE_DIRECTION != COL2ROW)
+#        error "MATRIX_TIMER_SCAN_US is only supported with COL2ROW (not split or direct pins)"
+#    endif
+_Static_assert(MATRIX_TIMER_SCAN_US / MATRIX_ROWS_PER_HAND >= MATRIX_TIMER_MIN_TICK_US, "MATRIX_TIMER_SCAN_US is too short for the number of rows");
+_Static_assert(MATRIX_TIMER_SCAN_US / MATRIX_ROWS_PER_HAND <= UINT16_MAX, "MATRIX_TIMER_SCAN_US is too long");
+// The timer interrupt must not change the pin modes, so the unselected
+// rows are driven high and only the output values are changed.
+#    ifndef MATRIX_UNSELECT_DRIVE_HIGH
+#        define MATRIX_UNSELECT_DRIVE_HIGH
+#    endif
+#endif
+
 #ifndef MATRIX_INPUT_PRESSED_STATE
 #    define MATRIX_INPUT_PRESSED_STATE 0
 #endif
@@ -197,6 +211,53 @@ __attribute__((weak)) void matrix_read_cols_on_row(matrix_row_t current_matrix[]
     current_matrix[current_row] = current_row_value;
 }
 
+#            if MATRIX_TIMER_SCAN_US
+
+static matrix_row_t     timer_frames[2][MATRIX_ROWS_PER_HAND];
+static uint8_t          timer_frame = 0; // the frame being scanned
+static uint8_t          timer_row   = 0; // the row selected for the next tick
+static volatile uint8_t timer_frame_count = 0;
+static uint8_t          consumed_frame_count = 0;
+
+void matrix_timer_tick(void) {
+    // The row was selected on the previous tick, so it has settled
+    matrix_row_t current_row_value = 0;
+    matrix_row_t row_shifter       = MATRIX_ROW_SHIFTER;
+    for (uint8_t col_index = 0; col_index < MATRIX_COLS; col_index++, row_shifter <<= 1) {
+        current_row_value |= readMatrixPin(col_pins[col_index]) ? 0 : row_shifter;
+    }
+    timer_frames[timer_frame][timer_row] = current_row_value;
+
+    // The pins are already outputs, so only change the values
+    if (row_pins[timer_row] != NO_PIN) {
+        gpio_write_pin_high(row_pins[timer_row]);
+    }
+    if (++timer_row == MATRIX_ROWS_PER_HAND) {
+        timer_row = 0;
+        timer_frame ^= 1;
+        ++timer_frame_count;
+    }
+    if (row_pins[timer_row] != NO_PIN) {
+        gpio_write_pin_low(row_pins[timer_row]);
+    }
+}
+
+// Copies the latest frame completed by the timer to current_matrix,
+// returning whether there was a new frame since the previous call.
+static bool matrix_timer_read(matrix_row_t current_matrix[]) {
+    bool is_new_frame = false;
+    ATOMIC_BLOCK_FORCEON {
+        if (timer_frame_count != consumed_frame_count) {
+            consumed_frame_count = timer_frame_count;
+            memcpy(current_matrix, timer_frames[timer_frame ^ 1], sizeof(timer_frames[0]));
+            is_new_frame = true;
+        }
+    }
+    return is_new_frame;
+}
+
+#            endif
+
 #        elif (DIODE_DIRECTION == ROW2COL)
 
 static bool select_col(uint8_t col) {
@@ -309,6 +370,12 @@ void matrix_init(void) {
     debounce_init();
 
     matrix_init_kb();
+
+#if MATRIX_TIMER_SCAN_US
+    // Select the first row for the first tick
+    select_row(0);
+    matrix_timer_start(MATRIX_TIMER_SCAN_US / MATRIX_ROWS_PER_HAND);
+#endif
 }
 
 #ifdef SPLIT_KEYBOARD
@@ -319,10 +386,15 @@ __attribute__((weak)) bool transport_master_if_connected(matrix_row_t master_mat
 }
 #endif
 
-uint8_t matrix_scan(void) {
+matrix_rows_mask_t matrix_scan(void) {
     matrix_row_t curr_matrix[MATRIX_ROWS] = {0};
 
-#if defined(DIRECT_PINS) || (DIODE_DIRECTION == COL2ROW)
+#if MATRIX_TIMER_SCAN_US
+    // Use the latest frame completed by the timer, if any
+    if (!matrix_timer_read(curr_matrix)) {
+        memcpy(curr_matrix, raw_matrix, sizeof(curr_matrix));
+    }
+#elif defined(DIRECT_PINS) || (DIODE_DIRECTION == COL2ROW)
     // Set row, read cols
     for (uint8_t current_row = 0; current_row < MATRIX_ROWS_PER_HAND; current_row++) {
         matrix_read_cols_on_row(curr_matrix, current_row);
@@ -350,5 +422,5 @@ uint8_t matrix_scan(void) {
     debounce_debug_update(raw_matrix, matrix, MATRIX_ROWS);
 #endif
 #endif
-    return (uint8_t)changed;
+    return matrix_changed_rows(changed);
 }
@@ -0,0 +1,41 @@
+/*
+ * matrix_timer.h: Matrix scanning driven by a hardware timer.
+ *
+ * With `MATRIX_TIMER_SCAN_US` set, the matrix rows are scanned from a timer
+ * interrupt, one row per tick: each tick reads the columns of the row that
+ * was selected on the previous tick, unselects it, and selects the next row.
+ * Complete frames are double-buffered, and `matrix_scan` only consumes the
+ * latest complete frame, so the scan interval does not depend on the main
+ * loop (USB, LED updates, etc.), and there is no busy waiting for the rows to
+ * settle.
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifndef MATRIX_TIMER_SCAN_US
+/// The interval (µs) between complete matrix scans driven by a hardware
+/// timer, or 0 to scan from the main loop. The timer ticks once per row.
+#define MATRIX_TIMER_SCAN_US 0
+#endif
+
+#ifndef MATRIX_TIMER_MIN_TICK_US
+/// The minimum timer tick (µs), i.e., the time for the columns to settle
+/// after changing the selected row.
+#define MATRIX_TIMER_MIN_TICK_US 30
+#endif
+
+/// Start calling `matrix_timer_tick` from an interrupt every `tick_us`
+/// microseconds (provided by the platform).
+void matrix_timer_start(uint16_t tick_us);
+
+/// Scan the next row (provided by the matrix implementation).
+void matrix_timer_tick(void);
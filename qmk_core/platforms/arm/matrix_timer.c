@@ -0,0 +1,35 @@
+/**
+ * matrix_timer.c: ARM matrix scan timer (TIM6).
+ */
+
+#include <stdint.h>
+#include "platform_deps.h"
+#include "matrix_timer.h"
+
+#if MATRIX_TIMER_SCAN_US
+
+void matrix_timer_start(uint16_t tick_us) {
+    RCC->APB1ENR |= RCC_APB1ENR_TIM6EN;
+    (void) RCC->APB1ENR;
+
+    // APB1 is HCLK / 2, so the timer clock is doubled back to HCLK
+    TIM6->CR1 = TIM_CR1_ARPE;
+    TIM6->PSC = (SystemCoreClock / 1000000UL) - 1;
+    TIM6->ARR = tick_us - 1;
+    TIM6->EGR = TIM_EGR_UG;
+    TIM6->SR = 0;
+    TIM6->DIER = TIM_DIER_UIE;
+
+    NVIC_ClearPendingIRQ(TIM6_DAC_IRQn);
+    NVIC_EnableIRQ(TIM6_DAC_IRQn);
+    TIM6->CR1 |= TIM_CR1_CEN;
+}
+
+void TIM6_DAC_IRQHandler(void) {
+    if (TIM6->SR & TIM_SR_UIF) {
+        TIM6->SR = ~TIM_SR_UIF;
+        matrix_timer_tick();
+    }
+}
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * i2c_queue.c: Interrupt-driven queue of I2C master transactions (AVR TWI).
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/twi.h>
+
+#include "i2c_queue.h"
+#include "timer.h"
+
+#define I2C_ACTION_READ 0x01
+#define I2C_ACTION_WRITE 0x00
+
+#define TWCR_NEXT   ((1 << TWINT) | (1 << TWEN) | (1 << TWIE))
+#define TWCR_ACK    (TWCR_NEXT | (1 << TWEA))
+#define TWCR_START  (TWCR_NEXT | (1 << TWSTA))
+#define TWCR_STOP   ((1 << TWINT) | (1 << TWEN) | (1 << TWSTO))
+
+static struct i2c_transaction *queue[I2C_QUEUE_SIZE];
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_count = 0;
+static volatile i2c_status_t last_status = I2C_STATUS_SUCCESS;
+
+static uint8_t byte_index;
+static bool is_reading;
+
+/// Start the transaction at the head of the queue (from the interrupt
+/// handler, or with interrupts disabled).
+static void
+start_transaction (void) {
+    byte_index = 0;
+    is_reading = (queue[queue_head]->tx_length == 0);
+    TWCR = TWCR_START;
+}
+
+/// Finish the transaction at the head of the queue with `status`. The next
+/// one is started with a repeated start, or on error the rest are aborted.
+static void
+finish_transaction (i2c_status_t status) {
+    last_status = status;
+    do {
+        queue[queue_head]->status = status;
+        queue_head = (queue_head + 1) % I2C_QUEUE_SIZE;
+    } while (--queue_count && status < 0);
+
+    if (queue_count) {
+        start_transaction();
+    } else {
+        TWCR = TWCR_STOP;
+    }
+}
+
+ISR(TWI_vect) {
+    struct i2c_transaction *const transaction = queue[queue_head];
+
+    switch (TW_STATUS) {
+    case TW_START:
+    case TW_REP_START:
+        TWDR = transaction->address | (is_reading ? I2C_ACTION_READ : I2C_ACTION_WRITE);
+        TWCR = TWCR_NEXT;
+        break;
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+        if (byte_index < transaction->tx_length) {
+            TWDR = transaction->tx_data[byte_index++];
+            TWCR = TWCR_NEXT;
+        } else if (transaction->rx_length) {
+            byte_index = 0;
+            is_reading = true;
+            TWCR = TWCR_START;
+        } else {
+            finish_transaction(I2C_STATUS_SUCCESS);
+        }
+        break;
+    case TW_MR_DATA_ACK:
+        transaction->rx_data[byte_index++] = TWDR;
+        // fallthrough
+    case TW_MR_SLA_ACK:
+        // Acknowledge all but the last byte
+        TWCR = (byte_index + 1 < transaction->rx_length) ? TWCR_ACK : TWCR_NEXT;
+        break;
+    case TW_MR_DATA_NACK:
+        transaction->rx_data[byte_index] = TWDR;
+        finish_transaction(I2C_STATUS_SUCCESS);
+        break;
+    default:
+        finish_transaction(I2C_STATUS_ERROR);
+        break;
+    }
+}
+
+bool
+i2c_queue_add (struct i2c_transaction *transaction) {
+    bool is_added = false;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (queue_count < I2C_QUEUE_SIZE) {
+            transaction->status = I2C_STATUS_PENDING;
+            queue[(queue_head + queue_count) % I2C_QUEUE_SIZE] = transaction;
+            if (queue_count++ == 0) {
+                // Let the stop condition of the previous transaction finish
+                while (TWCR & (1 << TWSTO)) { }
+                start_transaction();
+            }
+            is_added = true;
+        }
+    }
+
+    return is_added;
+}
+
+bool
+i2c_queue_is_busy (void) {
+    return queue_count != 0;
+}
+
+i2c_status_t
+i2c_queue_wait (uint16_t timeout) {
+    const uint16_t start_time = timer_read();
+
+    while (queue_count) {
+        if (timeout != I2C_TIMEOUT_INFINITE && timer_elapsed(start_time) > timeout) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                // Reset the TWI (this also releases the bus)
+                TWCR = 0;
+                while (queue_count) {
+                    queue[queue_head]->status = I2C_STATUS_TIMEOUT;
+                    queue_head = (queue_head + 1) % I2C_QUEUE_SIZE;
+                    --queue_count;
+                }
+                last_status = I2C_STATUS_TIMEOUT;
+            }
+            break;
+        }
+    }
+
+    return last_status;
+}
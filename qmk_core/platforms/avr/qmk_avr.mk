@@ -13,5 +13,5 @@ vpath %.c $(PLATFORM_DIR)/bootloaders
 $(BUILDDIR)/qmk_port.o: platform_deps.h qmk_port.h
 $(BUILDDIR)/platform.o: platform_deps.h
 $(BUILDDIR)/timer.o: timer.h timer_avr.h
-$(BUILDDIR)/suspend.o: suspend.h timer.h action.h keyboard.h
+$(BUILDDIR)/suspend.o: suspend.h timer.h action.h keyboard.h matrix.h gpio.h wait.h usb_hardware.h
 $(BUILDDIR)/$(BOOTLOADER_TYPE).o: bootloader.h platform_deps.h $(COMMON_HEADERS)
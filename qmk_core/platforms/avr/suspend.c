@@ -25,6 +25,11 @@
 #include "suspend.h"
 #include "action.h"
 #include "timer.h"
+#include "matrix.h"
+#include "gpio.h"
+#include "wait.h"
+#include "usb_hardware.h"
+#include "scan_rate.h"
 
 extern volatile uint8_t usb_keyboard_leds;
 
@@ -84,6 +89,56 @@ static void power_down(uint8_t wdto) {
     wdt_disable();
 }
 
+#    ifndef SUSPEND_WAKEUP_SCAN_MS
+/// After waking up from deep sleep on a keypress, how long (ms) to scan the
+/// matrix without sleeping, so that debouncing the key is not delayed by the
+/// watchdog interval.
+#        define SUSPEND_WAKEUP_SCAN_MS 50
+#    endif
+
+extern matrix_row_t raw_matrix[MATRIX_ROWS];
+
+static bool     is_woken_by_key = false;
+static uint16_t woken_by_key_time;
+
+static bool raw_matrix_has_keys_down(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (raw_matrix[row]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** \brief Power down MCU until a keypress or USB wake-up
+ *
+ * Returns false if the keypress interrupts could not be armed, in which
+ * case the MCU did not sleep.
+ */
+static bool deep_power_down(void) {
+    bool is_armed;
+
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    cli();
+    is_armed = usb_is_suspended() && suspend_wakeup_interrupt_enable();
+    if (is_armed) {
+        // Interrupts are enabled only after sleep_cpu(), so a pending wake-up
+        // interrupt wakes it up immediately.
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+
+        cli();
+        suspend_wakeup_interrupt_disable();
+        is_woken_by_key = usb_is_suspended();
+        woken_by_key_time = timer_read();
+    }
+    sei();
+
+    return is_armed;
+}
+
 /* watchdog timeout */
 ISR(WDT_vect) {
     // compensate timer for sleep
@@ -109,11 +164,107 @@ void suspend_power_down(void) {
 
 #ifndef NO_SUSPEND_POWER_DOWN
 #    if defined(WDT_vect)
-    power_down(WDTO_15MS);
+    if (raw_matrix_has_keys_down()) {
+        if (is_woken_by_key && timer_elapsed(woken_by_key_time) < SUSPEND_WAKEUP_SCAN_MS) {
+            // Scan again without sleeping
+            return;
+        }
+        is_woken_by_key = false;
+        power_down(WDTO_15MS);
+    } else if (!deep_power_down()) {
+        power_down(WDTO_15MS);
+    }
 #    endif
 #endif
 }
 
+#ifndef SUSPEND_WAKEUP_ON_KEYPRESS
+/// Sleep until a keypress with a pin change interrupt during USB suspend,
+/// instead of waking up to scan the matrix every 15 ms. This needs a COL2ROW
+/// GPIO matrix with all of its columns on port B (PCINT0-7), which is checked
+/// at compile time. None of the AVR keyboards in this repository qualify: the
+/// ErgoDox has its Teensy columns on port F, which has no pin change
+/// interrupts, and the others have capacitive sensing matrices.
+#define SUSPEND_WAKEUP_ON_KEYPRESS 0
+#endif
+
+#if SUSPEND_WAKEUP_ON_KEYPRESS
+#if defined(NO_SUSPEND_POWER_DOWN) || !defined(WDT_vect) || !defined(PCICR)
+#error "SUSPEND_WAKEUP_ON_KEYPRESS needs the power down sleep and pin change interrupts"
+#endif
+#if !defined(MATRIX_ROW_PINS) || !defined(MATRIX_COL_PINS) || !defined(DIODE_DIRECTION) || (DIODE_DIRECTION != COL2ROW)
+#error "SUSPEND_WAKEUP_ON_KEYPRESS needs a COL2ROW GPIO matrix"
+#endif
+
+// Check that the columns are on port B by expanding the pin list with each
+// pin as an array designator: port B pins get the indices 0-7, and pins on
+// the other ports are beyond that.
+#pragma push_macro("PINDEF")
+#undef PINDEF
+#define PINDEF(port, pin)   [(SUSPEND_PORT_INDEX_##port * 8) + (pin)] = 1
+#define SUSPEND_PORT_INDEX_B 0
+#define SUSPEND_PORT_INDEX_A 1
+#define SUSPEND_PORT_INDEX_C 2
+#define SUSPEND_PORT_INDEX_D 3
+#define SUSPEND_PORT_INDEX_E 4
+#define SUSPEND_PORT_INDEX_F 5
+_Static_assert(sizeof((const char[]) MATRIX_COL_PINS) <= 8,
+    "SUSPEND_WAKEUP_ON_KEYPRESS needs all of MATRIX_COL_PINS on port B");
+#pragma pop_macro("PINDEF")
+
+/*
+ * Wake-up on keypress: all rows are driven low, so any keypress pulls its
+ * column low, which triggers the pin change interrupt of port B.
+ */
+static const pin_t suspend_row_pins[MATRIX_ROWS] = MATRIX_ROW_PINS;
+static const pin_t suspend_col_pins[MATRIX_COLS] = MATRIX_COL_PINS;
+
+bool suspend_wakeup_interrupt_enable(void) {
+    uint8_t col_mask = 0;
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        const pin_t pin = suspend_col_pins[col];
+        if (pin == NO_PIN) {
+            continue;
+        }
+        col_mask |= _BV(pin & 0x07);
+    }
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (suspend_row_pins[row] != NO_PIN) {
+            gpio_set_pin_output(suspend_row_pins[row]);
+            gpio_write_pin_low(suspend_row_pins[row]);
+        }
+    }
+    wait_us(30);
+
+    if ((PINB & col_mask) != col_mask) {
+        // A key is already down, so it would not cause a pin change
+        suspend_wakeup_interrupt_disable();
+        return false;
+    }
+
+    PCMSK0 = col_mask;
+    PCIFR  = _BV(PCIF0);
+    PCICR |= _BV(PCIE0);
+    return true;
+}
+
+void suspend_wakeup_interrupt_disable(void) {
+    PCICR &= ~_BV(PCIE0);
+    PCMSK0 = 0;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (suspend_row_pins[row] != NO_PIN) {
+            gpio_set_pin_input_high(suspend_row_pins[row]);
+        }
+    }
+}
+
+ISR(PCINT0_vect) {
+    // Wakes up from sleep, and scans at the active rate for the keypress
+    PCICR &= ~_BV(PCIE0);
+    scan_rate_wake();
+}
+#endif
+
 void suspend_wakeup_init(void) {
     uint8_t saved_leds = usb_keyboard_leds;
 
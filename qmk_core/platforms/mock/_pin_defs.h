@@ -0,0 +1,9 @@
+/* _pin_defs.h: Mock for host simulation — pin names (A0..H15) so that any
+ * device config can be used, see `gpio.h` for the (non-)implementation.
+ */
+
+#pragma once
+
+#define PIN(port, num)  (((port) << 4) | (num))
+
+#include "../arm/_pin_defs.h"
@@ -0,0 +1,5 @@
+/* _timer.h: Mock for host simulation — fast timer size configuration. */
+
+#pragma once
+
+#define FAST_TIMER_T_SIZE 32
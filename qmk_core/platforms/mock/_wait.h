@@ -0,0 +1,10 @@
+/* _wait.h: Mock for host simulation — waiting advances the virtual clock. */
+
+#pragma once
+
+#include <stdint.h>
+#include "mock_platform.h"
+
+#define wait_ms(ms)             mock_advance_us((uint32_t) (ms) * 1000UL)
+#define wait_us(us)             mock_advance_us((uint32_t) (us))
+#define waitInputPinDelay()     do { } while (0)
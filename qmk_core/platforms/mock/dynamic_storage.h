@@ -10,7 +10,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifndef EEPROM_MAX
 #define EEPROM_MAX 1024
+#endif
 #define EEPROM_SENTINEL 0xA5
 
 // Eeprom RAM with sentinels for overflow detection
@@ -0,0 +1,20 @@
+/* gpio.h: Mock for host simulation — there are no pins, all writes are
+ * ignored and all reads are high (i.e., not pressed on active low pins).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint16_t pin_t;
+
+#define gpio_set_pin_input(pin)         do { (void) (pin); } while (0)
+#define gpio_set_pin_input_high(pin)    do { (void) (pin); } while (0)
+#define gpio_set_pin_input_low(pin)     do { (void) (pin); } while (0)
+#define gpio_set_pin_output(pin)        do { (void) (pin); } while (0)
+#define gpio_write_pin_high(pin)        do { (void) (pin); } while (0)
+#define gpio_write_pin_low(pin)         do { (void) (pin); } while (0)
+#define gpio_write_pin(pin, level)      do { (void) (pin); (void) (level); } while (0)
+#define gpio_read_pin(pin)              ((void) (pin), 1)
+#define gpio_toggle_pin(pin)            do { (void) (pin); } while (0)
@@ -0,0 +1,21 @@
+/* mock_platform.h: Mock for host simulation — virtual clock.
+ *
+ * The clock only advances when explicitly told to, either by the simulator
+ * driving the main loop or by the firmware waiting (`wait_ms`, etc.).
+ */
+
+#ifndef MOCK_PLATFORM_H
+#define MOCK_PLATFORM_H
+
+#include <stdint.h>
+
+/// The virtual time in microseconds since `timer_init()`.
+extern uint64_t mock_time_us;
+
+/// Advance the virtual clock by `us` microseconds.
+void mock_advance_us(uint32_t us);
+
+/// The number of times the firmware has jumped to the bootloader.
+extern unsigned mock_bootloader_jump_count;
+
+#endif
@@ -0,0 +1,143 @@
+/* platform.c: Mock for host simulation — virtual clock, RAM-backed EEPROM,
+ * and no-op platform setup, suspend and bootloader.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "platform_deps.h"
+#include "mock_platform.h"
+#include "dynamic_storage.h"
+#include "timer.h"
+#include "suspend.h"
+#include "bootloader.h"
+#include "qmk_port.h"
+
+void keyboard_wake_up(void);
+
+// MARK: - Virtual Clock
+
+uint64_t mock_time_us = 0;
+volatile uint32_t timer_count = 0;
+static uint32_t saved_ms;
+
+void
+mock_advance_us (uint32_t us) {
+    mock_time_us += us;
+    timer_count = (uint32_t) (mock_time_us / 1000U);
+}
+
+void timer_init(void) {
+    mock_time_us = 0;
+    timer_count = 0;
+}
+
+void timer_clear(void) {
+    timer_init();
+}
+
+void timer_save(void) {
+    saved_ms = timer_count;
+}
+
+void timer_restore(void) {
+    timer_count = saved_ms;
+}
+
+uint16_t timer_read(void) {
+    return (uint16_t) (timer_count & 0xFFFF);
+}
+
+uint32_t timer_read32(void) {
+    return timer_count;
+}
+
+// MARK: - EEPROM
+
+uint8_t eeprom_sentinel_head = EEPROM_SENTINEL;
+uint8_t eeprom_ram[EEPROM_MAX];
+uint8_t eeprom_sentinel_tail = EEPROM_SENTINEL;
+
+uint8_t
+eeprom_read_byte (const void *addr) {
+    return eeprom_ram[(uintptr_t) addr % EEPROM_MAX];
+}
+
+void
+eeprom_update_byte (void *addr, uint8_t val) {
+    eeprom_ram[(uintptr_t) addr % EEPROM_MAX] = val;
+}
+
+uint16_t
+eeprom_read_word (const void *addr) {
+    uint16_t value;
+    eeprom_read_block(&value, addr, sizeof(value));
+    return value;
+}
+
+void
+eeprom_update_word (void *addr, uint16_t val) {
+    eeprom_write_block(&val, addr, sizeof(val));
+}
+
+uint32_t
+eeprom_read_dword (const uint32_t *addr) {
+    uint32_t value;
+    eeprom_read_block(&value, addr, sizeof(value));
+    return value;
+}
+
+void
+eeprom_update_dword (uint32_t *addr, uint32_t val) {
+    eeprom_write_block(&val, addr, sizeof(val));
+}
+
+void
+eeprom_read_block (void *dst, const void *src, size_t n) {
+    uint8_t *d = dst;
+    for (size_t i = 0; i < n; ++i) {
+        d[i] = eeprom_read_byte((const uint8_t *) src + i);
+    }
+}
+
+void
+eeprom_write_block (const void *buf, void *addr, size_t len) {
+    const uint8_t *s = buf;
+    for (size_t i = 0; i < len; ++i) {
+        eeprom_update_byte((uint8_t *) addr + i, s[i]);
+    }
+}
+
+// MARK: - Platform
+
+void platform_setup(void) {
+    (void) memset(eeprom_ram, 0xFF, sizeof(eeprom_ram));
+}
+
+void protocol_setup(void) {
+}
+
+void protocol_pre_init(void) {
+}
+
+void protocol_post_init(void) {
+}
+
+void suspend_power_down(void) {
+    suspend_power_down_quantum();
+}
+
+void suspend_wakeup_init(void) {
+    keyboard_wake_up();
+    suspend_wakeup_init_quantum();
+}
+
+unsigned mock_bootloader_jump_count = 0;
+
+void bootloader_jump(void) {
+    ++mock_bootloader_jump_count;
+}
+
+void mcu_reset(void) {
+}
@@ -0,0 +1,7 @@
+/* platform_deps.h: Mock for host simulation — no hardware headers. */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
@@ -14,9 +14,19 @@ void suspend_power_down_user(void);
 void suspend_power_down_kb(void);
 void suspend_power_down_quantum(void);
 
+/// Press the keys that were pressed to wake up the host but released
+/// before the host resumed (the release comes from the next scan).
 void update_matrix_state_after_wakeup(void);
 void wakeup_matrix_handle_key_event(uint8_t row, uint8_t col, bool pressed);
 
+/// Arm interrupts that wake up the MCU from deep sleep on a keypress,
+/// returning `true` if armed and no key is currently down. Called with
+/// interrupts disabled. The default does nothing and returns `false`, in
+/// which case the platform polls the matrix during suspend.
+bool suspend_wakeup_interrupt_enable(void);
+/// Disarm the interrupts armed by `suspend_wakeup_interrupt_enable`.
+void suspend_wakeup_interrupt_disable(void);
+
 #ifndef USB_SUSPEND_WAKEUP_DELAY
 #    define USB_SUSPEND_WAKEUP_DELAY 0
 #endif
@@ -22,9 +22,19 @@
 #include "matrix.h"
 #include <qmk_port.h>
 
+/// The keys down in the last scan while suspended, in case one of them woke
+/// up the host but was released before the host resumed.
+static matrix_row_t wakeup_matrix[MATRIX_ROWS];
+
 __attribute__((weak)) void matrix_power_up(void) {}
 __attribute__((weak)) void matrix_power_down(void) {}
 
+__attribute__((weak)) bool suspend_wakeup_interrupt_enable(void) {
+    return false;
+}
+
+__attribute__((weak)) void suspend_wakeup_interrupt_disable(void) {}
+
 __attribute__((weak)) void suspend_power_down_user(void) {}
 
 __attribute__((weak)) void suspend_power_down_kb(void) {
@@ -41,5 +51,26 @@ bool suspend_wakeup_condition(void) {
     matrix_power_up();
     matrix_scan();
     matrix_power_down();
+    matrix_set_all_rows_changed();
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        wakeup_matrix[row] = matrix_get_row(row);
+    }
     return matrix_has_keys_pressed();
 }
+
+void update_matrix_state_after_wakeup(void) {
+    // Compare against a new scan, since the last scan while suspended is
+    // the one that set wakeup_matrix
+    (void) matrix_scan();
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        // Keys still down are pressed by the next scan, but the ones
+        // released during the wakeup need to be pressed here
+        matrix_row_t released = wakeup_matrix[row] & ~matrix_get_row(row);
+        wakeup_matrix[row] = 0;
+        for (uint8_t col = 0; released; col++, released >>= 1) {
+            if (released & 1) {
+                wakeup_matrix_handle_key_event(row, col, true);
+            }
+        }
+    }
+}
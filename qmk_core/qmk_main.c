@@ -32,6 +32,7 @@
 #include "quantum.h"
 #include "qmk_port.h"
 #include "keyboard.h"
+#include "scan_rate.h"
 
 #include <progmem.h>
 #include "platforms/bootloader.h"
@@ -40,6 +41,27 @@
 
 #define USB_ENUMERATION_TIMEOUT_MS  1200U
 
+#if ENABLE_PS2_DEVICE && ENABLE_FALLBACK_TO_PS2_FROM_USB
+#include "eeprom_driver.h"
+
+#ifndef PS2_HINT_HEAD_START_MS
+/// If PS/2 was chosen at the last power-up, how long to keep looking for a
+/// PS/2 host before attaching USB (e.g., for a host that holds the bus low
+/// while it boots).
+#define PS2_HINT_HEAD_START_MS      250U
+#endif
+
+#if PS2_LINES_NEVER_FLOAT
+#ifndef PS2_DETECT_INTERVAL_MS
+/// How often to look for a PS/2 host while waiting for USB enumeration.
+#define PS2_DETECT_INTERVAL_MS      10U
+#endif
+#endif
+
+#define PROTOCOL_HINT_USB           ((uint8_t) 1U)
+#define PROTOCOL_HINT_PS2           ((uint8_t) 2U)
+#endif
+
 #ifdef BACKLIGHT_ENABLE
 #include "backlight.h"
 #endif
@@ -68,6 +90,13 @@ current_10ms_tick_count (void) {
     return timer_read() / TICKS_PER_10MS;
 }
 
+#if KEY_TRACE_SIZE > 0
+uint16_t
+key_trace_timestamp_ms (void) {
+    return timer_read();
+}
+#endif
+
 #ifdef HAPTIC_ENABLE
 static uint8_t haptic_usb_is_configured = 0;
 #if ENABLE_PS2_DEVICE
@@ -113,42 +142,133 @@ switch_events (uint8_t key, uint8_t row, uint8_t col, bool pressed) {
 
 static matrix_row_t previous_matrix[MATRIX_ROWS] = { 0 };
 
+/// The index of the lowest set bit in `bits`, which must not be 0.
+#define lowest_bit_index(bits) ((int_fast8_t) ((sizeof(bits) <= sizeof(unsigned)) ? __builtin_ctz(bits) : __builtin_ctzl(bits)))
+
 static bool
 kbd_input (void) {
-    bool have_changes = matrix_scan();
+    // Take the changes since the previous call instead of only this scan,
+    // so that a scan elsewhere (e.g., in a macro) doesn't hide a change
+    (void) matrix_scan();
+    matrix_rows_mask_t changed_rows = matrix_take_changed_rows();
+    const bool have_changes = (changed_rows != 0);
+
+#ifdef MATRIX_HAS_GHOST
+    // Rows skipped due to ghosting need to be checked again
+    static matrix_rows_mask_t ghosted_rows = 0;
+    changed_rows |= ghosted_rows;
+    ghosted_rows = 0;
+#endif
+
+    while (changed_rows) {
+        const int_fast8_t row = lowest_bit_index(changed_rows);
+        changed_rows &= changed_rows - 1;
 
-    for (int_fast8_t row = 0; row < MATRIX_ROWS; ++row) {
         const matrix_row_t matrix_row = matrix_get_row(row);
-        const matrix_row_t matrix_change = matrix_row ^ previous_matrix[row];
+        matrix_row_t matrix_change = matrix_row ^ previous_matrix[row];
         if (matrix_change) {
 #ifdef MATRIX_HAS_GHOST
-            if (has_ghost_in_row(r, matrix_row)) {
+            if (has_ghost_in_row(row, matrix_row)) {
+                ghosted_rows |= ((matrix_rows_mask_t) 1) << row;
                 continue;
             }
 #endif
-            matrix_row_t column_bit = 1;
-            for (int_fast8_t column = 0; column < MATRIX_COLS; ++column, column_bit <<= 1) {
-                if (matrix_change & column_bit) {
-                    const bool is_key_release = ((matrix_row & column_bit) == 0);
-                    const uint8_t key = usb_keycode_for_matrix(row, column);
-                    if (key) {
-                        process_key(key, is_key_release, row, column);
-                    }
-                    switch_events(key, row, column, !is_key_release);
+            do {
+                const int_fast8_t column = lowest_bit_index(matrix_change);
+                matrix_change &= matrix_change - 1;
+
+                const bool is_key_release = ((matrix_row & (((matrix_row_t) 1) << column)) == 0);
+                const uint8_t key = usb_keycode_for_matrix(row, column);
+                if (key) {
+                    process_key(key, is_key_release, row, column);
                 }
-            }
+                switch_events(key, row, column, !is_key_release);
+            } while (matrix_change);
             previous_matrix[row] = matrix_row;
         }
     }
     return have_changes;
 }
 
+void
+wakeup_matrix_handle_key_event (uint8_t row, uint8_t col, bool pressed) {
+    const matrix_row_t column_bit = ((matrix_row_t) 1) << col;
+    if (((previous_matrix[row] & column_bit) != 0) == pressed) {
+        return;
+    }
+    const uint8_t key = usb_keycode_for_matrix(row, col);
+    if (key) {
+        process_key(key, !pressed, row, col);
+    }
+    switch_events(key, row, col, pressed);
+    // The next scan will see the change back to the actual state
+    previous_matrix[row] ^= column_bit;
+    matrix_set_all_rows_changed();
+}
+
+#if ENABLE_PS2_DEVICE && ENABLE_FALLBACK_TO_PS2_FROM_USB
+/// Is a PS/2 host detected within `milliseconds`? The lines are discharged
+/// before each check, so floating lines don't read as high.
+static bool
+ps2_host_detected_within (const uint16_t milliseconds) {
+    const uint16_t start = timer_read();
+    for (;;) {
+        ps2_device_init();
+        if (ps2_device_host_detected()) {
+            return true;
+        }
+        if (TIMER_DIFF_FAST(timer_read(), start) >= milliseconds) {
+            return false;
+        }
+    }
+}
+
+/// Wait for the USB host to begin enumeration, also looking for a PS/2 host
+/// at the same time if the PS/2 lines can't float (`PS2_LINES_NEVER_FLOAT`).
+/// Returns `true` iff USB was chosen, and `false` if a PS/2 host was detected
+/// or neither appeared within the timeout.
+static bool
+usb_enumeration_begins (void) {
+    const uint16_t usb_start = timer_read();
+#if PS2_LINES_NEVER_FLOAT
+    uint16_t ps2_check_time = usb_start;
+#endif
+
+    // The USB host assigns the address right after the bus reset, so this
+    // doesn't need to wait for the whole enumeration
+    while (!usb_address() && !usb_is_ok()) {
+        const uint16_t now = timer_read();
+        if (TIMER_DIFF_FAST(now, usb_start) >= USB_ENUMERATION_TIMEOUT_MS) {
+            return false;
+        }
+#if PS2_LINES_NEVER_FLOAT
+        if (TIMER_DIFF_FAST(now, ps2_check_time) >= PS2_DETECT_INTERVAL_MS) {
+            ps2_check_time = now;
+
+            // Only sample the lines, since discharging them with
+            // `ps2_device_init()` would drive the bus while USB is attached
+            // (the pins are still inputs from the check before `usb_init()`).
+            // If the pins are shared with USB, the full speed idle J state
+            // has D+ high but D- low, so they never both read high here.
+            if (ps2_device_host_detected()) {
+                return false;
+            }
+        }
+#endif
+    }
+    return true;
+}
+#endif
+
 static void
 protocol_init (void) {
 #if ENABLE_PS2_DEVICE && ENABLE_FALLBACK_TO_PS2_FROM_USB
     // The timer is needed for the fallback, well, timer.
     // It is also called later in keyboard_init(), which resets it later.
     timer_init();
+
+    const uint8_t hint = eeprom_read_byte(EECONFIG_PROTOCOL_HINT);
+    uint16_t ps2_head_start_ms = (hint == PROTOCOL_HINT_PS2) ? PS2_HINT_HEAD_START_MS : 0U;
 #endif
     protocol_pre_init();
 
@@ -159,8 +279,16 @@ protocol_init (void) {
         usb_deinit();
 
         // Try PS/2 first
+#if ENABLE_FALLBACK_TO_PS2_FROM_USB
+        // If it was PS/2 last time, give it a head start (only once)
+        const bool is_ps2_host = ps2_host_detected_within(ps2_head_start_ms);
+        ps2_head_start_ms = 0U;
+        if (is_ps2_host) {
+            eeprom_update_byte(EECONFIG_PROTOCOL_HINT, PROTOCOL_HINT_PS2);
+#else
         ps2_device_init();
         if (ps2_device_host_detected()) {
+#endif
             ps2_output_init();
 
             // NOTE: PS/2 and USB can't both be active at once. Make sure this is
@@ -186,20 +314,13 @@ protocol_init (void) {
 
 #if ENABLE_PS2_DEVICE
 #if ENABLE_FALLBACK_TO_PS2_FROM_USB
-        // Wait for USB to enumerate; loop back to try PS/2 on timeout
-        {
-            uint16_t usb_start = timer_read();
-            while (!usb_is_ok()) {
-                if (TIMER_DIFF_FAST(timer_read(), usb_start) >= USB_ENUMERATION_TIMEOUT_MS) {
-                    break;
-                }
-            }
-        }
-
-        if (!usb_is_ok()) {
+        // Commit to whichever host appears first; loop back to try PS/2
+        // if it is detected, or if neither is within the timeout
+        if (!usb_enumeration_begins()) {
             protocol_pre_init();
             continue;
         }
+        eeprom_update_byte(EECONFIG_PROTOCOL_HINT, PROTOCOL_HINT_USB);
 #endif
         break;
     }
@@ -244,6 +365,9 @@ suspend_wakeup_init_quantum (void) {
     haptic_notify_usb_device_state_change();
 #endif
 
+    // The host was woken up by a key, or is about to be used again
+    scan_rate_wake();
+
     suspend_wakeup_init_kb();
 }
 
@@ -267,7 +391,10 @@ keyboard_task (void) {
     ps2_output_task();
 #endif
 
-    (void) kbd_input();
+    if (scan_rate_is_due(now)) {
+        (void) kbd_input();
+        scan_rate_scanned(now);
+    }
 
 #ifdef RGBLIGHT_ENABLE
     rgblight_task();
@@ -313,6 +440,7 @@ protocol_task (void) {
             }
         }
         suspend_wakeup_init();
+        update_matrix_state_after_wakeup();
     }
 #endif
 
@@ -373,6 +501,7 @@ keyboard_reset_or_wake (bool is_wake_up) {
     for (int_fast8_t row = 0; row < MATRIX_ROWS; ++row) {
         previous_matrix[row] = 0;
     }
+    matrix_set_all_rows_changed();
     usb_keyboard_reset();
     reset_keys(is_wake_up);
     delay_milliseconds(32);
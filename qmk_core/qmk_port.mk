@@ -10,6 +10,11 @@ DEBOUNCE ?= 5
 ifeq ($(DEBOUNCE),0)
 DEBOUNCE_TYPE ?= none
 else
+ifeq ($(DEBOUNCE_TUNING),1)
+# Per-key debounce times learned from the debounce statistics
+DEBOUNCE_TYPE ?= sym_defer_pk_tuned
+DEBOUNCE_DEBUG = 1
+endif
 DEBOUNCE_TYPE ?= sym_defer_g
 endif
 
@@ -33,7 +38,7 @@ KEYMAP_FILE = keymap
 endif
 endif
 
-QMK_CORE_OBJS = keyboard.o led.o qmk_port.o qmk_main.o $(KEYMAP_FILE).o matrix_common.o timer.o bitwise.o suspend.o suspend_core.o $(BOOTLOADER_TYPE).o $(DEBOUNCE_TYPE).o platform.o bootmagic.o eeconfig.o
+QMK_CORE_OBJS = keyboard.o led.o qmk_port.o qmk_main.o $(KEYMAP_FILE).o matrix_common.o timer.o bitwise.o suspend.o suspend_core.o $(BOOTLOADER_TYPE).o $(DEBOUNCE_TYPE).o platform.o bootmagic.o eeconfig.o scan_rate.o
 
 ifneq ($(NO_CONFIG_CHECK),1)
 QMK_CORE_OBJS += config_check.o
@@ -46,17 +51,26 @@ ifeq ($(DEBOUNCE_DEBUG),1)
 DEVICE_FLAGS += -DDEBOUNCE_DEBUG=1
 QMK_CORE_OBJS += debounce_debug.o
 endif
+
+ifeq ($(DEBOUNCE_TUNING),1)
+DEVICE_FLAGS += -DDEBOUNCE_TUNING=1
+QMK_CORE_OBJS += debounce_tuning.o
+endif
 endif
 
-$(BUILDDIR)/qmk_main.o: keys.h led.h aakbd.h usb_hardware.h usbkbd.h usbkbd_config.h keyboard.h keymap.h qmk_port.h progmem.h suspend.h timer.h haptic.h bootloader.h $(COMMON_HEADERS)
+$(BUILDDIR)/qmk_main.o: keys.h led.h aakbd.h usb_hardware.h usbkbd.h usbkbd_config.h keyboard.h keymap.h qmk_port.h progmem.h suspend.h timer.h haptic.h bootloader.h scan_rate.h $(COMMON_HEADERS)
+$(BUILDDIR)/scan_rate.o: scan_rate.h matrix.h $(COMMON_HEADERS)
 
 $(BUILDDIR)/$(KEYMAP_FILE).o: keymap.h
 $(BUILDDIR)/keyboard.o: keyboard.h led.h $(COMMON_HEADERS)
 $(BUILDDIR)/led.o: keys.h led.h debug.h host.h $(COMMON_HEADERS)
-$(BUILDDIR)/matrix_gpio.o: matrix.h debounce.h debug.h $(COMMON_HEADERS)
+$(BUILDDIR)/matrix_gpio.o: matrix.h matrix_timer.h debounce.h debug.h $(COMMON_HEADERS)
 $(BUILDDIR)/matrix_common.o: debounce.h debug.h $(COMMON_HEADERS)
+$(BUILDDIR)/debounce_tuning.o: $(QMK_DIR)/debounce/debounce_tuning.h eeconfig.h $(COMMON_HEADERS)
+$(BUILDDIR)/sym_defer_pk_tuned.o: debounce.h $(QMK_DIR)/debounce/debounce_tuning.h $(COMMON_HEADERS)
 ifeq ($(QMK_PLATFORM),avr)
 $(BUILDDIR)/i2c_master.o: i2c_master.h $(COMMON_HEADERS)
+$(BUILDDIR)/i2c_queue.o: i2c_queue.h i2c_master.h timer.h $(COMMON_HEADERS)
 endif
 $(BUILDDIR)/bitwise.o: bitwise.h util.h
 $(BUILDDIR)/suspend_core.o: suspend.h matrix.h qmk_port.h
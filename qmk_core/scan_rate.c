@@ -0,0 +1,114 @@
+/*
+ * scan_rate.c: Activity-aware matrix scan rate.
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "scan_rate.h"
+#include "config.h"
+#include "matrix.h"
+#include "timer.h"
+
+#if defined(DEBOUNCE) && (SCAN_RATE_ACTIVE_INTERVAL_MS || SCAN_RATE_IDLE_INTERVAL_MS)
+_Static_assert(SCAN_RATE_ACTIVE_MS > DEBOUNCE, "SCAN_RATE_ACTIVE_MS must be longer than DEBOUNCE");
+#endif
+_Static_assert(SCAN_RATE_ACTIVE_INTERVAL_MS <= SCAN_RATE_IDLE_INTERVAL_MS, "The idle scan interval is shorter than active");
+
+extern matrix_row_t raw_matrix[MATRIX_ROWS];
+
+static volatile bool is_woken = false;
+static bool is_active = true;
+static bool has_scanned = false;
+static uint16_t last_scan;
+static uint16_t last_activity;
+
+static uint16_t window_start;
+static uint16_t window_scans[2];
+static uint8_t window_max_interval;
+
+static uint16_t last_window_scans[2];
+static uint8_t last_window_max_interval;
+
+bool
+scan_rate_is_due (uint16_t now) {
+    if (is_woken) {
+        is_woken = false;
+        is_active = true;
+        last_activity = now;
+    }
+    if (!has_scanned) {
+        return true;
+    }
+    const uint16_t interval = is_active ? SCAN_RATE_ACTIVE_INTERVAL_MS : SCAN_RATE_IDLE_INTERVAL_MS;
+    return interval == 0 || TIMER_DIFF_16(now, last_scan) >= interval;
+}
+
+void
+scan_rate_scanned (uint16_t now) {
+    bool has_keys_down = false;
+    for (int_fast8_t row = 0; row < MATRIX_ROWS; ++row) {
+        if (raw_matrix[row]) {
+            has_keys_down = true;
+            break;
+        }
+    }
+
+    if (has_scanned) {
+        const uint16_t interval = TIMER_DIFF_16(now, last_scan);
+        if (interval > window_max_interval) {
+            window_max_interval = interval > UINT8_MAX ? UINT8_MAX : interval;
+        }
+    } else {
+        has_scanned = true;
+        window_start = now;
+    }
+    last_scan = now;
+    uint16_t *scans = &window_scans[is_active ? 1 : 0];
+    if (*scans != UINT16_MAX) {
+        ++*scans;
+    }
+
+    if (TIMER_DIFF_16(now, window_start) >= SCAN_RATE_STATS_WINDOW_MS) {
+        last_window_scans[0] = window_scans[0];
+        last_window_scans[1] = window_scans[1];
+        last_window_max_interval = window_max_interval;
+        window_scans[0] = 0;
+        window_scans[1] = 0;
+        window_max_interval = 0;
+        window_start = now;
+    }
+
+    if (has_keys_down) {
+        is_active = true;
+        last_activity = now;
+    } else if (is_active && TIMER_DIFF_16(now, last_activity) >= SCAN_RATE_ACTIVE_MS) {
+        is_active = false;
+    }
+}
+
+void
+scan_rate_wake (void) {
+    is_woken = true;
+}
+
+uint8_t
+scan_rate_read_stats (uint8_t buffer[static SCAN_RATE_STATS_SIZE]) {
+    buffer[0] = is_active ? 1 : 0;
+    buffer[1] = SCAN_RATE_ACTIVE_INTERVAL_MS;
+    buffer[2] = SCAN_RATE_IDLE_INTERVAL_MS;
+    buffer[3] = SCAN_RATE_ACTIVE_MS & 0xFF;
+    buffer[4] = (SCAN_RATE_ACTIVE_MS >> 8) & 0xFF;
+    buffer[5] = SCAN_RATE_STATS_WINDOW_MS & 0xFF;
+    buffer[6] = (SCAN_RATE_STATS_WINDOW_MS >> 8) & 0xFF;
+    buffer[7] = last_window_scans[1] & 0xFF;
+    buffer[8] = (last_window_scans[1] >> 8) & 0xFF;
+    buffer[9] = last_window_scans[0] & 0xFF;
+    buffer[10] = (last_window_scans[0] >> 8) & 0xFF;
+    buffer[11] = last_window_max_interval;
+    return SCAN_RATE_STATS_SIZE;
+}
@@ -0,0 +1,68 @@
+/*
+ * scan_rate.h: Activity-aware matrix scan rate.
+ *
+ * The matrix is scanned with the active profile while any key is down in the
+ * raw matrix and for `SCAN_RATE_ACTIVE_MS` after that, and with the idle
+ * profile otherwise. A key down in any scan switches to the active profile
+ * immediately, so the first press is delayed by at most the idle interval.
+ * `scan_rate_wake` also switches to the active profile; it is called on
+ * wakeup from suspend (including the keypress pin change interrupt).
+ *
+ * The profiles are configured in the keyboard's `config.h`. By default both
+ * intervals are 0, i.e., the matrix is scanned on every main loop iteration
+ * as before. The actual scan intervals are measured either way.
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SCAN_RATE_ACTIVE_INTERVAL_MS
+/// The minimum interval (ms) between scans when active (0 = every loop).
+#define SCAN_RATE_ACTIVE_INTERVAL_MS 0
+#endif
+
+#ifndef SCAN_RATE_IDLE_INTERVAL_MS
+/// The minimum interval (ms) between scans when idle (0 = every loop).
+#define SCAN_RATE_IDLE_INTERVAL_MS 0
+#endif
+
+#ifndef SCAN_RATE_ACTIVE_MS
+/// How long (ms) to stay active after the last key is released. This must
+/// be longer than `DEBOUNCE` so that releases are debounced at the active
+/// rate.
+#define SCAN_RATE_ACTIVE_MS 1000
+#endif
+
+#ifndef SCAN_RATE_STATS_WINDOW_MS
+/// The length (ms) of the window over which the scans are counted.
+#define SCAN_RATE_STATS_WINDOW_MS 1000
+#endif
+
+/// The size of the statistics from `scan_rate_read_stats`:
+/// `[0]` = 1 if active, `[1]` = active interval, `[2]` = idle interval,
+/// `[3..4]` = `SCAN_RATE_ACTIVE_MS`, `[5..6]` = window (ms), `[7..8]` = active
+/// scans in the last window, `[9..10]` = idle scans in the last window,
+/// `[11]` = the longest interval between scans in the last window (ms, at
+/// most 255). The 16-bit values are little-endian.
+#define SCAN_RATE_STATS_SIZE 12
+
+/// Returns `true` if the matrix should be scanned at time `now` (ms).
+bool scan_rate_is_due(uint16_t now);
+
+/// Called after each scan started at time `now`.
+void scan_rate_scanned(uint16_t now);
+
+/// Switch to the active profile. This may be called from an interrupt.
+void scan_rate_wake(void);
+
+/// Copy the statistics to `buffer`, returns `SCAN_RATE_STATS_SIZE`.
+uint8_t scan_rate_read_stats(uint8_t buffer[static SCAN_RATE_STATS_SIZE]);
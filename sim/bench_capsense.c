@@ -0,0 +1,407 @@
+/**
+ * bench_capsense.c: Host-side model of the calibrated capsense matrix scan.
+ *
+ * The capsense matrix of xwhatsit-type controllers can't be scanned on the
+ * host, so this models it: each key of the keyboard (from its `keymap.c`)
+ * gets a random capacitance level when released and when pressed, the keys
+ * are assigned to calibration bins by their level, and a column scan at a
+ * DAC threshold reads the keys whose level is above the threshold. The real
+ * scan planner (`xwhatsit_core/scan_plan.c`) is used to build the plan for
+ * each calibration.
+ *
+ * The same random calibrations and key presses are scanned with:
+ *
+ *      all columns     - every bin, every column (without skipping)
+ *      per bin         - each bin that has keys, only its columns with keys
+ *      planned         - the scan plan of `matrix.c`
+ *
+ * The number of DAC writes and column scans per scan are counted, and the
+ * time per scan is modelled from the settle times in the keyboard's
+ * `config.h` and the estimated overhead of a column scan and a DAC write.
+ * The modelled scans per second are printed for each number of bins in use.
+ * Every scheme must read exactly the pressed keys, otherwise the exit status
+ * is non-zero.
+ *
+ * Usage: bench_capsense.bin [-n calibrations]
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.dev/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "qmk_port.h"
+#include "scan_plan.h"
+
+#if !CAPSENSE_CAL_ENABLED
+#error "bench_capsense needs a capsense keyboard with calibration, e.g., DEVICE=modelf77"
+#endif
+
+#ifndef BENCH_DEFAULT_CALIBRATIONS
+/// The default number of random calibrations per number of bins.
+#define BENCH_DEFAULT_CALIBRATIONS 1000U
+#endif
+
+#ifndef BENCH_SCANS_PER_CALIBRATION
+/// The number of scans of each calibration (with different keys pressed).
+#define BENCH_SCANS_PER_CALIBRATION 16U
+#endif
+
+#ifndef BENCH_COLUMN_OVERHEAD_US
+/// The estimated time to select a column and sample the rows, in addition
+/// to `CAPSENSE_KEYBOARD_SETTLE_TIME_US`.
+#define BENCH_COLUMN_OVERHEAD_US 5.0
+#endif
+
+#ifndef BENCH_DAC_OVERHEAD_US
+/// The estimated time to shift a new value to the DAC, in addition to
+/// `CAPSENSE_DAC_SETTLE_TIME_US`.
+#define BENCH_DAC_OVERHEAD_US 3.0
+#endif
+
+#ifndef BENCH_SKIP_OVERHEAD_US
+/// The estimated time to check and skip a column without scanning it.
+#define BENCH_SKIP_OVERHEAD_US 0.5
+#endif
+
+/// The random part of the released level of keys (DAC units).
+#define LEVEL_SPREAD 60U
+/// The released level of keys is within this range, including the
+/// variation by row and column.
+#define LEVEL_RANGE (LEVEL_SPREAD + 8U * MATRIX_CAPSENSE_ROWS + 4U * MATRIX_COLS)
+/// The threshold is this much above the highest released level of its bin.
+#define THRESHOLD_OFFSET 20U
+/// A pressed key is this much above its released level.
+#define PRESSED_DELTA (LEVEL_RANGE + 2 * THRESHOLD_OFFSET)
+
+#define STRINGIFY_(x) #x
+#define STRINGIFY(x) STRINGIFY_(x)
+
+// Normally defined in `matrix.c`
+matrix_row_t assigned_to_threshold[CAPSENSE_CAL_BINS][MATRIX_CAPSENSE_ROWS + 1];
+uint16_t cal_thresholds[CAPSENSE_CAL_BINS];
+uint8_t cal_bin_rows_mask[CAPSENSE_CAL_BINS];
+uint8_t cal_bin_key_count[CAPSENSE_CAL_BINS];
+#if CAPSENSE_DRIFT_TRACKING
+uint16_t cal_bin_level[CAPSENSE_CAL_BINS];
+int16_t cal_bin_drift[CAPSENSE_CAL_BINS];
+#endif
+
+static uint32_t random_state = 1;
+
+static uint32_t
+next_random (void) {
+    // xorshift32, deterministic across platforms
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static inline bool
+is_key (uint8_t row, uint8_t col) {
+    return usb_keycode_for_matrix(row, col) != 0;
+}
+
+// MARK: - Keyboard model
+
+static uint16_t released_level[MATRIX_CAPSENSE_ROWS][MATRIX_COLS];
+static matrix_row_t pressed[MATRIX_CAPSENSE_ROWS];
+
+static uint16_t dac_threshold;
+static unsigned long dac_writes;
+static unsigned long column_scans;
+static unsigned long skipped_columns;
+
+static void
+model_dac_write (uint16_t value) {
+    // Like `dac_write_threshold`, an unchanged value is not written
+    if (value != dac_threshold) {
+        dac_threshold = value;
+        ++dac_writes;
+    }
+}
+
+/// Returns the physical rows of `col` that read above the DAC threshold.
+static uint8_t
+model_scan_column (uint8_t col) {
+    uint8_t physical_rows = 0;
+    ++column_scans;
+    for (uint8_t row = 0; row < MATRIX_CAPSENSE_ROWS; ++row) {
+        uint16_t level = released_level[row][col];
+        if (pressed[row] & (((matrix_row_t) 1) << col)) {
+            level += PRESSED_DELTA;
+        }
+        if (level > dac_threshold) {
+            physical_rows |= 1 << CAPSENSE_KEYMAP_ROW_TO_PHYSICAL_ROW(row);
+        }
+    }
+    return physical_rows;
+}
+
+static inline uint8_t
+keymap_row (uint8_t physical_row_mask) {
+    for (uint8_t row = 0; row < MATRIX_CAPSENSE_ROWS; ++row) {
+        if (physical_row_mask == (1 << CAPSENSE_KEYMAP_ROW_TO_PHYSICAL_ROW(row))) {
+            return row;
+        }
+    }
+    return MATRIX_CAPSENSE_ROWS;
+}
+
+/// Generate a random calibration with the keys in `bins` bins, using the
+/// lowest `bins` bins. Non-keys get random levels (they may be always on).
+static void
+generate_calibration (uint8_t bins) {
+    (void) memset(assigned_to_threshold, 0, sizeof(assigned_to_threshold));
+    (void) memset(cal_bin_rows_mask, 0, sizeof(cal_bin_rows_mask));
+    (void) memset(cal_bin_key_count, 0, sizeof(cal_bin_key_count));
+
+    // The level varies with the distance of the key from the controller
+    const unsigned row_slope = next_random() % 8;
+    const unsigned col_slope = next_random() % 4;
+    const uint16_t bin_width = LEVEL_RANGE / bins + 1;
+    uint16_t bin_max[CAPSENSE_CAL_BINS] = { 0 };
+
+    for (uint8_t row = 0; row < MATRIX_CAPSENSE_ROWS; ++row) {
+        for (uint8_t col = 0; col < MATRIX_COLS; ++col) {
+            if (!is_key(row, col)) {
+                released_level[row][col] = next_random() % 1024;
+                continue;
+            }
+            const uint16_t level = row_slope * row + col_slope * col + next_random() % LEVEL_SPREAD;
+            released_level[row][col] = 100 + level;
+
+            uint8_t bin = level / bin_width;
+            if (bin >= bins) {
+                bin = bins - 1;
+            }
+            if (released_level[row][col] > bin_max[bin]) {
+                bin_max[bin] = released_level[row][col];
+            }
+            assigned_to_threshold[bin][row] |= ((matrix_row_t) 1) << col;
+            assigned_to_threshold[bin][ASSIGNED_KEYMAP_COLS_MASK_INDEX] |= ((matrix_row_t) 1) << col;
+            cal_bin_rows_mask[bin] |= 1 << CAPSENSE_KEYMAP_ROW_TO_PHYSICAL_ROW(row);
+            ++cal_bin_key_count[bin];
+        }
+    }
+
+    for (uint8_t bin = 0; bin < CAPSENSE_CAL_BINS; ++bin) {
+        cal_thresholds[bin] = bin_max[bin] + THRESHOLD_OFFSET;
+    }
+
+    scan_plan_build();
+}
+
+/// Press a few random keys.
+static void
+generate_presses (void) {
+    (void) memset(pressed, 0, sizeof(pressed));
+    for (unsigned count = next_random() % 5; count; --count) {
+        const uint8_t row = next_random() % MATRIX_CAPSENSE_ROWS;
+        const uint8_t col = next_random() % MATRIX_COLS;
+        if (is_key(row, col)) {
+            pressed[row] |= ((matrix_row_t) 1) << col;
+        }
+    }
+}
+
+// MARK: - Scan schemes
+
+/// Each bin, each column, like the original QMK firmware.
+static void
+scan_all_columns (matrix_row_t matrix[], bool ascending) {
+    for (int bin_index = 0; bin_index < CAPSENSE_CAL_BINS; ++bin_index) {
+        const int bin = ascending ? bin_index : CAPSENSE_CAL_BINS - 1 - bin_index;
+        model_dac_write(cal_thresholds[bin]);
+        for (uint8_t col = 0; col < MATRIX_COLS; ++col) {
+            const matrix_row_t col_mask = ((matrix_row_t) 1) << col;
+            uint8_t active = model_scan_column(col);
+            while (active) {
+                const uint8_t physical_row_mask = active & -active;
+                active ^= physical_row_mask;
+                const uint8_t row = keymap_row(physical_row_mask);
+                if (row < MATRIX_CAPSENSE_ROWS && (assigned_to_threshold[bin][row] & col_mask)) {
+                    matrix[row] |= col_mask;
+                }
+            }
+        }
+    }
+}
+
+/// Each bin that has keys, only the columns that have keys in the bin.
+static void
+scan_per_bin (matrix_row_t matrix[], bool ascending) {
+    for (int bin_index = 0; bin_index < CAPSENSE_CAL_BINS; ++bin_index) {
+        const int bin = ascending ? bin_index : CAPSENSE_CAL_BINS - 1 - bin_index;
+        const uint8_t bin_physical_rows_mask = cal_bin_rows_mask[bin];
+        if (bin_physical_rows_mask == 0) {
+            continue;
+        }
+        model_dac_write(cal_thresholds[bin]);
+
+        const matrix_row_t bin_columns_mask = assigned_to_threshold[bin][ASSIGNED_KEYMAP_COLS_MASK_INDEX];
+        for (uint8_t col = 0; col < MATRIX_COLS; ++col) {
+            const matrix_row_t col_mask = ((matrix_row_t) 1) << col;
+            if (!(bin_columns_mask & col_mask)) {
+                ++skipped_columns;
+                continue;
+            }
+            uint8_t active = model_scan_column(col) & bin_physical_rows_mask;
+            while (active) {
+                const uint8_t physical_row_mask = active & -active;
+                active ^= physical_row_mask;
+                const uint8_t row = keymap_row(physical_row_mask);
+                if (assigned_to_threshold[bin][row] & col_mask) {
+                    matrix[row] |= col_mask;
+                }
+            }
+        }
+    }
+}
+
+/// The scan plan, as in `matrix.c`.
+static void
+scan_planned (matrix_row_t matrix[], bool ascending) {
+    for (int group_index = 0; group_index < scan_plan_group_count; ++group_index) {
+        const int group = ascending ? group_index : scan_plan_group_count - 1 - group_index;
+        model_dac_write(scan_plan_threshold[group]);
+
+        const uint8_t end = scan_plan_group_end[group];
+        for (uint8_t step = group ? scan_plan_group_end[group - 1] : 0; step < end; ++step) {
+            const uint8_t col = scan_plan_col[step];
+            uint8_t active = model_scan_column(col) & scan_plan_rows[step];
+            while (active) {
+                const uint8_t physical_row_mask = active & -active;
+                active ^= physical_row_mask;
+                matrix[keymap_row(physical_row_mask)] |= ((matrix_row_t) 1) << col;
+            }
+        }
+    }
+}
+
+static const struct scheme {
+    const char *name;
+    void (*scan)(matrix_row_t matrix[], bool ascending);
+} schemes[] = {
+    { "all columns", scan_all_columns },
+    { "per bin", scan_per_bin },
+    { "planned", scan_planned },
+};
+#define SCHEME_COUNT ((int) (sizeof(schemes) / sizeof(*schemes)))
+
+// MARK: - Benchmark
+
+int
+main (int argc, char **argv) {
+    unsigned calibrations = BENCH_DEFAULT_CALIBRATIONS;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            calibrations = (unsigned) strtoul(argv[++i], NULL, 10);
+        } else {
+            (void) fprintf(stderr, "Usage: %s [-n calibrations]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (calibrations == 0) {
+        (void) fprintf(stderr, "%s: invalid arguments\n", argv[0]);
+        return 2;
+    }
+
+    unsigned key_count = 0;
+    for (uint8_t row = 0; row < MATRIX_CAPSENSE_ROWS; ++row) {
+        for (uint8_t col = 0; col < MATRIX_COLS; ++col) {
+            key_count += is_key(row, col);
+        }
+    }
+
+    const double column_us = CAPSENSE_KEYBOARD_SETTLE_TIME_US + BENCH_COLUMN_OVERHEAD_US;
+    const double dac_us = CAPSENSE_DAC_SETTLE_TIME_US + BENCH_DAC_OVERHEAD_US;
+
+    (void) printf("%s: %d×%d matrix, %u keys, %d bins, %u calibrations per row\n",
+        STRINGIFY(KEYBOARD_NAME), MATRIX_CAPSENSE_ROWS, MATRIX_COLS, key_count, CAPSENSE_CAL_BINS, calibrations);
+    (void) printf("Model: column scan %.1f µs, DAC write %.1f µs, skipped column %.1f µs\n\n",
+        column_us, dac_us, (double) BENCH_SKIP_OVERHEAD_US);
+    (void) printf("%-4s %-12s %9s %9s %9s %9s\n", "bins", "scheme", "DAC/scan", "cols/scan", "µs/scan", "scans/s");
+
+    int failures = 0;
+    for (uint8_t bins = 1; bins <= CAPSENSE_CAL_BINS; ++bins) {
+        for (int s = 0; s < SCHEME_COUNT; ++s) {
+            const struct scheme *scheme = &schemes[s];
+            unsigned long scans = 0, max_steps = 0;
+            unsigned long total_dac_writes = 0, total_column_scans = 0, total_skipped_columns = 0;
+
+            // Every scheme gets the same calibrations and presses
+            random_state = bins;
+
+            for (unsigned c = 0; c < calibrations; ++c) {
+                generate_calibration(bins);
+                if (scan_plan_group_count && scan_plan_group_end[scan_plan_group_count - 1] > max_steps) {
+                    max_steps = scan_plan_group_end[scan_plan_group_count - 1];
+                }
+
+                // The first scan after calibration sets the DAC, and is not
+                // counted
+                dac_threshold = CAPSENSE_DAC_MAX + 1;
+                bool ascending = true;
+                matrix_row_t matrix[MATRIX_CAPSENSE_ROWS];
+                (void) memset(matrix, 0, sizeof(matrix));
+                scheme->scan(matrix, ascending);
+                dac_writes = column_scans = skipped_columns = 0;
+
+                for (unsigned i = 0; i < BENCH_SCANS_PER_CALIBRATION; ++i) {
+                    generate_presses();
+                    ascending = !ascending;
+                    (void) memset(matrix, 0, sizeof(matrix));
+                    scheme->scan(matrix, ascending);
+                    ++scans;
+
+                    if (memcmp(matrix, pressed, sizeof(matrix)) != 0) {
+                        if (failures++ < 10) {
+                            (void) fprintf(stderr, "%s: wrong keys with %u bins (calibration %u, scan %u)\n",
+                                scheme->name, (unsigned) bins, c, i);
+                        }
+                    }
+                }
+
+                total_dac_writes += dac_writes;
+                total_column_scans += column_scans;
+                total_skipped_columns += skipped_columns;
+            }
+
+            const double dac_per_scan = (double) total_dac_writes / scans;
+            const double cols_per_scan = (double) total_column_scans / scans;
+            const double us_per_scan = dac_per_scan * dac_us + cols_per_scan * column_us
+                + ((double) total_skipped_columns / scans) * BENCH_SKIP_OVERHEAD_US;
+
+            (void) printf("%-4u %-12s %9.2f %9.2f %9.1f %9.0f", (unsigned) bins, scheme->name,
+                dac_per_scan, cols_per_scan, us_per_scan, 1000000.0 / us_per_scan);
+            if (scheme->scan == scan_planned) {
+                (void) printf("  (max %lu steps)", max_steps);
+            }
+            (void) putchar('\n');
+        }
+    }
+
+    if (failures) {
+        (void) fprintf(stderr, "%d scans read the wrong keys\n", failures);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,281 @@
+/**
+ * bench_debounce.c: Host-side benchmark of the QMK debounce algorithms.
+ *
+ * Each algorithm in `qmk_core/debounce` is compiled separately with its
+ * `debounce` and `debounce_init` functions renamed (see the Makefile), and
+ * all of them are fed the same pre-generated stream of raw matrix scans with
+ * bouncing key presses and releases, on the virtual clock of the mock
+ * platform. The time per `debounce` call and the number of debounced changes
+ * are printed for each algorithm.
+ *
+ * The output of `sym_eager_pk_vertical` must be identical to `sym_eager_pk`
+ * at every scan, otherwise the exit status is non-zero.
+ *
+ * Usage: bench_debounce.bin [-s scan_us] [-n presses] [-r rounds]
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.dev/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "matrix.h"
+#include "mock_platform.h"
+
+#ifndef DEBOUNCE
+#define DEBOUNCE 5
+#endif
+
+#ifndef BENCH_DEFAULT_SCAN_US
+/// The default virtual time between scans in microseconds.
+#define BENCH_DEFAULT_SCAN_US 500U
+#endif
+
+#ifndef BENCH_DEFAULT_PRESSES
+/// The default number of key presses (each followed by a release).
+#define BENCH_DEFAULT_PRESSES 20000U
+#endif
+
+#ifndef BENCH_DEFAULT_ROUNDS
+/// The default number of timed rounds, the fastest is reported.
+#define BENCH_DEFAULT_ROUNDS 5U
+#endif
+
+#ifndef BENCH_MAX_BOUNCE_MS
+/// The maximum duration of contact bounce after a change.
+#define BENCH_MAX_BOUNCE_MS ((DEBOUNCE > 1) ? (DEBOUNCE - 1) : 1)
+#endif
+
+#define DECLARE_DEBOUNCE(name) \
+    bool debounce_##name(matrix_row_t raw[], matrix_row_t cooked[], bool changed); \
+    void debounce_init_##name(void)
+
+DECLARE_DEBOUNCE(sym_defer_g);
+DECLARE_DEBOUNCE(sym_eager_pr);
+DECLARE_DEBOUNCE(sym_eager_pk);
+DECLARE_DEBOUNCE(asym_eager_defer_pk);
+DECLARE_DEBOUNCE(sym_eager_pk_vertical);
+
+#define ALGORITHM(name) { #name, debounce_##name, debounce_init_##name }
+
+static const struct algorithm {
+    const char *name;
+    bool (*debounce)(matrix_row_t raw[], matrix_row_t cooked[], bool changed);
+    void (*init)(void);
+} algorithms[] = {
+    ALGORITHM(sym_defer_g),
+    ALGORITHM(sym_eager_pr),
+    ALGORITHM(sym_eager_pk),
+    ALGORITHM(asym_eager_defer_pk),
+    ALGORITHM(sym_eager_pk_vertical),
+};
+#define ALGORITHM_COUNT ((int) (sizeof(algorithms) / sizeof(*algorithms)))
+
+/// The reference for `sym_eager_pk_vertical`, which must behave identically.
+#define REFERENCE_ALGORITHM 2
+#define VERTICAL_ALGORITHM 4
+
+// The mock platform calls these on suspend, which does not happen here
+void keyboard_wake_up(void) { }
+void suspend_power_down_quantum(void) { }
+void suspend_wakeup_init_quantum(void) { }
+
+// MARK: - Scan stream
+
+struct scan {
+    matrix_row_t raw[MATRIX_ROWS];
+    bool changed;
+};
+
+static struct scan *scans;
+static size_t scan_count;
+static uint32_t scan_us = BENCH_DEFAULT_SCAN_US;
+
+static uint32_t random_state = 1;
+
+static uint32_t
+next_random (void) {
+    // xorshift32, deterministic across platforms
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static void
+append_scan (matrix_row_t raw[MATRIX_ROWS]) {
+    struct scan *scan = &scans[scan_count];
+    memcpy(scan->raw, raw, sizeof(scan->raw));
+    scan->changed = scan_count == 0 || memcmp(raw, scans[scan_count - 1].raw, sizeof(scan->raw)) != 0;
+    ++scan_count;
+}
+
+/// Change the switch at `row`, `col` to `is_closed`, with random contact
+/// bounce, and then hold it for `hold_ms`.
+static void
+append_change (matrix_row_t raw[MATRIX_ROWS], uint8_t row, uint8_t col, bool is_closed, unsigned hold_ms) {
+    const matrix_row_t mask = MATRIX_ROW_SHIFTER << col;
+    const unsigned bounce_scans = ((next_random() % (BENCH_MAX_BOUNCE_MS + 1)) * 1000U) / scan_us;
+    for (unsigned i = 0; i < bounce_scans; ++i) {
+        if (next_random() & 1) {
+            raw[row] ^= mask;
+        }
+        append_scan(raw);
+    }
+    if (is_closed) {
+        raw[row] |= mask;
+    } else {
+        raw[row] &= ~mask;
+    }
+    const unsigned hold_scans = (hold_ms * 1000U) / scan_us;
+    for (unsigned i = 0; i <= hold_scans; ++i) {
+        append_scan(raw);
+    }
+}
+
+/// Generate typing with bouncy switches: each press is held for 20-100 ms,
+/// and the next key is pressed 10-150 ms after the release.
+static void
+generate_scans (unsigned presses) {
+    const unsigned max_scans_per_press = ((2 * BENCH_MAX_BOUNCE_MS + 100 + 150 + 2) * 1000U) / scan_us + 4;
+    scans = calloc((size_t) presses * max_scans_per_press + 1, sizeof(*scans));
+    if (!scans) {
+        perror("calloc");
+        exit(2);
+    }
+
+    matrix_row_t raw[MATRIX_ROWS] = { 0 };
+    for (unsigned i = 0; i < presses; ++i) {
+        const uint8_t row = next_random() % MATRIX_ROWS_PER_HAND;
+        const uint8_t col = next_random() % MATRIX_COLS;
+        append_change(raw, row, col, true, 20 + (next_random() % 81));
+        append_change(raw, row, col, false, 10 + (next_random() % 141));
+    }
+}
+
+// MARK: - Benchmark
+
+static uint64_t
+now_ns (void) {
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/// Run the whole scan stream through `algorithm`. If `hashes` is not `NULL`,
+/// a hash of the debounced matrix after each scan is stored there.
+static unsigned long
+run_scans (const struct algorithm *algorithm, uint32_t *hashes) {
+    matrix_row_t cooked[MATRIX_ROWS] = { 0 };
+    unsigned long changes = 0;
+
+    for (size_t i = 0; i < scan_count; ++i) {
+        mock_advance_us(scan_us);
+        changes += algorithm->debounce(scans[i].raw, cooked, scans[i].changed);
+        if (hashes) {
+            uint32_t hash = 2166136261U;
+            const uint8_t *bytes = (const uint8_t *) cooked;
+            for (size_t b = 0; b < sizeof(cooked); ++b) {
+                hash = (hash ^ bytes[b]) * 16777619U;
+            }
+            hashes[i] = hash;
+        }
+    }
+
+    // Let all counters expire before the next run
+    mock_advance_us(1000000U);
+    (void) algorithm->debounce(scans[scan_count - 1].raw, cooked, false);
+    return changes;
+}
+
+int
+main (int argc, char **argv) {
+    unsigned presses = BENCH_DEFAULT_PRESSES;
+    unsigned rounds = BENCH_DEFAULT_ROUNDS;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            scan_us = (uint32_t) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            presses = (unsigned) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rounds = (unsigned) strtoul(argv[++i], NULL, 10);
+        } else {
+            (void) fprintf(stderr, "Usage: %s [-s scan_us] [-n presses] [-r rounds]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (scan_us == 0 || presses == 0 || rounds == 0) {
+        (void) fprintf(stderr, "%s: invalid arguments\n", argv[0]);
+        return 2;
+    }
+
+    generate_scans(presses);
+
+    uint32_t *reference_hashes = calloc(scan_count, sizeof(uint32_t));
+    uint32_t *hashes = calloc(scan_count, sizeof(uint32_t));
+    if (!reference_hashes || !hashes) {
+        perror("calloc");
+        return 2;
+    }
+
+    (void) printf("%d×%d matrix, DEBOUNCE=%d, %zu scans every %u µs, %u presses\n\n",
+        MATRIX_ROWS, MATRIX_COLS, DEBOUNCE, scan_count, (unsigned) scan_us, presses);
+    (void) printf("%-24s %10s %10s\n", "algorithm", "ns/scan", "changes");
+
+    int failures = 0;
+    for (int a = 0; a < ALGORITHM_COUNT; ++a) {
+        const struct algorithm *algorithm = &algorithms[a];
+        algorithm->init();
+
+        // Untimed run to record the output for comparison
+        const unsigned long changes = run_scans(algorithm, a == REFERENCE_ALGORITHM ? reference_hashes : hashes);
+
+        uint64_t best_ns = UINT64_MAX;
+        for (unsigned round = 0; round < rounds; ++round) {
+            const uint64_t start = now_ns();
+            (void) run_scans(algorithm, NULL);
+            const uint64_t elapsed = now_ns() - start;
+            if (elapsed < best_ns) {
+                best_ns = elapsed;
+            }
+        }
+
+        (void) printf("%-24s %10.1f %10lu", algorithm->name, (double) best_ns / scan_count, changes);
+        if (a == VERTICAL_ALGORITHM) {
+            size_t mismatch = 0;
+            while (mismatch < scan_count && hashes[mismatch] == reference_hashes[mismatch]) {
+                ++mismatch;
+            }
+            if (mismatch < scan_count) {
+                (void) printf("  DIFFERS from %s at scan %zu", algorithms[REFERENCE_ALGORITHM].name, mismatch);
+                ++failures;
+            } else {
+                (void) printf("  (same as %s)", algorithms[REFERENCE_ALGORITHM].name);
+            }
+        }
+        (void) putchar('\n');
+    }
+
+    free(hashes);
+    free(reference_hashes);
+    free(scans);
+    return failures ? 1 : 0;
+}
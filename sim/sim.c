@@ -0,0 +1,562 @@
+/**
+ * sim.c: Host-side simulator for QMK-based AAKBD keyboards.
+ *
+ * This runs the real firmware main loop from `qmk_core/qmk_main.c`, with
+ * `usbkbd.c`, `keys.c`, the layers and macros, the QMK matrix and debounce
+ * code, on top of the `qmk_core/platforms/mock` platform. The matrix is
+ * driven by a script, the USB reports are captured, and time is virtual,
+ * so the results are deterministic. The USB tick is used as the hook that
+ * advances the virtual clock by one scan interval per main loop iteration.
+ *
+ * Usage: sim.bin [-v] [-s scan_us] [script]
+ *
+ * Script commands (one per line, `#` starts a comment, times in ms):
+ *
+ *      press ROW COL           - close the switch at ROW, COL
+ *      release ROW COL         - open the switch at ROW, COL
+ *      tap ROW COL [HOLD]      - press, wait HOLD (default 30), release
+ *      wait MS                 - advance the script time
+ *      random COUNT [INTERVAL] - tap COUNT random keys every INTERVAL ms
+ *      suspend                 - the USB host suspends the bus
+ *      resume                  - the USB host resumes the bus
+ *
+ * While suspended, a remote wakeup request from the keyboard resumes the bus
+ * after `SIM_REMOTE_WAKEUP_MS`.
+ *
+ * Without a script, `random 10000 40` is run.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.dev/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define USB_KEYBOARD_ACCESS_STATE 1
+#include "usbkbd.h"
+#include "usb_hardware.h"
+#include "generic_hid.h"
+#include "quantum.h"
+#include "qmk_port.h"
+#include "mock_platform.h"
+
+/// The entry point of the firmware (`main` in `qmk_main.c`).
+int firmware_main(void);
+
+#ifndef SIM_DEFAULT_SCAN_US
+/// The default virtual time per main loop iteration in microseconds.
+#define SIM_DEFAULT_SCAN_US 500U
+#endif
+
+#ifndef SIM_DEFAULT_HOLD_MS
+/// The default hold time of `tap`.
+#define SIM_DEFAULT_HOLD_MS 30U
+#endif
+
+#ifndef SIM_MAX_PENDING
+/// The maximum number of matrix events waiting for a report.
+#define SIM_MAX_PENDING 64
+#endif
+
+#ifndef SIM_PENDING_TIMEOUT_MS
+/// Matrix events that do not produce a report within this time are counted
+/// as not producing a report (e.g., layer keys).
+#define SIM_PENDING_TIMEOUT_MS 1000U
+#endif
+
+#ifndef SIM_REMOTE_WAKEUP_MS
+/// The time from a remote wakeup request to the host resuming the bus.
+#define SIM_REMOTE_WAKEUP_MS 20U
+#endif
+
+#ifndef SIM_MAX_BUS_EVENTS
+/// The maximum number of `suspend` and `resume` commands in the script.
+#define SIM_MAX_BUS_EVENTS 256
+#endif
+
+// MARK: - Script
+
+struct sim_event {
+    uint64_t time_us;
+    uint8_t row;
+    uint8_t col;
+    bool is_press;
+};
+
+static struct sim_event *events = NULL;
+static size_t event_count = 0;
+static size_t event_capacity = 0;
+static size_t next_event = 0;
+
+struct sim_bus_event {
+    uint64_t time_us;
+    bool is_suspend;
+};
+
+static struct sim_bus_event bus_events[SIM_MAX_BUS_EVENTS];
+static size_t bus_event_count = 0;
+static size_t next_bus_event = 0;
+
+static uint64_t script_time_us = 0;
+static uint32_t random_state = 0x2545F491U;
+
+static void
+add_event (uint8_t row, uint8_t col, bool is_press) {
+    if (event_count == event_capacity) {
+        event_capacity = event_capacity ? event_capacity * 2 : 1024;
+        events = realloc(events, event_capacity * sizeof(*events));
+        if (!events) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    events[event_count++] = (struct sim_event) {
+        .time_us = script_time_us, .row = row, .col = col, .is_press = is_press
+    };
+}
+
+static void
+add_bus_event (unsigned line_number, bool is_suspend) {
+    if (bus_event_count == SIM_MAX_BUS_EVENTS) {
+        (void) fprintf(stderr, "%u: too many suspend/resume commands\n", line_number);
+        exit(EXIT_FAILURE);
+    }
+    bus_events[bus_event_count++] = (struct sim_bus_event) {
+        .time_us = script_time_us, .is_suspend = is_suspend
+    };
+}
+
+static uint32_t
+next_random (void) {
+    // xorshift32
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static bool
+is_random_key (uint8_t key) {
+    // Only plain keys, modifiers and such would change the meaning of others
+    return key >= USB_KEY_A && key <= USB_KEY_SLASH;
+}
+
+static void
+add_random_taps (unsigned count, unsigned interval_ms) {
+    uint8_t positions[MATRIX_ROWS * MATRIX_COLS][2];
+    unsigned position_count = 0;
+    for (uint8_t row = 0; row < MATRIX_ROWS; ++row) {
+        for (uint8_t col = 0; col < MATRIX_COLS; ++col) {
+            if (is_random_key(usb_keycode_for_matrix(row, col))) {
+                positions[position_count][0] = row;
+                positions[position_count][1] = col;
+                ++position_count;
+            }
+        }
+    }
+    if (position_count == 0) {
+        (void) fprintf(stderr, "random: no suitable keys in the keymap\n");
+        exit(EXIT_FAILURE);
+    }
+    const uint64_t hold_us = (interval_ms * 1000ULL) / 2;
+    while (count--) {
+        const uint8_t *position = positions[next_random() % position_count];
+        add_event(position[0], position[1], true);
+        script_time_us += hold_us;
+        add_event(position[0], position[1], false);
+        script_time_us += (interval_ms * 1000ULL) - hold_us;
+    }
+}
+
+static void
+check_position (unsigned line_number, unsigned row, unsigned col) {
+    if (row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+        (void) fprintf(stderr, "%u: position %u, %u outside the %ux%u matrix\n",
+            line_number, row, col, (unsigned) MATRIX_ROWS, (unsigned) MATRIX_COLS);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void
+parse_script (FILE *file) {
+    char line[256];
+    unsigned line_number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        char command[16];
+        unsigned a = 0, b = 0, c = 0;
+        ++line_number;
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        const int n = sscanf(line, "%15s %u %u %u", command, &a, &b, &c);
+        if (n <= 0) {
+            continue;
+        }
+        if (strcmp(command, "press") == 0 && n == 3) {
+            check_position(line_number, a, b);
+            add_event(a, b, true);
+        } else if (strcmp(command, "release") == 0 && n == 3) {
+            check_position(line_number, a, b);
+            add_event(a, b, false);
+        } else if (strcmp(command, "tap") == 0 && n >= 3) {
+            check_position(line_number, a, b);
+            add_event(a, b, true);
+            script_time_us += (n > 3 ? c : SIM_DEFAULT_HOLD_MS) * 1000ULL;
+            add_event(a, b, false);
+        } else if (strcmp(command, "wait") == 0 && n == 2) {
+            script_time_us += a * 1000ULL;
+        } else if (strcmp(command, "random") == 0 && n >= 2) {
+            add_random_taps(a, n > 2 ? b : 40);
+        } else if (strcmp(command, "suspend") == 0 && n == 1) {
+            add_bus_event(line_number, true);
+        } else if (strcmp(command, "resume") == 0 && n == 1) {
+            add_bus_event(line_number, false);
+        } else {
+            (void) fprintf(stderr, "%u: syntax error: %s\n", line_number, line);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// MARK: - Statistics
+
+static bool verbose = false;
+static uint32_t scan_us = SIM_DEFAULT_SCAN_US;
+
+static uint64_t start_time_us = 0;
+static bool is_started = false;
+static unsigned long loop_count = 0;
+static unsigned long scan_count = 0;
+static unsigned long report_count = 0;
+static unsigned long consumer_report_count = 0;
+static unsigned long suspend_count = 0;
+static unsigned long remote_wakeup_count = 0;
+static uint64_t suspended_total_us = 0;
+
+static uint64_t pending[SIM_MAX_PENDING];
+static unsigned pending_count = 0;
+static unsigned long pending_dropped = 0;
+static unsigned long unreported_count = 0;
+
+static unsigned long deferral_count = 0;
+static uint64_t deferral_total_us = 0;
+static uint64_t deferral_min_us = UINT64_MAX;
+static uint64_t deferral_max_us = 0;
+
+static struct timespec wall_start;
+
+static void
+resolve_pending (bool is_reported) {
+    for (unsigned i = 0; i < pending_count; ++i) {
+        if (!is_reported) {
+            if (mock_time_us - pending[i] < SIM_PENDING_TIMEOUT_MS * 1000ULL) {
+                continue;
+            }
+            ++unreported_count;
+        } else {
+            const uint64_t deferral = mock_time_us - pending[i];
+            deferral_total_us += deferral;
+            if (deferral < deferral_min_us) {
+                deferral_min_us = deferral;
+            }
+            if (deferral > deferral_max_us) {
+                deferral_max_us = deferral;
+            }
+            ++deferral_count;
+        }
+        pending[i--] = pending[--pending_count];
+    }
+}
+
+static double
+wall_seconds (void) {
+    struct timespec now;
+    (void) clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - wall_start.tv_sec) + (now.tv_nsec - wall_start.tv_nsec) / 1e9;
+}
+
+static void
+finish (void) {
+    const double seconds = wall_seconds();
+    resolve_pending(false);
+    unreported_count += pending_count;
+
+    (void) printf("Matrix events:      %zu\n", event_count);
+    (void) printf("Keyboard reports:   %lu\n", report_count);
+    if (consumer_report_count) {
+        (void) printf("Consumer reports:   %lu\n", consumer_report_count);
+    }
+    (void) printf("Reports per event:  %.3f\n", event_count ? (double) report_count / event_count : 0.0);
+    if (deferral_count) {
+        (void) printf("Deferral (ms):      min %.3f, avg %.3f, max %.3f\n",
+            deferral_min_us / 1000.0, (deferral_total_us / 1000.0) / deferral_count,
+            deferral_max_us / 1000.0);
+    }
+    if (unreported_count || pending_dropped) {
+        (void) printf("Without report:     %lu (+%lu untracked)\n", unreported_count, pending_dropped);
+    }
+    if (suspend_count) {
+        (void) printf("Suspends:           %lu (%.1f ms suspended)\n", suspend_count, suspended_total_us / 1000.0);
+        (void) printf("Remote wakeups:     %lu\n", remote_wakeup_count);
+    }
+    (void) printf("Virtual time (ms):  %.1f\n", (mock_time_us - start_time_us) / 1000.0);
+    (void) printf("Main loops:         %lu (%u us each)\n", loop_count, (unsigned) scan_us);
+    (void) printf("Matrix scans:       %lu\n", scan_count);
+    (void) printf("Wall time (s):      %.3f\n", seconds);
+    if (seconds > 0) {
+        (void) printf("Events per second:  %.0f\n", event_count / seconds);
+        (void) printf("Loops per second:   %.0f\n", loop_count / seconds);
+    }
+    exit(mock_bootloader_jump_count ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+// MARK: - Virtual Matrix
+
+static matrix_row_t virtual_matrix[MATRIX_ROWS];
+
+void
+matrix_init_custom (void) {
+    (void) memset(virtual_matrix, 0, sizeof(virtual_matrix));
+}
+
+static void apply_due_events(void);
+
+bool
+matrix_scan_custom (matrix_row_t current_matrix[]) {
+    bool changed = false;
+    ++scan_count;
+    // Time also passes outside the main loop (e.g., in delays)
+    apply_due_events();
+    for (uint8_t row = 0; row < MATRIX_ROWS; ++row) {
+        if (current_matrix[row] != virtual_matrix[row]) {
+            current_matrix[row] = virtual_matrix[row];
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static void
+apply_due_events (void) {
+    while (next_event < event_count && start_time_us + events[next_event].time_us <= mock_time_us) {
+        const struct sim_event *event = &events[next_event++];
+        const matrix_row_t bit = MATRIX_ROW_SHIFTER << event->col;
+        if (event->is_press) {
+            virtual_matrix[event->row] |= bit;
+        } else {
+            virtual_matrix[event->row] &= ~bit;
+        }
+        if (pending_count < SIM_MAX_PENDING) {
+            pending[pending_count++] = mock_time_us;
+        } else {
+            ++pending_dropped;
+        }
+        if (verbose) {
+            (void) printf("%10.3f %s %u, %u (0x%02X)\n", (mock_time_us - start_time_us) / 1000.0,
+                event->is_press ? "press  " : "release", event->row, event->col,
+                usb_keycode_for_matrix(event->row, event->col));
+        }
+    }
+}
+
+// MARK: - Mock USB
+
+static bool is_suspended = false;
+static uint64_t suspend_time_us = 0;
+static uint64_t resume_time_us = UINT64_MAX;
+
+static void
+set_suspended (bool suspend) {
+    if (suspend == is_suspended) {
+        return;
+    }
+    is_suspended = suspend;
+    if (suspend) {
+        ++suspend_count;
+        suspend_time_us = mock_time_us;
+        resume_time_us = UINT64_MAX;
+    } else {
+        suspended_total_us += mock_time_us - suspend_time_us;
+    }
+    if (verbose) {
+        (void) printf("%10.3f %s\n", (mock_time_us - start_time_us) / 1000.0, suspend ? "suspend" : "resume");
+    }
+}
+
+static void
+apply_due_bus_events (void) {
+    while (next_bus_event < bus_event_count && start_time_us + bus_events[next_bus_event].time_us <= mock_time_us) {
+        set_suspended(bus_events[next_bus_event++].is_suspend);
+    }
+    if (is_suspended && mock_time_us >= resume_time_us) {
+        set_suspended(false);
+    }
+}
+
+static bool usb_is_initialized = false;
+
+void
+usb_init (void) {
+    usb_keyboard_reset();
+    usb_is_initialized = true;
+}
+
+void
+usb_bus_attach (void) {
+}
+
+void
+usb_bus_detach (void) {
+}
+
+void
+usb_deinit (void) {
+    usb_is_initialized = false;
+}
+
+/// Called once per firmware main loop iteration.
+void
+usb_tick (void) {
+    if (!is_started) {
+        is_started = true;
+        start_time_us = mock_time_us;
+    } else {
+        mock_advance_us(scan_us);
+    }
+    ++loop_count;
+    resolve_pending(false);
+    if (next_event >= event_count && next_bus_event >= bus_event_count) {
+        // Allow the last events to be debounced and reported, and run at
+        // least until the end of the script (e.g., a final `wait`)
+        if ((pending_count == 0 && mock_time_us - start_time_us >= script_time_us) || mock_time_us - events[event_count - 1].time_us - start_time_us > SIM_PENDING_TIMEOUT_MS * 1000ULL) {
+            finish();
+        }
+    }
+    apply_due_bus_events();
+    apply_due_events();
+}
+
+bool
+usb_is_ok (void) {
+    return usb_is_initialized;
+}
+
+uint8_t
+usb_is_configured (void) {
+    return usb_is_initialized ? 1 : 0;
+}
+
+uint8_t
+usb_last_error (void) {
+    return 0;
+}
+
+bool
+usb_is_suspended (void) {
+    return is_suspended;
+}
+
+uint8_t
+usb_detach_requested (void) {
+    return 0;
+}
+
+bool
+usb_wake_up_host (void) {
+    if (!is_suspended) {
+        return false;
+    }
+    if (resume_time_us == UINT64_MAX) {
+        ++remote_wakeup_count;
+        resume_time_us = mock_time_us + SIM_REMOTE_WAKEUP_MS * 1000ULL;
+        if (verbose) {
+            (void) printf("%10.3f remote wakeup\n", (mock_time_us - start_time_us) / 1000.0);
+        }
+    }
+    return true;
+}
+
+uint8_t
+usb_address (void) {
+    return 1;
+}
+
+bool
+usb_keyboard_send_report (void) {
+    usb_keyboard_updated = false;
+    ++report_count;
+    resolve_pending(true);
+    if (verbose) {
+        (void) printf("%10.3f report %02X:", (mock_time_us - start_time_us) / 1000.0, usb_keys_modifier_flags);
+        for (int_fast8_t i = 0; i < MAX_KEY_ROLLOVER && usb_keys_buffer[i]; ++i) {
+            (void) printf(" %02X", usb_keys_buffer[i]);
+        }
+        (void) putchar('\n');
+    }
+    return true;
+}
+
+bool
+usb_keyboard_send_consumer (uint16_t usage) {
+    ++consumer_report_count;
+    resolve_pending(true);
+    return true;
+}
+
+// MARK: - Main
+
+int
+main (int argc, char *argv[]) {
+    const char *path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            scan_us = (uint32_t) strtoul(argv[++i], NULL, 10);
+        } else {
+            path = argv[i];
+        }
+    }
+    if (scan_us == 0) {
+        (void) fprintf(stderr, "Usage: %s [-v] [-s scan_us] [script]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (path) {
+        FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+        if (!file) {
+            perror(path);
+            return EXIT_FAILURE;
+        }
+        parse_script(file);
+        if (file != stdin) {
+            (void) fclose(file);
+        }
+    } else {
+        add_random_taps(10000, 40);
+    }
+    if (event_count == 0) {
+        (void) fprintf(stderr, "No matrix events in the script.\n");
+        return EXIT_FAILURE;
+    }
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    return firmware_main();
+}
@@ -38,6 +38,9 @@ static uint8_t ps2_modifier_flags = 0;
 #if ENABLE_HOST_FINGERPRINT
 #include "host_fingerprint.h"
 #endif
+#if KEY_TRACE_SIZE > 0
+#include "key_trace.h"
+#endif
 #if DEBOUNCE_DEBUG
 #include "debounce/debounce_debug.h"
 #endif
@@ -680,6 +683,9 @@ bool
 usb_keyboard_send_if_needed (void) {
     bool did_send = false;
     if (usb_keyboard_updated) {
+#if KEY_TRACE_SIZE > 0
+        key_trace_report(usb_keys_modifier_flags, keys_buffer);
+#endif
         did_send = usb_keyboard_send_report();
     }
 #if MEDIA_KEYS_ENDPOINT
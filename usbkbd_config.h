@@ -176,6 +176,15 @@
 #define DEBOUNCE_DEBUG 0
 #endif
 
+#ifndef KEY_TRACE_SIZE
+/// The number of events in the key trace ring buffer (0 to disable, otherwise
+/// a power of two up to 128). Each event costs 8 bytes of RAM. The trace
+/// records physical key events and the resulting keyboard reports with
+/// millisecond timestamps, and can be read over the generic HID endpoint and
+/// replayed on the host with `vial/replay_trace.c`. See `key_trace.h`.
+#define KEY_TRACE_SIZE 0
+#endif
+
 #ifndef ENABLE_HOST_FINGERPRINT
 /// Enable USB host (computer operating system) fingerprinting. Needs to be
 /// supported by the USB implementation.
@@ -414,8 +423,12 @@
 /// decides whether to enable PS/2 or USB mode. But some PS/2 hosts are not
 /// easily detectable and may incorrectly go to USB mode (e.g., they may
 /// actively suppress the PS/2 bus on boot until they are ready). With this
-/// enabled, PS/2 detection will be attempted again if the USB fails to
-/// connect within a timeout.
+/// enabled, PS/2 detection is attempted again if the USB host doesn't appear
+/// within a timeout, and if the lines can't float (`PS2_LINES_NEVER_FLOAT`),
+/// they are also watched while waiting for the USB host so that whichever
+/// host appears first is chosen. The choice is remembered, and
+/// if it was PS/2, the next power-up looks for a PS/2 host a little longer
+/// (`PS2_HINT_HEAD_START_MS`) before trying USB.
 ///
 /// Downside: when connected to PS/2 if the pins are shared with USB, the USB
 /// attempt will look like noise on the PS/2 bus, which might confuse some
@@ -426,6 +439,27 @@
 #define ENABLE_FALLBACK_TO_PS2_FROM_USB 1
 #endif
 
+#ifndef PS2_LINES_NEVER_FLOAT
+/// Are the PS/2 lines always driven or pulled to a defined level, even when
+/// no PS/2 host is connected? This is the case if they are shared with USB
+/// (the USB host pulls D- low) or have external pull-down resistors. Only
+/// then can the fallback watch the PS/2 lines while USB is enumerating: the
+/// lines can't be discharged while USB is attached, and a floating line may
+/// read high and abort the USB enumeration. Otherwise the PS/2 host is only
+/// looked for before attaching USB and again after the USB timeout.
+#define PS2_LINES_NEVER_FLOAT 0
+#endif
+
+#ifndef ENABLE_PS2_DEVICE_TIMER
+/// Transfer PS/2 bytes from a timer compare interrupt, one clock phase per
+/// interrupt, instead of bit-banging each byte with interrupts disabled.
+/// This way the main loop (e.g., matrix scanning) keeps running while the
+/// output is in flight, and host commands are received and queued even if
+/// the main loop is busy. The cost is one 16-bit timer
+/// (`PS2_DEVICE_TIMER_NUM`, timer 1 by default).
+#define ENABLE_PS2_DEVICE_TIMER 0
+#endif
+
 #ifndef PS2_DEVICE_ID
 /// The PS/2 host can query the keyboard for a device id. Not all do, but some
 /// have special cases for specific keyboards (e.g., media key support based
@@ -0,0 +1,380 @@
+// Key processing throughput benchmark.
+//
+// Usage: bench_keys.bin [--check baseline.txt] [--threshold percent]
+//
+// Drives `process_key` (and thus `process_keycode`) with synthetic workloads
+// on top of the unit test harness, and prints one line per workload:
+//
+//      name  ns_per_event  relative  reports_per_event
+//
+// The name is suffixed with the total layer count of the build (e.g.,
+// `typing@9`), since the layer count affects key resolution. Each round of a
+// workload is timed as a whole, including the simulated passage of time
+// between events (i.e., the timers the events set off), and the fastest of
+// the rounds is reported. `relative` is the median over the rounds of the
+// time relative to a fixed calibration loop that doesn't use the key
+// processing, run right before the workload. It depends much less on the
+// speed of the machine than the absolute time does, but unlike a comparison
+// between the workloads, it also shows a slowdown of every workload alike.
+// The key trace is disabled in the build, so it is not part of the time.
+// "Reports" are the USB keyboard state changes (key presses, releases and
+// modifier changes) caused by an event; each one would be a report sent to
+// the host.
+//
+// With `--check`, the results are compared against a baseline (the output
+// of a previous run), and the exit status is non-zero if the relative time
+// of any workload is more than the threshold (default 25 %) above the
+// baseline, or if the number of reports per event changed at all. The
+// absolute time is only shown for information.
+
+#define KEYS_TEST_NO_MAIN 1
+#include "test_keys.c"
+
+#include <time.h>
+
+#ifndef BENCH_EVENTS
+/// The approximate number of events per workload per round.
+#define BENCH_EVENTS 2000
+#endif
+
+#ifndef BENCH_ROUNDS
+/// The number of rounds per workload, the fastest is reported.
+#define BENCH_ROUNDS 200
+#endif
+
+static unsigned long bench_events = 0;
+static unsigned long bench_reports = 0;
+
+static inline uint64_t
+now_ns (void) {
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static void
+matrix_position (uint8_t key, uint8_t *row, uint8_t *col) {
+    for (uint8_t r = 0; r < MATRIX_ROWS; ++r) {
+        for (uint8_t c = 0; c < MATRIX_COLS; ++c) {
+            if (pgm_read_byte(&keymaps[0][r][c]) == key) {
+                *row = r;
+                *col = c;
+                return;
+            }
+        }
+    }
+    *row = 0;
+    *col = key;
+}
+
+/// Drop the released entries from the test hook balance tracking, since it
+/// has a fixed capacity meant for short tests.
+static void
+compact_hook_entries (void) {
+    int count = 0;
+    for (int i = 0; i < hook_entry_count; ++i) {
+        if (hook_entries[i].active) {
+            hook_entries[count++] = hook_entries[i];
+        }
+    }
+    hook_entry_count = count;
+}
+
+/// Process one physical key event, then let `ms` pass.
+static void
+bench_key (uint8_t key, bool is_release, int ms) {
+    uint8_t row, col;
+    matrix_position(key, &row, &col);
+    compact_hook_entries();
+
+    const uint8_t mods = usb_keys_modifier_flags;
+    event_log_len = 0;
+
+    process_key(key, is_release, row, col);
+
+    bench_reports += event_log_len + (mods != usb_keys_modifier_flags);
+    ++bench_events;
+
+    if (ms > 0) {
+        advance_time(ms);
+    }
+}
+
+static void
+bench_tap (uint8_t key, int hold_ms, int gap_ms) {
+    bench_key(key, false, hold_ms);
+    bench_key(key, true, gap_ms);
+}
+
+static const uint8_t typing_keys[] = {
+    KEY(T), KEY(H), KEY(E), KEY(SPACE), KEY(Q), KEY(U), KEY(I), KEY(C), KEY(K), KEY(SPACE),
+    KEY(B), KEY(R), KEY(O), KEY(W), KEY(N), KEY(SPACE), KEY(F), KEY(O), KEY(X), KEY(PERIOD),
+};
+#define TYPING_KEY_COUNT ((int) (sizeof(typing_keys) / sizeof(*typing_keys)))
+
+// MARK: - Workloads
+
+/// Plain typing with no overlap between keys.
+static void
+workload_typing (void) {
+    for (int i = 0; i < BENCH_EVENTS / 2; ++i) {
+        bench_tap(typing_keys[i % TYPING_KEY_COUNT], 30, 30);
+    }
+}
+
+/// Fast typing where each key is pressed before the previous is released.
+static void
+workload_rollover (void) {
+    uint8_t previous = 0;
+    for (int i = 0; i < BENCH_EVENTS / 2; ++i) {
+        const uint8_t key = typing_keys[i % TYPING_KEY_COUNT];
+        if (key == previous) {
+            bench_tap(key, 10, 10);
+            previous = 0;
+            continue;
+        }
+        bench_key(key, false, 15);
+        if (previous) {
+            bench_key(previous, true, 15);
+        }
+        previous = key;
+    }
+    if (previous) {
+        bench_key(previous, true, 30);
+    }
+}
+
+/// Momentary layer switching: hold MO(1) on Caps Lock and type on the layer.
+static void
+workload_layers (void) {
+    dynamic_keymap_set_qmk_keycode(0, 0, 15, MO(1));
+    if (VIAL_LAYER_COUNT > 1) {
+        dynamic_keymap_set_qmk_keycode(1, 1, 0, KEY(1));
+        dynamic_keymap_set_qmk_keycode(1, 1, 1, KEY(2));
+    }
+    for (int i = 0; i < BENCH_EVENTS / 8; ++i) {
+        bench_key(KEY(CAPS_LOCK), false, 20);
+        bench_tap(KEY(Q), 20, 20);
+        bench_tap(KEY(W), 20, 20);
+        bench_tap(KEY(E), 20, 20);
+        bench_key(KEY(CAPS_LOCK), true, 20);
+    }
+}
+
+/// Home row mod-taps, rolled: each key pressed before the previous release.
+static void
+workload_mod_tap (void) {
+    static const uint8_t home_row[] = { KEY(A), KEY(S), KEY(D), KEY(F) };
+    static const uint8_t mods[] = { MOD_LGUI, MOD_LALT, MOD_LSFT, MOD_LCTL };
+    for (uint8_t i = 0; i < 4; ++i) {
+        dynamic_keymap_set_qmk_keycode(0, 2, i, MT(mods[i], home_row[i]));
+    }
+    for (int i = 0; i < BENCH_EVENTS / 6; ++i) {
+        const uint8_t a = home_row[i % 4];
+        const uint8_t b = home_row[(i + 1) % 4];
+        // Roll: a down, b down, a up, b up (taps)
+        bench_key(a, false, 15);
+        bench_key(b, false, 15);
+        bench_key(a, true, 15);
+        bench_key(b, true, 40);
+        // Hold: a as modifier for a plain key
+        bench_key(a, false, 250);
+        bench_tap(KEY(J), 20, 20);
+        bench_key(a, true, 40);
+    }
+}
+
+/// Two-key combo (J+K → Esc) interleaved with plain J and K taps.
+static void
+workload_combo (void) {
+    vial_combo_entry_t entry = { .input = { KEY(J), KEY(K), 0, 0 }, .output = KEY(ESC) };
+    dynamic_keymap_set_combo(0, &entry);
+    for (int i = 0; i < BENCH_EVENTS / 8; ++i) {
+        bench_key(KEY(J), false, 5);
+        bench_key(KEY(K), false, 30);
+        bench_key(KEY(J), true, 5);
+        bench_key(KEY(K), true, 40);
+        bench_tap(KEY(J), 30, 100);
+        bench_tap(KEY(K), 30, 100);
+    }
+}
+
+/// Tap dance on F14: single tap, double tap, and hold.
+static void
+workload_tap_dance (void) {
+    vial_tap_dance_entry_t entry = {
+        KEY(A), KEY(LEFT_CTRL), KEY(B), KEY(LEFT_SHIFT), 200
+    };
+    dynamic_keymap_set_tap_dance(0, &entry);
+    dynamic_keymap_set_qmk_keycode(0, 1, 13, QK_TAP_DANCE | 0);
+    for (int i = 0; i < BENCH_EVENTS / 8; ++i) {
+        bench_tap(KEY(F14), 30, 250);
+        bench_tap(KEY(F14), 30, 30);
+        bench_tap(KEY(F14), 30, 250);
+        bench_key(KEY(F14), false, 300);
+        bench_key(KEY(F14), true, 50);
+    }
+}
+
+/// All layers enabled, typing keys that fall through every layer.
+static void
+workload_all_layers (void) {
+    for (uint8_t layer = 2; layer <= LAYER_COUNT; ++layer) {
+        enable_layer(layer);
+    }
+    for (int i = 0; i < BENCH_EVENTS / 2; ++i) {
+        bench_tap(typing_keys[i % TYPING_KEY_COUNT], 30, 30);
+    }
+}
+
+// MARK: - Calibration
+
+/// A table for the calibration loop's dependent loads.
+static uint8_t calibration_table[256];
+
+/// The result of the calibration loop, so that it can't be optimized away.
+static volatile uint32_t calibration_sink;
+
+/// A fixed amount of work that doesn't touch the key processing: table
+/// lookups and arithmetic in a dependency chain, "events" of about the same
+/// size as a simple key event. This is the reference for the relative time.
+static void
+calibration_loop (void) {
+    uint32_t x = 0x12345678U;
+    for (int i = 0; i < BENCH_EVENTS; ++i) {
+        for (int j = 0; j < 64; ++j) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            x += calibration_table[(x ^ (uint32_t) j) & 0xFFU];
+        }
+        ++bench_events;
+    }
+    calibration_sink = x;
+}
+
+/// The workloads.
+static const struct {
+    const char *name;
+    void (*run)(void);
+} workloads[] = {
+    { "typing", workload_typing },
+    { "rollover", workload_rollover },
+    { "layers", workload_layers },
+    { "mod_tap", workload_mod_tap },
+    { "combo", workload_combo },
+    { "tap_dance", workload_tap_dance },
+    { "all_layers", workload_all_layers },
+};
+#define WORKLOAD_COUNT ((int) (sizeof(workloads) / sizeof(*workloads)))
+
+// MARK: - Baseline
+
+static bool
+find_baseline (FILE *file, const char *name, double *relative, double *reports) {
+    char line[256];
+    rewind(file);
+    while (fgets(line, sizeof(line), file)) {
+        char line_name[64];
+        double ns;
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%63s %lf %lf %lf", line_name, &ns, relative, reports) == 4
+            && strcmp(line_name, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int
+compare_doubles (const void *a, const void *b) {
+    const double x = *(const double *) a;
+    const double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+int
+main (int argc, char **argv) {
+    const char *baseline_path = NULL;
+    double threshold = 25.0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else {
+            (void) fprintf(stderr, "Usage: %s [--check baseline.txt] [--threshold percent]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    FILE *baseline = NULL;
+    if (baseline_path && !(baseline = fopen(baseline_path, "r"))) {
+        perror(baseline_path);
+        return 2;
+    }
+
+    for (int i = 0; i < (int) sizeof(calibration_table); ++i) {
+        calibration_table[i] = (uint8_t) (i * 167 + 13);
+    }
+
+    // The rounds of the workloads are interleaved, and each run of a workload
+    // is compared to a run of the calibration loop right before it, so that
+    // any slowdown of the machine during the run affects both alike
+    double best_ns[WORKLOAD_COUNT];
+    double reports_per_event[WORKLOAD_COUNT];
+    static double relative_times[WORKLOAD_COUNT][BENCH_ROUNDS];
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        for (int w = 0; w < WORKLOAD_COUNT; ++w) {
+            bench_events = 0;
+            const uint64_t calibration_start = now_ns();
+            calibration_loop();
+            const double calibration_ns = (double) (now_ns() - calibration_start) / bench_events;
+
+            reset();
+            bench_events = 0;
+            bench_reports = 0;
+            const uint64_t start = now_ns();
+            workloads[w].run();
+            const uint64_t elapsed = now_ns() - start;
+            const double ns = (double) elapsed / bench_events;
+            if (round == 0 || ns < best_ns[w]) {
+                best_ns[w] = ns;
+            }
+            relative_times[w][round] = ns / calibration_ns;
+            reports_per_event[w] = (double) bench_reports / bench_events;
+        }
+    }
+
+    int failures = 0;
+    for (int w = 0; w < WORKLOAD_COUNT; ++w) {
+        char name[64];
+        (void) snprintf(name, sizeof(name), "%s@%d", workloads[w].name, (int) LAYER_COUNT);
+        qsort(relative_times[w], BENCH_ROUNDS, sizeof(double), compare_doubles);
+        const double relative = relative_times[w][BENCH_ROUNDS / 2];
+        (void) printf("%-16s %8.1f %8.3f %8.4f", name, best_ns[w], relative, reports_per_event[w]);
+
+        double baseline_relative, baseline_reports;
+        if (baseline && find_baseline(baseline, name, &baseline_relative, &baseline_reports)) {
+            const double change = ((relative - baseline_relative) * 100.0) / baseline_relative;
+            const bool is_slower = change > threshold;
+            const bool reports_changed = (reports_per_event[w] - baseline_reports) > 0.00005
+                || (baseline_reports - reports_per_event[w]) > 0.00005;
+            (void) printf("  %+6.1f %%%s%s", change, is_slower ? "  SLOWER" : "",
+                reports_changed ? "  REPORTS CHANGED" : "");
+            failures += is_slower || reports_changed;
+        } else if (baseline) {
+            (void) printf("  (no baseline)");
+        }
+        (void) putchar('\n');
+    }
+    if (baseline) {
+        (void) fclose(baseline);
+        if (failures) {
+            (void) printf("\n%d workload(s) regressed beyond %.0f %% of baseline\n", failures, threshold);
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+// Replay a key trace (see key_trace.h) through keys.c on the host.
+//
+// Usage: replay_trace.bin [--verbose] trace.txt
+//
+// The trace is text with one 8-byte event per line as hexadecimal bytes
+// (e.g., as dumped from the Vial `id_key_trace` value or the ps2usb generic
+// HID `KEY_TRACE_READ` request). Empty lines and `#` comments are ignored.
+// Physical key events are fed through `process_key` with the recorded timing,
+// and each recorded report state is compared against the simulated state.
+//
+// The replay uses the keymap and layers of the unit tests (plus whatever the
+// test EEPROM contains), so it is meaningful for traces recorded with the
+// same key mapping.
+
+#define KEYS_TEST_NO_MAIN 1
+#include "test_keys.c"
+
+static bool
+parse_event (const char *line, uint8_t event[static KEY_TRACE_EVENT_SIZE]) {
+    int count = 0;
+    while (*line && *line != '#' && count < KEY_TRACE_EVENT_SIZE) {
+        char *end;
+        const unsigned long value = strtoul(line, &end, 16);
+        if (end == line) {
+            ++line;
+            continue;
+        }
+        event[count++] = (uint8_t) value;
+        line = end;
+    }
+    return count == KEY_TRACE_EVENT_SIZE;
+}
+
+static void
+resolve_matrix_position (uint8_t key, uint8_t *row, uint8_t *col) {
+    for (uint8_t r = 0; r < MATRIX_ROWS; ++r) {
+        for (uint8_t c = 0; c < MATRIX_COLS; ++c) {
+            if (pgm_read_byte(&keymaps[0][r][c]) == key) {
+                *row = r;
+                *col = c;
+                return;
+            }
+        }
+    }
+    *row = 0;
+    *col = key;
+}
+
+static bool
+report_matches (const uint8_t event[static KEY_TRACE_EVENT_SIZE]) {
+    const uint8_t expected_count = event[2] >> KEY_TRACE_REPORT_COUNT_SHIFT;
+    uint8_t keys[sizeof(usb_keys_buffer)];
+    uint8_t count = 0;
+
+    // The mock buffer may have holes, the recorded report does not
+    for (unsigned i = 0; i < sizeof(usb_keys_buffer); ++i) {
+        if (usb_keys_buffer[i]) {
+            keys[count++] = usb_keys_buffer[i];
+        }
+    }
+    if (event[3] != usb_keys_modifier_flags || count != expected_count) {
+        return false;
+    }
+    for (unsigned i = 0; i < KEY_TRACE_REPORT_KEYS && i < count; ++i) {
+        bool found = false;
+        for (unsigned j = 0; j < count; ++j) {
+            found = found || keys[j] == event[4 + i];
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int
+main (int argc, char **argv) {
+    const char *path = NULL;
+    bool is_verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            is_verbose = true;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        (void) fprintf(stderr, "Usage: %s [--verbose] trace.txt\n", argv[0]);
+        return 2;
+    }
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return 2;
+    }
+
+    reset();
+    verbose = is_verbose;
+
+    char line[256];
+    int line_number = 0;
+    int events = 0, reports = 0, mismatches = 0;
+    bool have_time = false;
+    uint16_t last_time = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        uint8_t event[KEY_TRACE_EVENT_SIZE];
+        ++line_number;
+        if (!parse_event(line, event)) {
+            continue;
+        }
+        const uint8_t type = event[2] & KEY_TRACE_TYPE_MASK;
+        const uint16_t time = event[0] | (event[1] << 8);
+
+        if (type == KEY_TRACE_TYPE_OVERFLOW) {
+            (void) printf("%d: trace overflowed, initial state may differ\n", line_number);
+            continue;
+        }
+        if (have_time) {
+            advance_time((uint16_t) (time - last_time));
+        }
+        have_time = true;
+        last_time = time;
+        ++events;
+
+        if (type == KEY_TRACE_TYPE_PRESS || type == KEY_TRACE_TYPE_RELEASE) {
+            uint8_t row = event[4], col = event[5];
+            if (row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+                resolve_matrix_position(event[3], &row, &col);
+            }
+            if (verbose) {
+                (void) printf("%5u: %s 0x%02X (%u, %u)\n", time,
+                    type == KEY_TRACE_TYPE_PRESS ? "press  " : "release",
+                    event[3], row, col);
+            }
+            process_key(event[3], type == KEY_TRACE_TYPE_RELEASE, row, col);
+        } else if (type == KEY_TRACE_TYPE_REPORT) {
+            ++reports;
+            if (!report_matches(event)) {
+                ++mismatches;
+                (void) printf("%d: report mismatch at %u ms: recorded mods 0x%02X keys %u [%02X %02X %02X %02X], "
+                    "replayed mods 0x%02X keys [%02X %02X %02X %02X %02X %02X]\n",
+                    line_number, time, event[3], event[2] >> KEY_TRACE_REPORT_COUNT_SHIFT,
+                    event[4], event[5], event[6], event[7], usb_keys_modifier_flags,
+                    usb_keys_buffer[0], usb_keys_buffer[1], usb_keys_buffer[2],
+                    usb_keys_buffer[3], usb_keys_buffer[4], usb_keys_buffer[5]);
+            } else if (verbose) {
+                (void) printf("%5u: report mods 0x%02X OK\n", time, event[3]);
+            }
+        } else {
+            (void) printf("%d: unknown event type 0x%02X\n", line_number, type);
+        }
+    }
+    if (file != stdin) {
+        (void) fclose(file);
+    }
+
+    (void) printf("\n%d events replayed, %d of %d reports matched\n",
+        events, reports - mismatches, reports);
+    return mismatches ? 1 : 0;
+}
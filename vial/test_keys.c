@@ -43,6 +43,10 @@ static char kbd_print_buffer[32];
 #define ENABLE_TRI_LAYER   1
 #define ENABLE_AUTOSHIFT   1
 
+#ifndef KEY_TRACE_SIZE
+#define KEY_TRACE_SIZE 16
+#endif
+
 #undef APPLE_FN_IS_MODIFIER
 #define APPLE_FN_IS_MODIFIER 0
 
@@ -433,6 +437,7 @@ usb_keyboard_send_if_needed (void) {
 // Include the real keys.c — gives us oneshot_apply, restore_oneshot_layer,
 // and all layer management functions
 #include "../keys.c"
+#include "../key_trace.c"
 
 static uint8_t last_tick = 0;
 
@@ -560,6 +565,7 @@ static void
 reset (void) {
     // Reset EEPROM to formatted state and run real init
     check_eeprom_sentinels();
+    key_trace_clear();
     eeprom_mock_init();
     eeconfig_init();
     eeconfig_init_via();
@@ -7061,4 +7067,77 @@ static void test_space_cadet_rspc_hold (void) {
     CHECK_KEYBUFFER_EMPTY();
 }
 
+// === Key trace ring buffer ===
+
+// These only apply when the trace is enabled (the benchmark is built without).
+
+static void
+test_key_trace_records_input (void) {
+#if KEY_TRACE_SIZE > 0
+    uint8_t event[KEY_TRACE_EVENT_SIZE];
+    process_physical_key(KEY(A), false);
+    process_physical_key(KEY(A), true);
+    CHECK_EQ(key_trace_count(), 2, "key trace: press and release recorded");
+
+    CHECK(key_trace_read_next(event), "key trace: first event");
+    CHECK_EQ(event[2] & KEY_TRACE_TYPE_MASK, KEY_TRACE_TYPE_PRESS, "key trace: press type");
+    CHECK_EQ(event[3], KEY(A), "key trace: press key");
+    CHECK_EQ(event[4], 2, "key trace: press row");
+    CHECK_EQ(event[5], 0, "key trace: press col");
+
+    CHECK(key_trace_read_next(event), "key trace: second event");
+    CHECK_EQ(event[2] & KEY_TRACE_TYPE_MASK, KEY_TRACE_TYPE_RELEASE, "key trace: release type");
+    CHECK_EQ(event[3], KEY(A), "key trace: release key");
+    CHECK(!key_trace_read_next(event), "key trace: end of trace");
+#endif
+}
+
+static void
+test_key_trace_report_state (void) {
+#if KEY_TRACE_SIZE > 0
+    uint8_t event[KEY_TRACE_EVENT_SIZE];
+    const uint8_t keys[] = { KEY(A), KEY(B), KEY(C), KEY(D), KEY(E), 0 };
+    key_trace_report(SHIFT_BIT, keys);
+
+    CHECK(key_trace_read_next(event), "key trace report: recorded");
+    CHECK_EQ(event[2] & KEY_TRACE_TYPE_MASK, KEY_TRACE_TYPE_REPORT, "key trace report: type");
+    CHECK_EQ(event[2] >> KEY_TRACE_REPORT_COUNT_SHIFT, 5, "key trace report: key count");
+    CHECK_EQ(event[3], SHIFT_BIT, "key trace report: mods");
+    CHECK_EQ(event[4], KEY(A), "key trace report: first key");
+    CHECK_EQ(event[7], KEY(D), "key trace report: last stored key");
+#endif
+}
+
+static void
+test_key_trace_overflow (void) {
+#if KEY_TRACE_SIZE > 0
+    uint8_t event[KEY_TRACE_EVENT_SIZE];
+    for (int i = 0; i < KEY_TRACE_SIZE + 3; ++i) {
+        key_trace_input(i, false, 0, i);
+    }
+    CHECK_EQ(key_trace_count(), KEY_TRACE_SIZE, "key trace overflow: count saturates");
+
+    CHECK(key_trace_read_next(event), "key trace overflow: marker");
+    CHECK_EQ(event[2], KEY_TRACE_TYPE_OVERFLOW, "key trace overflow: marker type");
+
+    // Recording is paused while reading
+    key_trace_input(0xEE, false, 0, 0);
+
+    int n = 0;
+    bool in_order = true;
+    while (key_trace_read_next(event)) {
+        in_order = in_order && (event[3] == n + 3);
+        ++n;
+    }
+    CHECK_EQ(n, KEY_TRACE_SIZE, "key trace overflow: all events read");
+    CHECK(in_order, "key trace overflow: oldest first, oldest discarded");
+
+    key_trace_clear();
+    CHECK_EQ(key_trace_count(), 0, "key trace overflow: cleared");
+    CHECK(!key_trace_read_next(event), "key trace overflow: no marker after clear");
+#endif
+}
+
+#ifndef KEYS_TEST_NO_MAIN
 #include "keys_runner.c"
+#endif
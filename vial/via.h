@@ -34,4 +34,8 @@ enum via_keyboard_value_id {
     id_uptime = 0x01,
     id_layout_options = 0x02,
     id_switch_matrix_state = 0x03,
+    // AAKBD extensions:
+    id_key_trace = 0xA0,
+    id_debounce_tuning = 0xA1,
+    id_scan_rate = 0xA2,
 };
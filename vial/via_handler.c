@@ -38,6 +38,11 @@
 #endif
 
 #include "timer.h"
+#include "key_trace.h"
+#include "scan_rate.h"
+#if DEBOUNCE_TUNING
+#include "debounce/debounce_tuning.h"
+#endif
 
 // Max data payload in a single HID response (32-byte report minus headers)
 #define VIA_MAX_PAYLOAD 28
@@ -124,11 +129,63 @@ handle_generic_hid_report (uint8_t report_id, uint8_t count, uint8_t report[stat
                     }
 #endif
                     break;
+#if KEY_TRACE_SIZE > 0
+                case id_key_trace: {
+                    // command_data[1] non-zero = rewind to the oldest event
+                    // first. Reply: [1] = number of events in this reply,
+                    // [2] = events in the trace, [3...] = the events.
+                    if (command_data[1]) {
+                        key_trace_rewind();
+                    }
+                    uint8_t n = 0;
+                    uint8_t *event = &command_data[3];
+                    while (n < VIA_MAX_PAYLOAD / KEY_TRACE_EVENT_SIZE && key_trace_read_next(event)) {
+                        event += KEY_TRACE_EVENT_SIZE;
+                        ++n;
+                    }
+                    command_data[1] = n;
+                    command_data[2] = key_trace_count();
+                    break;
+                }
+#endif
+                case id_scan_rate:
+                    // Reply: [1...] = the scan rate statistics
+                    (void) scan_rate_read_stats(&command_data[1]);
+                    break;
+#if DEBOUNCE_TUNING
+                case id_debounce_tuning: {
+                    // command_data[1] = offset in the per-key time table.
+                    // Reply: [1] = mode, [2] = DEBOUNCE, [3] = table size,
+                    // [4] = bytes in this reply, [5...] = the table bytes.
+                    const uint8_t table_offset = command_data[1];
+                    command_data[1] = debounce_tuning_mode();
+                    command_data[2] = DEBOUNCE;
+                    command_data[3] = DEBOUNCE_TUNING_TABLE_SIZE;
+                    command_data[4] = debounce_tuning_read_table(
+                        table_offset, VIA_MAX_PAYLOAD - 5, &command_data[5]);
+                    break;
+                }
+#endif
             }
             break;
 
         case id_set_keyboard_value:
             switch (command_data[0]) {
+#if KEY_TRACE_SIZE > 0
+                case id_key_trace:
+                    key_trace_clear();
+                    break;
+#endif
+#if DEBOUNCE_TUNING
+                case id_debounce_tuning:
+                    // [1] = mode, [2] = row (0xFF = none), [3] = col, [4] = ms
+                    debounce_tuning_set_mode(command_data[1]);
+                    if (command_data[2] < MATRIX_ROWS && command_data[3] < MATRIX_COLS) {
+                        debounce_tuning_set_key_time(
+                            (command_data[2] * MATRIX_COLS) + command_data[3], command_data[4]);
+                    }
+                    break;
+#endif
                 case id_layout_options: {
                     uint16_t old_opts = dynamic_keymap_get_layout_options();
                     uint32_t value = ((uint32_t) command_data[1] << 24)
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Captures the raw capsense signal stream of an xwhatsit keyboard built with
+`CAPSENSE_SIGNAL_STREAM = 1`, for offline analysis of interference and
+threshold margins.
+
+Each frame has, for every column, the physical rows that read as active at
+the sample time, and the rows that were active before the column was strobed
+(interference). The frames are written as CSV, one line per column:
+
+    frame,timestamp_ms,threshold,time,col,rows,interference
+
+The keyboard is disabled while capturing (so that the scan does not change
+the DAC threshold between frames), and re-enabled afterwards. With several
+thresholds, e.g., `--threshold 100:200:5`, the same number of frames is
+captured at each threshold in turn.
+
+Requires the `hid` module (`pip3 install hidapi`).
+
+Usage: python3 capture_signal.py [--frames=N] [--threshold=T|FROM:TO:STEP]
+           [--time=T] [--output=file.csv]
+"""
+
+import argparse
+import sys
+
+import hid
+
+USAGE_PAGE = 0xFF60
+USAGE = 0x61
+REPORT_SIZE = 32
+
+MAGIC = bytes([0x55, 0xAA])
+DISABLE_KEYBOARD = 0x13
+ENABLE_KEYBOARD = 0x14
+SET_SIGNAL_STREAM = 0x31
+RESPONSE_OK = 0x22
+RESPONSE_SIGNAL = 0x25
+
+
+def open_keyboard():
+    """Open the first device with the util usage page."""
+    for info in hid.enumerate():
+        if info['usage_page'] == USAGE_PAGE and info['usage'] == USAGE:
+            device = hid.device()
+            device.open_path(info['path'])
+            return device
+    sys.exit('No xwhatsit keyboard found')
+
+
+def command(device, *data):
+    """Send a command and return the reply, skipping stream reports."""
+    device.write(bytes([0]) + MAGIC + bytes(data))
+    while True:
+        report = bytes(device.read(REPORT_SIZE, 1000))
+        if not report:
+            sys.exit('No reply to command 0x%02X' % data[0])
+        if report[:2] == MAGIC and report[2] != RESPONSE_SIGNAL:
+            if report[2] != RESPONSE_OK:
+                sys.exit('Command 0x%02X failed (%s)' % (data[0], 'not supported' if data[0] == SET_SIGNAL_STREAM else 'error'))
+            return report
+
+
+def capture(device, threshold, time, frame_count, output):
+    """Capture `frame_count` complete frames at `threshold`."""
+    reply = command(device, SET_SIGNAL_STREAM, 1, threshold & 0xFF, threshold >> 8, time)
+    cols = reply[4]
+    frames = {}
+    complete = 0
+    first_sequence = None
+
+    while complete < frame_count:
+        report = bytes(device.read(REPORT_SIZE, 1000))
+        if not report:
+            sys.exit('The stream stopped')
+        if report[:2] != MAGIC or report[2] != RESPONSE_SIGNAL:
+            continue
+        sequence = report[3]
+        timestamp = report[4] | (report[5] << 8)
+        first_col, col_count = report[6], report[7]
+        if first_sequence is None:
+            if first_col != 0:
+                continue
+            first_sequence = sequence
+
+        frame = frames.setdefault(sequence, {'timestamp': timestamp, 'cols': {}})
+        for i in range(col_count):
+            frame['cols'][first_col + i] = (report[8 + (i * 2)], report[9 + (i * 2)])
+
+        if len(frame['cols']) == cols:
+            del frames[sequence]
+            complete += 1
+            for col in range(cols):
+                rows, interference = frame['cols'][col]
+                output.write('%d,%d,%d,%d,%d,%d,%d\n' % (sequence, frame['timestamp'], threshold, time, col, rows, interference))
+
+    command(device, SET_SIGNAL_STREAM, 0, 0, 0, 0)
+    return cols
+
+
+def thresholds(spec):
+    """Parse `T` or `FROM:TO:STEP` into a list of thresholds."""
+    if ':' in spec:
+        start, end, step = (int(value, 0) for value in spec.split(':'))
+        return list(range(start, end + 1, step))
+    return [int(spec, 0)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Capture the raw capsense signal stream.')
+    parser.add_argument('--frames', type=int, default=1000, help='frames per threshold')
+    parser.add_argument('--threshold', default='128', help='DAC threshold, or FROM:TO:STEP')
+    parser.add_argument('--time', type=int, default=0, help='sample time (0 = firmware default)')
+    parser.add_argument('--output', default='-', help='CSV output file (default stdout)')
+    args = parser.parse_args()
+
+    output = sys.stdout if args.output == '-' else open(args.output, 'w')
+    device = open_keyboard()
+    was_enabled = command(device, DISABLE_KEYBOARD)[3]
+    try:
+        output.write('frame,timestamp_ms,threshold,time,col,rows,interference\n')
+        for threshold in thresholds(args.threshold):
+            capture(device, threshold, args.time, args.frames, output)
+    finally:
+        if was_enabled:
+            command(device, ENABLE_KEYBOARD)
+        device.close()
+        if output is not sys.stdout:
+            output.close()
+
+
+if __name__ == '__main__':
+    main()
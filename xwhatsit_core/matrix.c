@@ -37,6 +37,7 @@
 #include <stdint.h>
 #include <avr/eeprom.h>
 #include <avr/power.h>
+#include "scan_plan.h"
 
 #ifndef QMK_KEYMAP
 // AAKBD firmware, QMK compatibility - https://github.com/arkku/aakbd
@@ -71,8 +72,13 @@ bool keyboard_scan_enabled = true;
 
 #if CAPSENSE_CAL_ENABLED
 #ifndef CAPSENSE_CAL_VERSION
+#if CAPSENSE_DRIFT_TRACKING
+// The saved data also has the level of each bin
+#define CAPSENSE_CAL_VERSION 0x86
+#else
 #define CAPSENSE_CAL_VERSION 6
 #endif
+#endif
 
 // If this this number, or fewer (but non-zero), keys appear to be suspiciously
 // close to the threshold values, try to move them to another bin.
@@ -83,8 +89,6 @@ bool keyboard_scan_enabled = true;
 _Static_assert(CAPSENSE_CAL_SAVE_HEADER_SIZE == sizeof(struct calibration_header), "calibration_header size mismatch");
 _Static_assert(MATRIX_ROW_T_SIZE == sizeof(matrix_row_t), "matrix_row_t size mismatch");
 
-#define ASSIGNED_KEYMAP_COLS_MASK_INDEX     (MATRIX_CAPSENSE_ROWS)
-
 matrix_row_t assigned_to_threshold[CAPSENSE_CAL_BINS][MATRIX_CAPSENSE_ROWS + 1] = { { 0 } };
 uint16_t cal_thresholds[CAPSENSE_CAL_BINS] = { 0 };
 uint8_t cal_bin_rows_mask[CAPSENSE_CAL_BINS] = { 0 };
@@ -98,9 +102,52 @@ uint8_t cal_flags = 0;
 #if CAPSENSE_CAL_DEBUG
 uint16_t cal_time = 0;
 #endif
+
+#if CAPSENSE_DRIFT_TRACKING
+#ifndef CAPSENSE_DRIFT_IDLE_MS
+/// The drift is measured only when no key has been down for this long.
+#define CAPSENSE_DRIFT_IDLE_MS 1000
+#endif
+
+#ifndef CAPSENSE_DRIFT_INTERVAL_MS
+/// The interval between drift measurement steps (each step is one DAC write
+/// and up to `CAPSENSE_DRIFT_REPS` scans of a single column).
+#define CAPSENSE_DRIFT_INTERVAL_MS 50
+#endif
+
+#ifndef CAPSENSE_DRIFT_REPS
+/// The number of samples per drift measurement step.
+#define CAPSENSE_DRIFT_REPS CAPSENSE_CAL_EACHKEY_REPS
+#endif
+
+#ifndef CAPSENSE_DRIFT_WINDOW
+/// The range searched around the previous level of a bin, i.e., the maximum
+/// change of drift in one measurement of the bin.
+#define CAPSENSE_DRIFT_WINDOW (CAPSENSE_CAL_THRESHOLD_OFFSET / 2)
+#endif
+
+#ifndef CAPSENSE_DRIFT_HYSTERESIS
+/// The threshold of a bin is changed only if its drift has changed by at
+/// least this much since the previous change.
+#define CAPSENSE_DRIFT_HYSTERESIS 2
+#endif
+
+#ifndef CAPSENSE_DRIFT_MAX
+/// The maximum drift from the calibrated level (beyond this the keyboard
+/// should be recalibrated).
+#define CAPSENSE_DRIFT_MAX CAPSENSE_CAL_THRESHOLD_OFFSET
+#endif
+
+uint16_t cal_bin_level[CAPSENSE_CAL_BINS] = { 0 };
+int16_t cal_bin_drift[CAPSENSE_CAL_BINS] = { 0 };
+#endif
 #endif // ^ CAPSENSE_CAL_ENABLED
 
-static matrix_row_t previous_matrix[MATRIX_ROWS] = { 0 };
+matrix_row_t scanned_matrix[MATRIX_ROWS] = { 0 };
+uint8_t scanned_matrix_sequence = 0;
+uint16_t scanned_matrix_changed_rows = 0;
+
+_Static_assert(MATRIX_ROWS <= 16, "scanned_matrix_changed_rows is too small");
 
 #if MATRIX_EXTRA_DIRECT_ROWS
 static pin_t extra_direct_pins[MATRIX_EXTRA_DIRECT_ROWS][MATRIX_COLS] = MATRIX_EXTRA_DIRECT_PINS;
@@ -345,6 +392,73 @@ uint16_t measure_middle_keymap_coords(uint8_t col, uint8_t row, uint8_t time, ui
     return measure_middle(CAPSENSE_KEYMAP_COL_TO_PHYSICAL_COL(col), CAPSENSE_KEYMAP_ROW_TO_PHYSICAL_ROW(row), time, samples);
 }
 
+/// Like `measure_middle` for all `rows_mask` physical rows of `col` at once:
+/// each step of the binary search is for the lowest row not yet done, but
+/// the same samples also narrow the range of every other row whose range
+/// contains that threshold. The result of each row is stored in `result`
+/// at the index of the physical row.
+static void measure_middle_column(uint8_t col, uint8_t rows_mask, uint8_t time, uint8_t samples, uint16_t result[static 8]) {
+    const uint8_t samples_div2 = samples / 2;
+    uint16_t row_min[8], row_max[8];
+
+    for (int_fast8_t row = 0; row < 8; ++row) {
+        row_min[row] = 0;
+        row_max[row] = CAPSENSE_DAC_MAX;
+    }
+
+    while (rows_mask) {
+        int_fast8_t search_row = 0;
+        while (!(rows_mask & (1 << search_row))) {
+            ++search_row;
+        }
+        const uint16_t mid = (row_min[search_row] + row_max[search_row]) / 2;
+        dac_write_threshold(mid);
+
+        uint8_t sum[8] = { 0 };
+        for (int_fast8_t i = samples; i; --i) {
+            const uint8_t rows = scan_physical_column(col, time, NULL) & rows_mask;
+            for (int_fast8_t row = search_row; row < 8; ++row) {
+                if (rows & (1 << row)) {
+                    ++sum[row];
+                }
+            }
+        }
+
+        for (int_fast8_t row = search_row; row < 8; ++row) {
+            const uint8_t row_mask = (1 << row);
+            if (!(rows_mask & row_mask) || mid < row_min[row] || mid > row_max[row]) {
+                continue;
+            }
+            if (sum[row] < samples_div2) {
+                row_max[row] = mid ? mid - 1 : 0;
+            } else if (sum[row] > samples_div2) {
+                row_min[row] = mid + 1;
+            } else {
+                row_min[row] = mid;
+                row_max[row] = mid;
+            }
+            if (row_min[row] >= row_max[row]) {
+                result[row] = row_min[row];
+                rows_mask &= ~row_mask;
+            }
+        }
+    }
+}
+
+void measure_middle_keymap_column(uint8_t col, uint8_t time, uint8_t samples, uint16_t result[static MATRIX_CAPSENSE_ROWS]) {
+    uint8_t rows_mask = 0;
+    for (int_fast8_t row = 0; row < MATRIX_CAPSENSE_ROWS; ++row) {
+        rows_mask |= 1 << CAPSENSE_KEYMAP_ROW_TO_PHYSICAL_ROW(row);
+    }
+
+    uint16_t physical_result[8];
+    measure_middle_column(CAPSENSE_KEYMAP_COL_TO_PHYSICAL_COL(col), rows_mask, time, samples, physical_result);
+
+    for (int_fast8_t row = 0; row < MATRIX_CAPSENSE_ROWS; ++row) {
+        result[row] = physical_result[CAPSENSE_KEYMAP_ROW_TO_PHYSICAL_ROW(row)];
+    }
+}
+
 #if CAPSENSE_CAL_ENABLED
 #define calibration_measure_all_zero(valid) calibration_measure_all(CAPSENSE_HARDCODED_SAMPLE_TIME, CAPSENSE_CAL_INIT_REPS, true, (valid))
 #define calibration_measure_all_one(valid) calibration_measure_all(CAPSENSE_HARDCODED_SAMPLE_TIME, CAPSENSE_CAL_INIT_REPS, false, (valid))
@@ -410,6 +524,224 @@ static uint16_t calibration_measure_all(uint8_t time, int_fast8_t samples, bool
     return looking_for_all_zero ? max : min;
 }
 
+#if CAPSENSE_DRIFT_TRACKING
+// MARK: - Drift tracking
+
+// The level of a key is the threshold at which it stops reading as pressed,
+// and the level of a bin is the level of its furthest key in that direction.
+// This is the same as the per-key result of calibration, but the search is
+// done one column and one step at a time, in a narrow range.
+#ifdef CAPSENSE_CONDUCTIVE_PLASTIC_IS_PUSHED_DOWN_ON_KEYPRESS
+#define drift_level_is_beyond(level, other) ((level) > (other))
+#else
+#define drift_level_is_beyond(level, other) ((level) < (other))
+#endif
+
+static struct drift_state {
+    uint16_t center;    // The middle of the search range of the bin
+    uint16_t min;       // The remaining search range in the column
+    uint16_t max;
+    uint16_t level;     // The level of the bin so far
+    int8_t bin;         // The bin being measured, or -1 if none
+    uint8_t col;        // The keymap column being measured
+    uint8_t rows;       // The physical rows of the bin's keys in the column
+    bool saw_zero;      // Did any step in this column read all zero?
+    bool has_level;     // Is `level` valid?
+} drift = { .bin = -1 };
+
+/// Start the search in the next column from `first_col` that has keys in the
+/// bin being measured. Returns `false` if there are no more columns.
+static bool drift_next_column(const uint8_t first_col, const uint16_t window) {
+    const matrix_row_t *assigned = assigned_to_threshold[drift.bin];
+    for (uint8_t col = first_col; col < MATRIX_COLS; ++col) {
+        const matrix_row_t col_mask = ((matrix_row_t) 1) << col;
+        if (!(assigned[ASSIGNED_KEYMAP_COLS_MASK_INDEX] & col_mask)) {
+            continue;
+        }
+        uint8_t rows = 0;
+        for (int_fast8_t row = 0; row < MATRIX_CAPSENSE_ROWS; ++row) {
+            if (assigned[row] & col_mask) {
+                rows |= 1 << CAPSENSE_KEYMAP_ROW_TO_PHYSICAL_ROW(row);
+            }
+        }
+        if (!rows) {
+            continue;
+        }
+        drift.col = col;
+        drift.rows = rows;
+        drift.min = (drift.center > window) ? drift.center - window : 0;
+        drift.max = (drift.center + window < CAPSENSE_DAC_MAX) ? drift.center + window : CAPSENSE_DAC_MAX;
+        drift.saw_zero = false;
+        return true;
+    }
+    return false;
+}
+
+/// Start measuring `bin` around the level `center`. Returns `false` if the
+/// bin has no keys.
+static bool drift_begin_bin(const int_fast8_t bin, const uint16_t center, const uint16_t window) {
+    if (cal_bin_rows_mask[bin] == 0) {
+        return false;
+    }
+    drift.bin = bin;
+    drift.center = center;
+    drift.has_level = false;
+    if (!drift_next_column(0, window)) {
+        drift.bin = -1;
+        return false;
+    }
+    return true;
+}
+
+/// Perform one binary search step of the bin being measured. Returns `true`
+/// when the bin is done, in which case `drift.has_level` tells whether
+/// `drift.level` is valid.
+static bool drift_step(const uint16_t window) {
+#ifdef CAPSENSE_CONDUCTIVE_PLASTIC_IS_PUSHED_DOWN_ON_KEYPRESS
+    const uint16_t mid = (drift.min + drift.max) / 2;
+#else
+    const uint16_t mid = (drift.min + drift.max + 1) / 2;
+#endif
+    dac_write_threshold(mid);
+
+    const uint8_t physical_col = CAPSENSE_KEYMAP_COL_TO_PHYSICAL_COL(drift.col);
+    bool is_zero = true;
+    for (int_fast8_t samples = CAPSENSE_DRIFT_REPS; samples; --samples) {
+        if (scan_physical_col(physical_col, NULL) & drift.rows) {
+            is_zero = false;
+            break;
+        }
+    }
+
+#ifdef CAPSENSE_CONDUCTIVE_PLASTIC_IS_PUSHED_DOWN_ON_KEYPRESS
+    if (is_zero) {
+        drift.max = mid;
+        drift.saw_zero = true;
+    } else {
+        drift.min = mid + 1;
+    }
+#else
+    if (is_zero) {
+        drift.min = mid;
+        drift.saw_zero = true;
+    } else {
+        drift.max = mid - 1;
+    }
+#endif
+
+    if (drift.min < drift.max) {
+        return false;
+    }
+
+    if (!drift.saw_zero) {
+        // Never read zero in the range: a key is probably held down, or the
+        // drift is too fast to track, either way this result is not usable
+        drift.has_level = false;
+        return true;
+    }
+
+    if (!drift.has_level || drift_level_is_beyond(drift.min, drift.level)) {
+        drift.level = drift.min;
+    }
+    drift.has_level = true;
+
+    return !drift_next_column(drift.col + 1, window);
+}
+
+/// Measure the level of each bin right after calibration, blocking. The
+/// drift is measured relative to this.
+static void drift_measure_calibrated_levels(void) {
+    for (int_fast8_t bin = 0; bin < CAPSENSE_CAL_BINS; ++bin) {
+        // The threshold is offset from the level, and for merged bins it is
+        // between the levels of the merged bins
+#ifdef CAPSENSE_CONDUCTIVE_PLASTIC_IS_PUSHED_DOWN_ON_KEYPRESS
+        uint16_t level = (cal_thresholds[bin] > cal_threshold_offset) ? cal_thresholds[bin] - cal_threshold_offset : 0;
+#else
+        uint16_t level = cal_thresholds[bin] + cal_threshold_offset;
+#endif
+        cal_bin_drift[bin] = 0;
+        if (drift_begin_bin(bin, level, cal_threshold_offset)) {
+            while (!drift_step(cal_threshold_offset)) {
+                continue;
+            }
+            if (drift.has_level) {
+                level = drift.level;
+            }
+        }
+        cal_bin_level[bin] = level;
+    }
+    drift.bin = -1;
+}
+
+/// Called after each scan to measure the drift of the bins one step at a
+/// time, when no keys are down. When all columns of a bin have been measured
+/// and its drift has changed enough, the scan plan is rebuilt with the new
+/// threshold.
+static void drift_task(const matrix_row_t current_matrix[]) {
+    static uint16_t idle_since = 0;
+    static uint16_t last_step_time = 0;
+    static int_fast8_t next_bin = 0;
+
+    bool keys_down = false;
+    for (int_fast8_t row = 0; row < MATRIX_CAPSENSE_ROWS; ++row) {
+        if (current_matrix[row]) {
+            keys_down = true;
+        }
+    }
+
+    if (keys_down || scan_plan_group_count == 0) {
+        // Start over, since the key may have affected the measurement
+        idle_since = timer_read();
+        drift.bin = -1;
+        return;
+    }
+    if (timer_elapsed(idle_since) < CAPSENSE_DRIFT_IDLE_MS || timer_elapsed(last_step_time) < CAPSENSE_DRIFT_INTERVAL_MS) {
+        return;
+    }
+    last_step_time = timer_read();
+
+    if (drift.bin < 0) {
+        // Find the next bin to measure
+        for (int_fast8_t i = CAPSENSE_CAL_BINS; i; --i) {
+            const int_fast8_t bin = next_bin;
+            next_bin = (bin + 1 < CAPSENSE_CAL_BINS) ? bin + 1 : 0;
+            const int16_t level = (int16_t) cal_bin_level[bin] + cal_bin_drift[bin];
+            if (drift_begin_bin(bin, (level > 0) ? (uint16_t) level : 0, CAPSENSE_DRIFT_WINDOW)) {
+                break;
+            }
+        }
+        if (drift.bin < 0) {
+            return;
+        }
+    }
+
+    if (!drift_step(CAPSENSE_DRIFT_WINDOW)) {
+        return;
+    }
+
+    // The bin is done
+    const int_fast8_t bin = drift.bin;
+    drift.bin = -1;
+    if (!drift.has_level) {
+        return;
+    }
+
+    int16_t new_drift = (int16_t) drift.level - (int16_t) cal_bin_level[bin];
+    if (new_drift > CAPSENSE_DRIFT_MAX) {
+        new_drift = CAPSENSE_DRIFT_MAX;
+    } else if (new_drift < -CAPSENSE_DRIFT_MAX) {
+        new_drift = -CAPSENSE_DRIFT_MAX;
+    }
+
+    if (ABSDELTA(new_drift, cal_bin_drift[bin]) >= CAPSENSE_DRIFT_HYSTERESIS) {
+        // Scanning is not in progress, so the new plan takes effect entirely
+        // on the next scan
+        cal_bin_drift[bin] = new_drift;
+        scan_plan_build();
+    }
+}
+#endif // ^ CAPSENSE_DRIFT_TRACKING
+
 void calibrate_matrix(void) {
     cal_threshold_offset = CAPSENSE_CAL_THRESHOLD_OFFSET;
     uint16_t cal_thresholds_max[CAPSENSE_CAL_BINS];
@@ -856,6 +1188,11 @@ void calibrate_matrix(void) {
     }
 #endif
 
+#if CAPSENSE_DRIFT_TRACKING
+    drift_measure_calibrated_levels();
+#endif
+
+    scan_plan_build();
     cal_flags |= CAPSENSE_CAL_FLAG_CALIBRATED;
 }
 #endif
@@ -868,6 +1205,9 @@ static bool load_matrix_calibration(void) {
     _Static_assert(CAPSENSE_CAL_SAVE_TOTAL_SIZE == sizeof(struct calibration_header) * 2
         + sizeof(cal_thresholds) + sizeof(cal_bin_rows_mask)
         + sizeof(assigned_to_threshold) + sizeof(cal_bin_key_count)
+#if CAPSENSE_DRIFT_TRACKING
+        + sizeof(cal_bin_level)
+#endif
         + sizeof(cal_threshold_max) + sizeof(cal_threshold_min)
         + sizeof(cal_threshold_offset),
         "CAPSENSE_CAL_SAVE_TOTAL_SIZE does not match actual data layout");
@@ -887,6 +1227,10 @@ static bool load_matrix_calibration(void) {
     p += sizeof(assigned_to_threshold);
     eeprom_read_block(cal_bin_key_count, p, sizeof(cal_bin_key_count));
     p += sizeof(cal_bin_key_count);
+#if CAPSENSE_DRIFT_TRACKING
+    eeprom_read_block(cal_bin_level, p, sizeof(cal_bin_level));
+    p += sizeof(cal_bin_level);
+#endif
     cal_threshold_max = eeprom_read_word((const uint16_t *) p);
     p += sizeof(cal_threshold_max);
     cal_threshold_min = eeprom_read_word((const uint16_t *) p);
@@ -899,6 +1243,15 @@ static bool load_matrix_calibration(void) {
         return false;
     }
 
+#if CAPSENSE_DRIFT_TRACKING
+    // The drift since the save is measured in the background
+    for (int_fast8_t bin = 0; bin < CAPSENSE_CAL_BINS; ++bin) {
+        cal_bin_drift[bin] = 0;
+    }
+    drift.bin = -1;
+#endif
+
+    scan_plan_build();
     cal_flags |= CAPSENSE_CAL_FLAG_LOADED;
     return true;
 }
@@ -929,6 +1282,10 @@ void save_matrix_calibration(void) {
     p += sizeof(assigned_to_threshold);
     eeprom_update_block(cal_bin_key_count, p, sizeof(cal_bin_key_count));
     p += sizeof(cal_bin_key_count);
+#if CAPSENSE_DRIFT_TRACKING
+    eeprom_update_block(cal_bin_level, p, sizeof(cal_bin_level));
+    p += sizeof(cal_bin_level);
+#endif
     eeprom_update_word((uint16_t *) p, cal_threshold_max);
     p += sizeof(cal_threshold_max);
     eeprom_update_word((uint16_t *) p, cal_threshold_min);
@@ -959,30 +1316,19 @@ static uint16_t keymap_checksum(void) {
 
 #define MASK_TO_ROW_CASE(x) (1 << (x)): row = CAPSENSE_PHYSICAL_ROW_TO_KEYMAP_ROW((x)); break
 
-static inline void scan_bin(const int_fast8_t bin, matrix_row_t current_matrix[]) {
-    const uint8_t bin_physical_rows_mask = cal_bin_rows_mask[bin];
-    if (bin_physical_rows_mask == 0) {
-        // No keys in this bin, we can skip it
-        return;
-    }
-
-    // Set the threshold of this bin and then scan all keys in the bin
-    dac_write_threshold(cal_thresholds[bin]);
+static inline void scan_plan_group(const int_fast8_t group, matrix_row_t current_matrix[]) {
+    // Set the threshold of this group and then scan the columns that have
+    // keys in the group
+    dac_write_threshold(scan_plan_threshold[group]);
 
-    const matrix_row_t bin_columns_mask = assigned_to_threshold[bin][ASSIGNED_KEYMAP_COLS_MASK_INDEX];
-
-    matrix_row_t col_mask = 1;
-    for (int_fast8_t col = 0; col < MATRIX_COLS; ++col, col_mask <<= 1) {
-        const int_fast8_t physical_col = CAPSENSE_KEYMAP_COL_TO_PHYSICAL_COL(col);
-
-        uint8_t active_rows_in_col = 0, interference;
+    const uint8_t end = scan_plan_group_end[group];
+    for (uint8_t step = group ? scan_plan_group_end[group - 1] : 0; step < end; ++step) {
+        const uint8_t col = scan_plan_col[step];
+        uint8_t interference;
+        uint8_t active_rows_in_col = scan_physical_col(CAPSENSE_KEYMAP_COL_TO_PHYSICAL_COL(col), &interference);
 
-        if (bin_columns_mask & col_mask) {
-            // This column has keys assigned to this bin
-            active_rows_in_col = scan_physical_col(physical_col, &interference);
-            // Mask out rows that are not in this bin
-            active_rows_in_col &= bin_physical_rows_mask;
-        }
+        // Only the keys in this group, and not those with interference
+        active_rows_in_col &= scan_plan_rows[step] & ~interference;
 
         // Iterate over each row that's on in this column
         while (active_rows_in_col) {
@@ -991,14 +1337,7 @@ static inline void scan_bin(const int_fast8_t bin, matrix_row_t current_matrix[]
             // Turn it off (for loop condition)
             active_rows_in_col ^= physical_row_mask;
 
-            const int_fast8_t row = physical_bit_to_keymap_row(physical_row_mask);
-
-            if (assigned_to_threshold[bin][row] & col_mask) {
-                // The key is assigned to this bin
-                if (!(interference & physical_row_mask)) {
-                    current_matrix[row] |= col_mask;
-                }
-            }
+            current_matrix[physical_bit_to_keymap_row(physical_row_mask)] |= ((matrix_row_t) 1) << col;
         }
     }
 }
@@ -1018,16 +1357,22 @@ bool matrix_scan_custom(matrix_row_t current_matrix[]) {
 #if CAPSENSE_CAL_ENABLED
     static bool scan_ascending = true;
 
+    // Alternate the order so that the last threshold of the previous scan
+    // is the first of this one, and the DAC doesn't need to be rewritten
     if (scan_ascending) {
-        for (int_fast8_t bin = 0; bin < CAPSENSE_CAL_BINS; ++bin) {
-            scan_bin(bin, current_matrix);
+        for (int_fast8_t group = 0; group < scan_plan_group_count; ++group) {
+            scan_plan_group(group, current_matrix);
         }
     } else {
-        for (int_fast8_t bin = CAPSENSE_CAL_BINS; bin; ) {
-            scan_bin(--bin, current_matrix);
+        for (int_fast8_t group = scan_plan_group_count; group; ) {
+            scan_plan_group(--group, current_matrix);
         }
     }
     scan_ascending = !scan_ascending;
+
+#if CAPSENSE_DRIFT_TRACKING
+    drift_task(current_matrix);
+#endif
 #else // ^ CAPSENSE_CAL_ENABLED
     for (int_fast8_t col = 0; col < MATRIX_COLS; ++col) {
         int_fast8_t physical_col = CAPSENSE_KEYMAP_COL_TO_PHYSICAL_COL(col);
@@ -1059,10 +1404,14 @@ bool matrix_scan_custom(matrix_row_t current_matrix[]) {
 
 end_of_scan:
     for (int_fast8_t row = 0; row < MATRIX_ROWS; ++row) {
-        if (previous_matrix[row] != current_matrix[row]) {
+        if (scanned_matrix[row] != current_matrix[row]) {
             changed = true;
+            scanned_matrix_changed_rows |= ((uint16_t) 1) << row;
         }
-        previous_matrix[row] = current_matrix[row];
+        scanned_matrix[row] = current_matrix[row];
+    }
+    if (changed) {
+        ++scanned_matrix_sequence;
     }
     return changed;
 }
@@ -1130,6 +1479,7 @@ static void clear_matrix(void) {
     bool was_enabled = keyboard_scan_enabled;
     keyboard_scan_enabled = false;
     (void) matrix_scan(); // This clears the matrix when scan is disabled
+    matrix_set_all_rows_changed();
     keyboard_scan_enabled = was_enabled;
 }
 #endif
@@ -1184,6 +1534,12 @@ void matrix_init_kb(void) {
                 clear_saved_matrix_calibration();
             }
         }
+#if CAPSENSE_DRIFT_TRACKING
+        else {
+            // Use the saved calibration, since the drift is tracked
+            cal_flags |= CAPSENSE_CAL_FLAG_SKIPPED;
+        }
+#endif
     }
 
     if (calibration_skipped) {
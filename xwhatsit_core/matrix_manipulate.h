@@ -30,7 +30,16 @@
 extern bool keyboard_scan_enabled;
 
 bool matrix_scan_custom(matrix_row_t current_matrix[]);
+
+// The result of the latest `matrix_scan_custom`, the number of scans in which
+// it has changed (wrapping), and the mask of rows that have changed (cleared
+// by the user of the mask, i.e., the util stream).
+extern matrix_row_t scanned_matrix[MATRIX_ROWS];
+extern uint8_t scanned_matrix_sequence;
+extern uint16_t scanned_matrix_changed_rows;
+
 uint16_t measure_middle_keymap_coords(uint8_t col, uint8_t row, uint8_t time, uint8_t reps);
+void measure_middle_keymap_column(uint8_t col, uint8_t time, uint8_t reps, uint16_t result[MATRIX_CAPSENSE_ROWS]);
 void shift_data(uint32_t data, int data_idle, int shcp_idle, int stcp_idle);
 void dac_write_threshold(uint16_t value);
 uint8_t scan_physical_column(uint8_t col, uint16_t time, uint8_t *interference_ptr);
@@ -45,6 +54,8 @@ void save_matrix_calibration(void);
 void calibrate_matrix(void);
 
 extern matrix_row_t assigned_to_threshold[CAPSENSE_CAL_BINS][MATRIX_CAPSENSE_ROWS + 1];
+// The last row of each bin in `assigned_to_threshold` is the mask of columns
+#define ASSIGNED_KEYMAP_COLS_MASK_INDEX (MATRIX_CAPSENSE_ROWS)
 extern uint16_t cal_thresholds[CAPSENSE_CAL_BINS];
 extern uint8_t cal_bin_rows_mask[CAPSENSE_CAL_BINS];
 extern uint8_t cal_bin_key_count[CAPSENSE_CAL_BINS];
@@ -52,6 +63,17 @@ extern uint16_t cal_threshold_min, cal_threshold_max;
 extern uint16_t cal_threshold_offset;
 extern uint8_t cal_flags;
 
+#if CAPSENSE_DRIFT_TRACKING
+// The calibrated level of the keys in each bin (i.e., the threshold at which
+// they stop reading as pressed), and the drift measured from it since then.
+// The drift is added to the threshold of the bin when scanning.
+extern uint16_t cal_bin_level[CAPSENSE_CAL_BINS];
+extern int16_t cal_bin_drift[CAPSENSE_CAL_BINS];
+#define CAPSENSE_DRIFT_SAVE_BIN_SIZE 2
+#else
+#define CAPSENSE_DRIFT_SAVE_BIN_SIZE 0
+#endif
+
 #define CAPSENSE_CAL_FLAG_CALIBRATED    (1 << 0)
 #define CAPSENSE_CAL_FLAG_UNRELIABLE    (1 << 1)
 #define CAPSENSE_CAL_FLAG_SKIPPED       (1 << 2)
@@ -80,7 +102,8 @@ extern uint16_t cal_time;
 //   cal_bin_rows_mask[bin]      uint8_t                        (1 byte)
 //   assigned_to_threshold[bin]  (MATRIX_CAPSENSE_ROWS + 1) * matrix_row_t
 //   cal_bin_key_count[bin]      uint8_t                        (1 byte)
-#define CAPSENSE_CAL_SAVE_BIN_SIZE   (2 + 1 + ((MATRIX_CAPSENSE_ROWS + 1) * MATRIX_ROW_T_SIZE) + 1)
+//   cal_bin_level[bin]          uint16_t (if drift tracking)   (2 bytes)
+#define CAPSENSE_CAL_SAVE_BIN_SIZE   (2 + 1 + ((MATRIX_CAPSENSE_ROWS + 1) * MATRIX_ROW_T_SIZE) + 1 + CAPSENSE_DRIFT_SAVE_BIN_SIZE)
 
 //   cal_threshold_max             uint16_t (2 bytes)
 //   cal_threshold_min             uint16_t (2 bytes)
@@ -98,9 +121,9 @@ extern uint16_t cal_time;
 #define CAPSENSE_CAL_SAVE_TOTAL_SIZE 1
 #endif
 
-#define EECONFIG_CALIBRATION_DATA ((char *) (EECONFIG_KEYMAP_UPPER_BYTE + 1))
+#define QMK_EECONFIG_SIZE (35 + EECONFIG_DEBOUNCE_TUNING_SIZE)
 
-#define QMK_EECONFIG_SIZE 35
+#define EECONFIG_CALIBRATION_DATA ((char *) QMK_EECONFIG_SIZE)
 
 #if EECONFIG_SIZE != QMK_EECONFIG_SIZE
 #error "Update QMK_EECONFIG_SIZE to match EECONFIG_SIZE in eeconfig.h"
@@ -297,6 +297,12 @@
 #ifndef CAPSENSE_CAL_THRESHOLD_OFFSET
 #    error "Please define CAPSENSE_CAL_THRESHOLD_OFFSET in config.h"
 #endif
+#ifndef CAPSENSE_DRIFT_TRACKING
+#    define CAPSENSE_DRIFT_TRACKING 0
+#endif
+#ifndef CAPSENSE_SIGNAL_STREAM
+#    define CAPSENSE_SIGNAL_STREAM 0
+#endif
 
 #if (!defined(CAPSENSE_CONDUCTIVE_PLASTIC_IS_PULLED_UP_ON_KEYPRESS)) && (!defined(CAPSENSE_CONDUCTIVE_PLASTIC_IS_PUSHED_DOWN_ON_KEYPRESS))
 #    error "Please specify whether the flyplate is pushed down or pulled up on keypress!"
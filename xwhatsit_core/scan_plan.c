@@ -0,0 +1,105 @@
+/*
+ * scan_plan.c: The order of scanning the calibrated capsense matrix.
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+#include "scan_plan.h"
+
+#if CAPSENSE_CAL_ENABLED
+
+_Static_assert(SCAN_PLAN_MAX_STEPS <= UINT8_MAX, "Too many scan plan steps");
+
+uint8_t scan_plan_group_count = 0;
+uint16_t scan_plan_threshold[CAPSENSE_CAL_BINS] = { 0 };
+uint8_t scan_plan_group_end[CAPSENSE_CAL_BINS] = { 0 };
+uint8_t scan_plan_col[SCAN_PLAN_MAX_STEPS] = { 0 };
+uint8_t scan_plan_rows[SCAN_PLAN_MAX_STEPS] = { 0 };
+
+/// The threshold of `bin`, including the tracked drift.
+static uint16_t bin_threshold(const uint8_t bin) {
+#if CAPSENSE_DRIFT_TRACKING
+    const int16_t threshold = (int16_t) cal_thresholds[bin] + cal_bin_drift[bin];
+    if (threshold < 0) {
+        return 0;
+    } else if (threshold > CAPSENSE_DAC_MAX) {
+        return CAPSENSE_DAC_MAX;
+    }
+    return (uint16_t) threshold;
+#else
+    return cal_thresholds[bin];
+#endif
+}
+
+void scan_plan_build(void) {
+    uint8_t order[CAPSENSE_CAL_BINS];
+    uint8_t bin_count = 0;
+
+    // Sort the bins that have keys by threshold (normally they already are)
+    for (uint8_t bin = 0; bin < CAPSENSE_CAL_BINS; ++bin) {
+        if (cal_bin_rows_mask[bin] == 0) {
+            continue;
+        }
+        uint8_t i = bin_count++;
+        while (i && bin_threshold(order[i - 1]) > bin_threshold(bin)) {
+            order[i] = order[i - 1];
+            --i;
+        }
+        order[i] = bin;
+    }
+
+    uint8_t steps = 0;
+    uint8_t groups = 0;
+
+    for (uint8_t first = 0, end; first < bin_count; first = end) {
+        const uint16_t threshold = bin_threshold(order[first]);
+
+        // Bins with the same threshold are scanned as one group
+        end = first + 1;
+        while (end < bin_count && bin_threshold(order[end]) == threshold) {
+            ++end;
+        }
+
+        matrix_row_t col_mask = 1;
+        for (uint8_t col = 0; col < MATRIX_COLS; ++col, col_mask <<= 1) {
+            uint8_t physical_rows = 0;
+
+            for (uint8_t i = first; i < end; ++i) {
+                const matrix_row_t *assigned = assigned_to_threshold[order[i]];
+                if (!(assigned[ASSIGNED_KEYMAP_COLS_MASK_INDEX] & col_mask)) {
+                    continue;
+                }
+                for (uint8_t row = 0; row < MATRIX_CAPSENSE_ROWS; ++row) {
+                    if (assigned[row] & col_mask) {
+                        physical_rows |= 1 << CAPSENSE_KEYMAP_ROW_TO_PHYSICAL_ROW(row);
+                    }
+                }
+            }
+
+            if (physical_rows) {
+                scan_plan_col[steps] = col;
+                scan_plan_rows[steps] = physical_rows;
+                ++steps;
+            }
+        }
+
+        if (steps != (groups ? scan_plan_group_end[groups - 1] : 0)) {
+            scan_plan_threshold[groups] = threshold;
+            scan_plan_group_end[groups] = steps;
+            ++groups;
+        }
+    }
+
+    scan_plan_group_count = groups;
+}
+
+#endif
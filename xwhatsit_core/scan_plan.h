@@ -0,0 +1,55 @@
+/*
+ * scan_plan.h: The order of scanning the calibrated capsense matrix.
+ *
+ * With calibration, each key is assigned to a bin, and each bin has its own
+ * DAC threshold. The scan plan is built from the calibration data whenever
+ * it changes, so that scanning does not need to consider bins, columns, or
+ * rows without keys. The bins that have keys are grouped by threshold (bins
+ * with the same threshold are scanned together), and the groups are in order
+ * of ascending threshold. Each step of a group is a column with keys in that
+ * group, and the mask of the physical rows of those keys. The matrix is
+ * scanned one group at a time (i.e., one DAC write per group), alternating
+ * the direction so that the DAC is not rewritten between scans.
+ *
+ * Copyright 2026 Kimmo Kulovesi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef SCAN_PLAN_H
+#define SCAN_PLAN_H
+
+#include <stdint.h>
+
+#if CAPSENSE_CAL_ENABLED
+
+/// The maximum number of steps in the plan, i.e., every column in every bin.
+#define SCAN_PLAN_MAX_STEPS (CAPSENSE_CAL_BINS * MATRIX_COLS)
+
+/// The number of groups in the plan (0 if not calibrated).
+extern uint8_t scan_plan_group_count;
+
+/// The DAC threshold of each group, in ascending order.
+extern uint16_t scan_plan_threshold[CAPSENSE_CAL_BINS];
+
+/// The index of the step after the last step of each group (the first step
+/// of a group is the end of the previous group, or 0).
+extern uint8_t scan_plan_group_end[CAPSENSE_CAL_BINS];
+
+/// The keymap column of each step.
+extern uint8_t scan_plan_col[SCAN_PLAN_MAX_STEPS];
+
+/// The physical rows of the keys of the group in the column of each step.
+extern uint8_t scan_plan_rows[SCAN_PLAN_MAX_STEPS];
+
+/// Build the plan from `assigned_to_threshold`, `cal_thresholds` and
+/// `cal_bin_rows_mask` (and `cal_bin_drift`). This must be called after they
+/// change.
+void scan_plan_build(void);
+
+#endif // ^ CAPSENSE_CAL_ENABLED
+
+#endif
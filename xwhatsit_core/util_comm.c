@@ -67,6 +67,12 @@ bool matrix_scan_custom(matrix_row_t current_matrix[]);
 #include "util_comm.h"
 #include "matrix_manipulate.h"
 #include <string.h>
+#if DEBOUNCE_TUNING
+#include "debounce/debounce_tuning.h"
+#endif
+#ifndef QMK_KEYMAP
+#include "scan_rate.h"
+#endif
 
 bool matrix_scan_custom(matrix_row_t current_matrix[]);
 
@@ -84,6 +90,37 @@ static const uint8_t magic[] = UTIL_COMM_MAGIC;
 
 _Static_assert(sizeof(magic) == 2, "UTIL_COMM_MAGIC should be 2 bytes");
 
+#define STREAM_REPORT_NONE      0
+#define STREAM_REPORT_KEYSTATE  1
+#define STREAM_REPORT_SIGNAL    2
+
+static uint8_t stream_report_requested = STREAM_REPORT_NONE;
+static bool stream_report_made = false;
+static bool send_stream_report(uint8_t type);
+
+static bool keystate_stream_enabled = false;
+static uint16_t keystate_report_rows = 0;
+
+#if CAPSENSE_SIGNAL_STREAM
+// The raw signal stream captures frames of the rows of every column (at the
+// sample time, and just before the column is strobed, i.e., interference)
+// into one buffer while the previous frame is sent from the other.
+static struct {
+    bool enabled;
+    bool captured;
+    bool sending;
+    uint8_t send_buffer;
+    uint8_t send_col;
+    uint8_t sequence;
+    uint8_t time;
+    uint16_t threshold;
+    uint16_t timestamp[2];
+    uint8_t frame[2][MATRIX_COLS * 2];
+} signal_stream;
+
+static uint8_t signal_report_cols = 0;
+#endif
+
 __attribute__((weak))
 uint8_t handle_generic_hid_report(uint8_t report_id, uint8_t count, uint8_t data[static count], uint8_t response_length[static 1], uint8_t response[static *response_length]) {
     const uint8_t response_max = *response_length;
@@ -121,12 +158,13 @@ uint8_t handle_generic_hid_report(uint8_t report_id, uint8_t count, uint8_t data
         case UTIL_COMM_GET_KEYSTATE:
             response[2] = UTIL_COMM_RESPONSE_OK;
             {
-                matrix_row_t current_matrix[MATRIX_ROWS];
-                uint8_t matrix_size = sizeof(current_matrix);
+                // The result of the latest scan, followed by its sequence
+                // number if there is room (not scanned here, so polling this
+                // doesn't affect the scan)
+                uint8_t matrix_size = sizeof(scanned_matrix);
                 uint8_t count = *response_length - 3;
 
-                (void) matrix_scan_custom(current_matrix);
-                char *current_matrix_ptr = (char *)current_matrix;
+                const char *current_matrix_ptr = (const char *)scanned_matrix;
                 uint8_t offset = 0;
                 if (matrix_size > count) {
                     offset = data[3];
@@ -136,6 +174,9 @@ uint8_t handle_generic_hid_report(uint8_t report_id, uint8_t count, uint8_t data
                 count = MIN(count, matrix_size);
                 memcpy(&response[3], current_matrix_ptr, count);
                 *response_length = 3 + count;
+                if (*response_length < response_max) {
+                    response[(*response_length)++] = scanned_matrix_sequence;
+                }
             }
             break;
         case UTIL_COMM_GET_THRESHOLDS:
@@ -219,6 +260,53 @@ uint8_t handle_generic_hid_report(uint8_t report_id, uint8_t count, uint8_t data
                 }
                 break;
             }
+        case UTIL_COMM_GET_SIGNAL_COLUMN:
+            {
+                // data[3] = col, response[3] = rows, response[4..] = value of each row
+                const uint8_t col = data[3];
+                if (col >= MATRIX_COLS) {
+                    response[2] = UTIL_COMM_RESPONSE_ERROR;
+                    *response_length = 3;
+                    break;
+                }
+                uint16_t values[MATRIX_CAPSENSE_ROWS];
+                measure_middle_keymap_column(col, CAPSENSE_HARDCODED_SAMPLE_TIME, 8, values);
+                response[2] = UTIL_COMM_RESPONSE_OK;
+                response[3] = MATRIX_CAPSENSE_ROWS;
+                for (int_fast8_t row = 0; row < MATRIX_CAPSENSE_ROWS; ++row) {
+                    response[4 + row*2] = values[row] & 0xff;
+                    response[4 + row*2 + 1] = (values[row] >> 8) & 0xff;
+                }
+                *response_length = 4 + (MATRIX_CAPSENSE_ROWS * 2);
+                break;
+            }
+        case UTIL_COMM_SET_KEYSTATE_STREAM:
+            // data[3] = enable, response[3] = previous state, [4] = sequence
+            response[2] = UTIL_COMM_RESPONSE_OK;
+            response[3] = keystate_stream_enabled;
+            response[4] = scanned_matrix_sequence;
+            keystate_stream_enabled = data[3] ? true : false;
+            if (keystate_stream_enabled) {
+                // Start the stream with every row
+                scanned_matrix_changed_rows = (uint16_t) ((1UL << MATRIX_ROWS) - 1);
+            }
+            *response_length = 5;
+            break;
+#if CAPSENSE_SIGNAL_STREAM
+        case UTIL_COMM_SET_SIGNAL_STREAM:
+            // data[3] = enable, data[4..5] = threshold, data[6] = sample time
+            // (0 = default), response[3] = previous state, [4] = columns
+            response[2] = UTIL_COMM_RESPONSE_OK;
+            response[3] = signal_stream.enabled;
+            response[4] = MATRIX_COLS;
+            signal_stream.enabled = data[3] ? true : false;
+            signal_stream.threshold = MIN(data[4] | (data[5] << 8), CAPSENSE_DAC_MAX);
+            signal_stream.time = data[6] ? data[6] : CAPSENSE_HARDCODED_SAMPLE_TIME;
+            signal_stream.captured = false;
+            signal_stream.sending = false;
+            *response_length = 5;
+            break;
+#endif
         case UTIL_COMM_GET_KEYBOARD_DETAILS:
             {
                 response[2] = UTIL_COMM_RESPONSE_OK;
@@ -287,6 +375,38 @@ uint8_t handle_generic_hid_report(uint8_t report_id, uint8_t count, uint8_t data
                 *response_length = 4;
                 break;
             }
+#ifndef QMK_KEYMAP
+        case UTIL_COMM_GET_SCAN_RATE:
+            // response[3..] = the scan rate statistics (see scan_rate.h)
+            response[2] = UTIL_COMM_RESPONSE_OK;
+            *response_length = 3 + scan_rate_read_stats(&response[3]);
+            break;
+#endif
+#if DEBOUNCE_TUNING
+        case UTIL_COMM_GET_DEBOUNCE_TUNING:
+            {
+                // data[3] = offset in the per-key time table
+                response[2] = UTIL_COMM_RESPONSE_OK;
+                response[3] = debounce_tuning_mode();
+                response[4] = DEBOUNCE;
+                response[5] = DEBOUNCE_TUNING_TABLE_SIZE;
+                response[6] = debounce_tuning_read_table(data[3], response_max - 7, &response[7]);
+                *response_length = 7 + response[6];
+                break;
+            }
+        case UTIL_COMM_SET_DEBOUNCE_TUNING:
+            {
+                // data[3] = mode, data[4] = row (0xFF = none), data[5] = col, data[6] = ms
+                response[2] = UTIL_COMM_RESPONSE_OK;
+                debounce_tuning_set_mode(data[3]);
+                if (data[4] < MATRIX_ROWS && data[5] < MATRIX_COLS) {
+                    debounce_tuning_set_key_time((data[4] * MATRIX_COLS) + data[5], data[6]);
+                }
+                response[3] = debounce_tuning_mode();
+                *response_length = 4;
+                break;
+            }
+#endif
         default:
             return RESPONSE_ERROR;
     }
@@ -297,6 +417,136 @@ uint8_t handle_generic_hid_report(uint8_t report_id, uint8_t count, uint8_t data
     return RESPONSE_SEND_REPLY;
 }
 
+static uint8_t make_keystate_report(uint8_t count, uint8_t report[static count]) {
+    uint8_t first_row = 0;
+    while (!(scanned_matrix_changed_rows & (((uint16_t) 1) << first_row))) {
+        ++first_row;
+    }
+    const uint8_t row_count = MIN((count - 6) / MATRIX_ROW_T_SIZE, MATRIX_ROWS - first_row);
+
+    report[2] = UTIL_COMM_RESPONSE_KEYSTATE;
+    report[3] = scanned_matrix_sequence;
+    report[4] = first_row;
+    report[5] = row_count;
+    memcpy(&report[6], &scanned_matrix[first_row], row_count * MATRIX_ROW_T_SIZE);
+    keystate_report_rows = (uint16_t) (((1UL << row_count) - 1) << first_row);
+    return 6 + (row_count * MATRIX_ROW_T_SIZE);
+}
+
+#if CAPSENSE_SIGNAL_STREAM
+static uint8_t make_signal_report(uint8_t count, uint8_t report[static count]) {
+    const uint8_t first_col = signal_stream.send_col;
+    const uint8_t col_count = MIN((count - 8) / 2, MATRIX_COLS - first_col);
+    const uint16_t timestamp = signal_stream.timestamp[signal_stream.send_buffer];
+
+    report[2] = UTIL_COMM_RESPONSE_SIGNAL;
+    report[3] = signal_stream.sequence;
+    report[4] = timestamp & 0xff;
+    report[5] = (timestamp >> 8) & 0xff;
+    report[6] = first_col;
+    report[7] = col_count;
+    memcpy(&report[8], &signal_stream.frame[signal_stream.send_buffer][first_col * 2], col_count * 2);
+    signal_report_cols = col_count;
+    return 8 + (col_count * 2);
+}
+
+/// Capture a frame into the buffer not being sent.
+static void capture_signal_frame(void) {
+    uint8_t *frame = signal_stream.frame[signal_stream.send_buffer ^ 1];
+
+    dac_write_threshold(signal_stream.threshold);
+    for (int_fast8_t col = 0; col < MATRIX_COLS; ++col) {
+        uint8_t interference;
+        *frame++ = scan_physical_column(CAPSENSE_KEYMAP_COL_TO_PHYSICAL_COL(col), signal_stream.time, &interference);
+        *frame++ = interference;
+    }
+    signal_stream.timestamp[signal_stream.send_buffer ^ 1] = timer_read();
+    signal_stream.captured = true;
+}
+
+static void signal_stream_task(void) {
+    if (!signal_stream.captured) {
+        capture_signal_frame();
+    }
+    if (!signal_stream.sending) {
+        // Send the captured frame, and capture the next one while sending
+        signal_stream.send_buffer ^= 1;
+        signal_stream.send_col = 0;
+        signal_stream.sending = true;
+        signal_stream.captured = false;
+        ++signal_stream.sequence;
+        capture_signal_frame();
+    }
+
+    signal_report_cols = 0;
+    if (send_stream_report(STREAM_REPORT_SIGNAL)) {
+        signal_stream.send_col += signal_report_cols;
+        if (signal_stream.send_col >= MATRIX_COLS) {
+            signal_stream.sending = false;
+        }
+    }
+}
+#endif
+
+bool util_comm_make_report(uint8_t count, uint8_t report[static count]) {
+    if (!stream_report_requested || count < 8 + MATRIX_ROW_T_SIZE) {
+        return false;
+    }
+    uint8_t length;
+    memcpy(report, magic, sizeof(magic));
+#if CAPSENSE_SIGNAL_STREAM
+    if (stream_report_requested == STREAM_REPORT_SIGNAL) {
+        length = make_signal_report(count, report);
+    } else
+#endif
+    {
+        length = make_keystate_report(count, report);
+    }
+    for (uint8_t i = length; i < count; ++i) {
+        report[i] = 0;
+    }
+    stream_report_made = true;
+    return true;
+}
+
+/// Send a stream report of `type`, returns `true` iff it was sent.
+static bool send_stream_report(uint8_t type) {
+    stream_report_requested = type;
+    stream_report_made = false;
+#ifdef QMK_KEYMAP
+    uint8_t report[RAW_EPSIZE];
+    if (util_comm_make_report(sizeof(report), report)) {
+        raw_hid_send(report, sizeof(report));
+    }
+#else
+    // If a reply is pending, it is sent first and this on the next call
+    if (!make_and_send_generic_hid_report()) {
+        stream_report_made = false;
+    }
+#endif
+    stream_report_requested = STREAM_REPORT_NONE;
+    return stream_report_made;
+}
+
+void util_comm_task(void) {
+#if CAPSENSE_SIGNAL_STREAM
+    if (signal_stream.enabled) {
+#ifndef QMK_KEYMAP
+        // Stream at the active scan rate
+        scan_rate_wake();
+#endif
+        signal_stream_task();
+    }
+#endif
+    if (keystate_stream_enabled && scanned_matrix_changed_rows) {
+        // Only clear the rows once they have been sent, otherwise they are
+        // sent again on the next call
+        if (send_stream_report(STREAM_REPORT_KEYSTATE)) {
+            scanned_matrix_changed_rows &= ~keystate_report_rows;
+        }
+    }
+}
+
 #ifdef QMK_KEYMAP
 void raw_hid_receive(uint8_t *data, uint8_t length) {
     uint8_t generic_report[RAW_EPSIZE];
@@ -19,7 +19,7 @@
 
 #define UTIL_COMM_VERSION_MAJOR 2
 #define UTIL_COMM_VERSION_MID 0
-#define UTIL_COMM_VERSION_MINOR 5
+#define UTIL_COMM_VERSION_MINOR 10
 
 
 #define UTIL_COMM_MAGIC { 0x55, 0xAA }
@@ -39,11 +39,49 @@ enum command {
     UTIL_COMM_SET_DAC_VALUE,
     UTIL_COMM_GET_ROW_STATE,
     UTIL_COMM_SHIFT_DATA_EXT,
+    UTIL_COMM_GET_DEBOUNCE_TUNING,
+    UTIL_COMM_SET_DEBOUNCE_TUNING,
+    UTIL_COMM_GET_SIGNAL_COLUMN,
+    // Continued after the responses, so that a command never has the same
+    // value as a response
+    UTIL_COMM_SET_KEYSTATE_STREAM = 0x30,
+    UTIL_COMM_SET_SIGNAL_STREAM,
+    UTIL_COMM_GET_SCAN_RATE,
 };
 
 enum response {
     UTIL_COMM_RESPONSE_OK = 0x22,
-    UTIL_COMM_RESPONSE_ERROR
+    UTIL_COMM_RESPONSE_ERROR,
+    UTIL_COMM_RESPONSE_KEYSTATE,
+    UTIL_COMM_RESPONSE_SIGNAL
 };
 
+_Static_assert(UTIL_COMM_GET_SIGNAL_COLUMN < UTIL_COMM_RESPONSE_OK,
+               "util_comm commands overlap the responses");
+_Static_assert(UTIL_COMM_SET_KEYSTATE_STREAM > UTIL_COMM_RESPONSE_SIGNAL,
+               "util_comm commands overlap the responses");
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// While the keystate stream is enabled (UTIL_COMM_SET_KEYSTATE_STREAM), the
+// rows that change are sent on the generic HID endpoint without a request:
+// [0..1] = magic, [2] = UTIL_COMM_RESPONSE_KEYSTATE, [3] = sequence number
+// (as in UTIL_COMM_GET_KEYSTATE), [4] = first row, [5] = number of rows,
+// [6..] = the rows.
+//
+// While the raw signal stream is enabled (UTIL_COMM_SET_SIGNAL_STREAM, only
+// with CAPSENSE_SIGNAL_STREAM), frames of every column are captured at the
+// given threshold and sent as fast as possible: [0..1] = magic,
+// [2] = UTIL_COMM_RESPONSE_SIGNAL, [3] = frame sequence number,
+// [4..5] = frame timestamp (ms), [6] = first column, [7] = number of columns,
+// [8..] = for each column the physical rows at the sample time, and the
+// physical rows before the column was strobed (interference).
+//
+// This must be called periodically to send the streams.
+void util_comm_task(void);
+
+// Called by `make_generic_hid_report` to make the stream reports.
+bool util_comm_make_report(uint8_t count, uint8_t report[static count]);
+
 #endif
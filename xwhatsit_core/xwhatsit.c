@@ -26,12 +26,24 @@ extern bool keyboard_scan_enabled;
 #include <generic_hid.h>
 
 #if ENABLE_GENERIC_HID_ENDPOINT
+#include "util_comm.h"
+
 bool
 make_generic_hid_report (uint8_t report_id, uint8_t count, uint8_t report[static count]) {
-    return false;
+    return util_comm_make_report(count, report);
 }
 #endif
 
+void matrix_scan_user(void);
+
+void
+matrix_scan_kb (void) {
+#if ENABLE_GENERIC_HID_ENDPOINT
+    util_comm_task();
+#endif
+    matrix_scan_user();
+}
+
 void
 eeconfig_init_kb (void) {
     clear_saved_matrix_calibration();
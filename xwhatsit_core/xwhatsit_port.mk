@@ -20,13 +20,22 @@ endif
 
 COMMON_HEADERS += post_config.h xwhatsit_port.h
 
-DEVICE_OBJS ?= xwhatsit.o matrix.o $(QMK_CORE_OBJS) util_comm.o
+DEVICE_OBJS ?= xwhatsit.o matrix.o scan_plan.o $(QMK_CORE_OBJS) util_comm.o
+
+ifeq (1,$(CAPSENSE_DRIFT_TRACKING))
+DEVICE_FLAGS += -DCAPSENSE_DRIFT_TRACKING=1
+endif
+
+ifeq (1,$(CAPSENSE_SIGNAL_STREAM))
+DEVICE_FLAGS += -DCAPSENSE_SIGNAL_STREAM=1
+endif
 
 ifeq (1,$(ERASE_CALIBRATION))
 DEVICE_FLAGS += -DERASE_CALIBRATION_ON_START=1 -DCAPSENSE_CAL_VERSION=0
 endif
 
-$(BUILDDIR)/matrix.o: qmk_port.h progmem.h matrix_manipulate.h eeconfig.h $(COMMON_HEADERS)
-$(BUILDDIR)/util_comm.o: util_comm.h matrix_manipulate.h $(COMMON_HEADERS)
-$(BUILDDIR)/xwhatsit.o: led.h generic_hid.h
+$(BUILDDIR)/matrix.o: qmk_port.h progmem.h matrix_manipulate.h scan_plan.h eeconfig.h $(COMMON_HEADERS)
+$(BUILDDIR)/scan_plan.o: scan_plan.h matrix_manipulate.h $(COMMON_HEADERS)
+$(BUILDDIR)/util_comm.o: util_comm.h matrix_manipulate.h scan_rate.h $(COMMON_HEADERS)
+$(BUILDDIR)/xwhatsit.o: led.h generic_hid.h util_comm.h
 $(BUILDDIR)/keymap.o: keymap.h config.h usb_keys.h $(XWHATSIT_CONTROLLER).h